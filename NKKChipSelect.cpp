@@ -0,0 +1,348 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+
+#include <NKKChipSelect.h>
+
+//MCP23S17 registers (IOCON.BANK = 0) and opcode
+#define MCP23S17_IODIRA 0x00
+#define MCP23S17_IOCON 0x0A
+#define MCP23S17_OLATA 0x14
+#define MCP23S17_IOCON_HAEN 0x08
+#define MCP23S17_Opcode(address) (0x40 | ((address) << 1))
+
+/******************************************************************************/
+/* 74HC595 chain                                                              */
+/******************************************************************************/
+
+/**************************************************************************/
+/*!
+    @brief  Constructor for NKK_ChipSelect595 object, the chain is shifted over the SPI bus.
+    @param  latchpin Pin connected to RCLK of all chips.
+	@param  numChips Number of chips in the chain, 8 lines per chip.
+	@param  SPI_A SPI object, MOSI is connected to SER of chip 0 and SCK to SRCLK of all chips.
+	@param  freqSPI SPI frequency in Hz.
+	@return NKK_ChipSelect595 object.
+    @note   Call the object's begin() function before use.
+*/
+/**************************************************************************/
+NKK_ChipSelect595::NKK_ChipSelect595(uint8_t latchpin, uint8_t numChips, SPIClass *SPI_A, uint32_t freqSPI)
+{
+ _SPI = SPI_A;
+ _spiSetting = new SPISettings(freqSPI, MSBFIRST, SPI_MODE0); //74HC595 shifts on the rising edge of the clock
+ _latch = latchpin;
+ _numChips = numChips;
+ _lines = new byte[_numChips];
+ _latched = new byte[_numChips];
+ memset(_lines, 0xFF, _numChips);
+ memset(_latched, 0xFF, _numChips);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Constructor for NKK_ChipSelect595 object, the chain is shifted over own pins.
+    @param  datapin Pin connected to SER of chip 0.
+	@param  clkpin Pin connected to SRCLK of all chips.
+    @param  latchpin Pin connected to RCLK of all chips.
+	@param  numChips Number of chips in the chain, 8 lines per chip.
+	@return NKK_ChipSelect595 object.
+    @note   Call the object's begin() function before use.
+*/
+/**************************************************************************/
+NKK_ChipSelect595::NKK_ChipSelect595(uint8_t datapin, uint8_t clkpin, uint8_t latchpin, uint8_t numChips)
+{
+ _data = datapin;
+ _clk = clkpin;
+ _latch = latchpin;
+ _numChips = numChips;
+ _lines = new byte[_numChips];
+ _latched = new byte[_numChips];
+ memset(_lines, 0xFF, _numChips);
+ memset(_latched, 0xFF, _numChips);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Destructor for NKK_ChipSelect595 object.
+*/
+/**************************************************************************/
+NKK_ChipSelect595::~NKK_ChipSelect595(void) {
+  delete[] _lines;
+  delete[] _latched;
+  delete _spiSetting;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Setups the pins and deselects all lines.
+*/
+/**************************************************************************/
+void NKK_ChipSelect595::begin(void) {
+
+  pinMode(_latch, OUTPUT);
+  digitalWrite(_latch, LOW);
+  if (_SPI) {
+    _SPI->begin();
+  }
+  else {
+    pinMode(_data, OUTPUT);
+    pinMode(_clk, OUTPUT);
+    digitalWrite(_clk, LOW);
+  }
+
+  memset(_lines, 0xFF, _numChips);
+  _isDirty = false;
+  shift();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the level of a line, sent to the chips by update().
+    @param  line Line number, 0 to getNumLines()-1. Other lines are ignored.
+	@param  level LOW (selected) or HIGH.
+*/
+/**************************************************************************/
+void NKK_ChipSelect595::write(uint16_t line, uint8_t level) {
+  if (line >= getNumLines()) {
+    return;
+  }
+  byte bit = 1 << (line % 8);
+  if (level == LOW) {
+    _lines[line / 8] &= ~bit;
+  }
+  else {
+    _lines[line / 8] |= bit;
+  }
+  _isDirty = true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Shifts and latches the lines if any of them has changed since the last update.
+*/
+/**************************************************************************/
+void NKK_ChipSelect595::update(void) {
+  if (!_isDirty) {
+    return;
+  }
+  _isDirty = false;
+  if (memcmp(_lines, _latched, _numChips) != 0) {
+    shift();
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the number of lines.
+    @return 8 lines per chip.
+*/
+/**************************************************************************/
+uint16_t NKK_ChipSelect595::getNumLines(void) {
+  return (uint16_t) _numChips * 8;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the SPI object the chain is shifted over.
+    @return SPI object, NULL if the chain is shifted over own pins.
+*/
+/**************************************************************************/
+SPIClass *NKK_ChipSelect595::getSPI(void) {
+  return _SPI;
+}
+
+//Shifts all chips, the last one first and Q7 first, then latches the outputs
+void NKK_ChipSelect595::shift(void)
+{
+ if (_SPI) {
+   _SPI->beginTransaction(*_spiSetting);
+   for (uint8_t c = _numChips; c > 0; c--) {
+     _SPI->transfer(_lines[c-1]);
+   }
+   _SPI->endTransaction();
+ }
+ else {
+   for (uint8_t c = _numChips; c > 0; c--) {
+     shiftOut(_data, _clk, MSBFIRST, _lines[c-1]);
+   }
+ }
+ digitalWrite(_latch, HIGH); //rising edge - shift registers are copied to the outputs
+ digitalWrite(_latch, LOW);
+ memcpy(_latched, _lines, _numChips);
+}
+
+/******************************************************************************/
+/* MCP23S17 expanders                                                         */
+/******************************************************************************/
+
+/**************************************************************************/
+/*!
+    @brief  Constructor for NKK_ChipSelectMCP23S17 object.
+    @param  cspin Pin connected to CS of all chips.
+	@param  numChips Number of chips with the hardware addresses 1 to numChips, up to 7. 16 lines per chip.
+	@param  SPI_A SPI object the chips are connected to, usually the one of the keys.
+	@param  freqSPI SPI frequency in Hz.
+	@return NKK_ChipSelectMCP23S17 object.
+    @note   Call the object's begin() function before use.
+*/
+/**************************************************************************/
+NKK_ChipSelectMCP23S17::NKK_ChipSelectMCP23S17(uint8_t cspin, uint8_t numChips, SPIClass *SPI_A, uint32_t freqSPI)
+{
+ _SPI = SPI_A;
+ _spiSetting = new SPISettings(freqSPI, MSBFIRST, SPI_MODE0); //MCP23S17 supports SPI_MODE0 and SPI_MODE3
+ _cs = cspin;
+ if (numChips > NKK_ChipSelectMCP23S17_MaxChips) {_numChips = NKK_ChipSelectMCP23S17_MaxChips;} else {_numChips = numChips;}
+ memset(_lines, 0xFF, sizeof(_lines));
+ memset(_latched, 0xFF, sizeof(_latched));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Destructor for NKK_ChipSelectMCP23S17 object.
+*/
+/**************************************************************************/
+NKK_ChipSelectMCP23S17::~NKK_ChipSelectMCP23S17(void) {
+  delete _spiSetting;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Enables the hardware addresses, deselects all lines and switches the pins to outputs.
+	@note   The first write goes to the hardware address 0 (opcode 0x40, the NKK Set RGB command) while the pins are still inputs: 
+	        the Slave Select lines need pull-ups, or begin() of the keys shall follow to reset them (see NKKChipSelect.h).
+*/
+/**************************************************************************/
+void NKK_ChipSelectMCP23S17::begin(void) {
+  const byte high[2] = {0xFF, 0xFF};
+  const byte output[2] = {0x00, 0x00};
+  const byte iocon = MCP23S17_IOCON_HAEN;
+
+  pinMode(_cs, OUTPUT);
+  digitalWrite(_cs, HIGH);
+  _SPI->begin();
+
+  //all chips respond to the address 0 until the hardware addresses are enabled
+  writeRegisters(MCP23S17_Opcode(0), MCP23S17_IOCON, &iocon, 1);
+  for (uint8_t c = 0; c < _numChips; c++) {
+    writeRegisters(MCP23S17_Opcode(c + 1), MCP23S17_OLATA, high, 2); //latches first, so the pins come up high
+    writeRegisters(MCP23S17_Opcode(c + 1), MCP23S17_IODIRA, output, 2);
+  }
+  memset(_lines, 0xFF, sizeof(_lines));
+  memset(_latched, 0xFF, sizeof(_latched));
+  _isDirty = false;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the level of a line, sent to the chips by update().
+    @param  line Line number, 0 to getNumLines()-1. Other lines are ignored.
+	@param  level LOW (selected) or HIGH.
+*/
+/**************************************************************************/
+void NKK_ChipSelectMCP23S17::write(uint16_t line, uint8_t level) {
+  if (line >= getNumLines()) {
+    return;
+  }
+  byte bit = 1 << (line % 8);
+  if (level == LOW) {
+    _lines[line / 8] &= ~bit;
+  }
+  else {
+    _lines[line / 8] |= bit;
+  }
+  _isDirty = true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Writes the output latches which have changed since the last update. Lines going high are written first (all chips), 
+	        lines going low last, so no expander traffic follows the selection of a key.
+	@note   Lines going low in one update shall be in one group (port, see getGroup()): the keys of the port written first would 
+	        receive the bytes which write the next one.
+*/
+/**************************************************************************/
+void NKK_ChipSelectMCP23S17::update(void) {
+  if (!_isDirty) {
+    return;
+  }
+  _isDirty = false;
+  for (uint8_t c = 0; c < _numChips; c++) {
+    writePorts(c, true);
+  }
+  for (uint8_t c = 0; c < _numChips; c++) {
+    writePorts(c, false);
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the number of lines.
+    @return 16 lines per chip.
+*/
+/**************************************************************************/
+uint16_t NKK_ChipSelectMCP23S17::getNumLines(void) {
+  return (uint16_t) _numChips * 16;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the SPI object the chips are connected to.
+    @return SPI object.
+*/
+/**************************************************************************/
+SPIClass *NKK_ChipSelectMCP23S17::getSPI(void) {
+  return _SPI;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the group of a line, the lines of a group can be selected together.
+    @param  line Line number.
+    @return Port of the line (2 per chip), an output latch is written at once.
+*/
+/**************************************************************************/
+uint16_t NKK_ChipSelectMCP23S17::getGroup(uint16_t line) {
+  return line / 8;
+}
+
+//Writes the ports of a chip which differ from the latches, only the lines going high (isDeselect) or all of them. 
+//Both ports in one transfer if both have changed
+void NKK_ChipSelectMCP23S17::writePorts(uint8_t chip, bool isDeselect)
+{
+ uint8_t a = 2 * chip;
+ byte ports[2];
+ for (uint8_t p = 0; p < 2; p++) {
+   ports[p] = isDeselect ? (_latched[a + p] | _lines[a + p]) : _lines[a + p];
+ }
+ bool isA = ports[0] != _latched[a];
+ bool isB = ports[1] != _latched[a + 1];
+ if (isA) {
+   writeRegisters(MCP23S17_Opcode(chip + 1), MCP23S17_OLATA, ports, isB ? 2 : 1);
+ }
+ else if (isB) {
+   writeRegisters(MCP23S17_Opcode(chip + 1), MCP23S17_OLATA + 1, &ports[1], 1);
+ }
+ _latched[a] = ports[0];
+ _latched[a + 1] = ports[1];
+}
+
+//Writes consecutive registers of a chip in one transfer (IOCON.SEQOP = 0 - the address is incremented)
+void NKK_ChipSelectMCP23S17::writeRegisters(uint8_t opcode, byte reg, const byte data[], uint8_t length)
+{
+ _SPI->beginTransaction(*_spiSetting);
+ digitalWrite(_cs, LOW);
+ _SPI->transfer(opcode);
+ _SPI->transfer(reg);
+ for (uint8_t i = 0; i < length; i++) {
+   _SPI->transfer(data[i]);
+ }
+ digitalWrite(_cs, HIGH);
+ _SPI->endTransaction();
+}
@@ -0,0 +1,148 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*********************************************************************
+Slave Select (Chip Select) providers for NKK LCD 64x32 SmartDisplay
+
+By default every key drives its own cspin pin, so the number of keys is limited by the free
+pins of the board. A provider drives the Slave Select lines of many keys through a few pins:
+ - NKK_ChipSelect595      74HC595 shift register chain, 8 lines per chip. Shifted over own
+                          data/clock pins or over the SPI bus of the keys, latched by one pin.
+ - NKK_ChipSelectMCP23S17 MCP23S17 SPI I/O expanders on the SPI bus of the keys, 16 lines per
+                          chip, up to 7 chips sharing one CS pin (hardware addresses 1..7).
+A key is assigned to a line with NKK_SmartDisplayLCD::setChipSelect(). Call begin() of the
+provider before begin() of the keys.
+
+The providers cache the latched state of the lines. Levels are written by write() and sent
+to the hardware by update(): nothing is sent if no line has changed, an expander writes only
+the ports which have changed (3 bytes for a key). An update() sends the lines going high
+first and the lines going low last, so a key is selected after all other traffic of the update.
+
+Lines of a group (getGroup()) go low at the same time. The lines of a chain of 74HC595 are one
+group, they are latched together. An MCP23S17 changes its outputs register by register, so a
+group is a port (8 lines): a key selected by OLATA would receive the bytes which write OLATB
+before its own command. A broadcast selects its keys group by group, one transfer per group.
+
+Sharing the SPI bus of the keys: a line is deselected while its key is still selected, so
+that key also receives the bytes which deselect it. NKK devices ignore a command which is not
+complete when Slave Select goes high (NKK application notes), and the bytes are harmless:
+ - 74HC595 - all lines are high after a deselect, so the key receives 0xFF bytes only.
+ - MCP23S17 - the key receives the opcode, the register and 0xFF. The opcode of the hardware
+   address 0 (0x40) is the NKK Set RGB command, so the addresses start at 1.
+   Exception - begin(): the IOCON write which enables the hardware addresses has to use the
+   address 0, and the expander pins are still inputs (IODIR after reset), so Slave Select of
+   the keys floats. Pull the Slave Select line of every key up (e.g. 10k to VCC), it also keeps
+   the keys deselected from power up to begin(). Without pull-ups a key may take the write as a
+   Set RGB command: call begin() of the keys after begin() of the provider, their Reset
+   command clears it.
+Shift registers on own data/clock pins do not touch the SPI bus at all.
+*********************************************************************/
+#ifndef _NKK_ChipSelect_H_
+#define _NKK_ChipSelect_H_
+
+#include <SPI.h>
+
+#define NKK_ChipSelectMCP23S17_MaxChips 7
+
+/**************************************************************************/
+/*!
+    @brief  Interface of a Slave Select provider - drives the Slave Select lines of several NKK devices.
+*/
+/**************************************************************************/
+class NKK_ChipSelect {
+
+public:
+  virtual ~NKK_ChipSelect(void) {}
+
+//Setups the hardware, all lines high (deselected)
+  virtual void begin(void) = 0;
+//Sets the level of a line, sent to the hardware by update()
+  virtual void write(uint16_t line, uint8_t level) = 0;
+//Sends the lines changed since the last update() to the hardware, nothing if none has changed
+  virtual void update(void) = 0;
+//Number of lines
+  virtual uint16_t getNumLines(void) = 0;
+//SPI object the lines are sent over, NULL if the provider does not use an SPI object
+  virtual SPIClass *getSPI(void) = 0;
+//Group of a line - lines of a group can go low in one update() with no traffic on the bus after the first of them goes low
+  virtual uint16_t getGroup(uint16_t line) { (void) line; return 0; }
+};
+
+/**************************************************************************/
+/*!
+    @brief  Slave Select provider with a chain of 74HC595 shift registers. Line n is output Qn%8 of chip n/8, chip 0 is connected to the board.
+*/
+/**************************************************************************/
+class NKK_ChipSelect595 : public NKK_ChipSelect {
+
+public:
+//Shifted over the SPI bus (MOSI to SER, SCK to SRCLK)
+NKK_ChipSelect595(uint8_t latchpin, uint8_t numChips, SPIClass *SPI_A=&SPI, uint32_t freqSPI=1000000);
+//Shifted over own pins
+NKK_ChipSelect595(uint8_t datapin, uint8_t clkpin, uint8_t latchpin, uint8_t numChips);
+~NKK_ChipSelect595(void);
+//Not copyable - the object owns the line buffers and the SPI settings
+NKK_ChipSelect595(const NKK_ChipSelect595&) = delete;
+NKK_ChipSelect595& operator=(const NKK_ChipSelect595&) = delete;
+
+  void begin(void);
+  void write(uint16_t line, uint8_t level);
+  void update(void);
+  uint16_t getNumLines(void);
+  SPIClass *getSPI(void);
+
+private:
+SPIClass *_SPI = NULL;    //NULL - own data/clock pins
+SPISettings *_spiSetting = NULL;
+uint8_t _data = 0;
+uint8_t _clk = 0;
+uint8_t _latch;
+uint8_t _numChips;
+byte *_lines = NULL;      //levels written, a byte per chip
+byte *_latched = NULL;    //levels in the output latches
+bool _isDirty = false;
+
+   void shift(void);
+};
+
+/**************************************************************************/
+/*!
+    @brief  Slave Select provider with MCP23S17 I/O expanders. Line n is pin n%16 of chip n/16 (GPA0..7, GPB0..7), chip c has the hardware address c+1.
+*/
+/**************************************************************************/
+class NKK_ChipSelectMCP23S17 : public NKK_ChipSelect {
+
+public:
+NKK_ChipSelectMCP23S17(uint8_t cspin, uint8_t numChips=1, SPIClass *SPI_A=&SPI, uint32_t freqSPI=1000000);
+~NKK_ChipSelectMCP23S17(void);
+//Not copyable - the object owns the SPI settings
+NKK_ChipSelectMCP23S17(const NKK_ChipSelectMCP23S17&) = delete;
+NKK_ChipSelectMCP23S17& operator=(const NKK_ChipSelectMCP23S17&) = delete;
+
+  void begin(void);
+  void write(uint16_t line, uint8_t level);
+  void update(void);
+  uint16_t getNumLines(void);
+  SPIClass *getSPI(void);
+  uint16_t getGroup(uint16_t line);
+
+private:
+SPIClass *_SPI;
+SPISettings *_spiSetting;
+uint8_t _cs;
+uint8_t _numChips;
+byte _lines[NKK_ChipSelectMCP23S17_MaxChips * 2];    //levels written, OLATA and OLATB per chip
+byte _latched[NKK_ChipSelectMCP23S17_MaxChips * 2];  //levels in the output latches
+bool _isDirty = false;
+
+   void writePorts(uint8_t chip, bool isDeselect);
+   void writeRegisters(uint8_t opcode, byte reg, const byte data[], uint8_t length);
+};
+#endif // _NKK_ChipSelect_H_
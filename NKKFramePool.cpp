@@ -0,0 +1,245 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+
+#include <NKKFramePool.h>
+
+/**************************************************************************/
+/*!
+    @brief  Constructor for NKK_FramePool object.
+    @param  numFrames Number of frames the pool can hold.
+	@param  frameLength Frame size in bytes, getImageBufferLength() of the keys (256 bytes for 64*32).
+	@return NKK_FramePool object.
+    @note   The pool holds no frames if the memory cannot be allocated, add() returns -1.
+*/
+/**************************************************************************/
+NKK_FramePool::NKK_FramePool(uint8_t numFrames, uint16_t frameLength)
+{
+ _frameLength = frameLength;
+ _frames = (byte *) malloc((uint32_t) numFrames * frameLength);
+ _refCounts = (uint8_t *) malloc(numFrames);
+ _hashes = (uint32_t *) malloc(numFrames * sizeof(uint32_t));
+ if (_frames != NULL && _refCounts != NULL && _hashes != NULL) {
+   _numFrames = numFrames;
+   memset(_refCounts, 0, numFrames);
+ }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Destructor for NKK_FramePool object.
+    @note   Keys attached to the pool frames shall be detached (or destroyed) first.
+*/
+/**************************************************************************/
+NKK_FramePool::~NKK_FramePool(void) {
+  free(_frames);
+  free(_refCounts);
+  free(_hashes);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Adds a frame to the pool. If an identical frame is pooled already, adds a reference to it instead of a copy.
+    @param  frame[] A frame in NKK native format, frameLength bytes.
+	@param  isPROGMEM true - frame[] is in PROGMEM, e.g. an icon.
+	@return Index of the pooled frame, -1 if the frame is new and the pool is full (or a frame has 255 references).
+	@note   Every add() shall be balanced by release() when the frame is not needed any more, keys attached to the frame keep their own references.
+*/
+/**************************************************************************/
+int16_t NKK_FramePool::add(const byte frame[], bool isPROGMEM) {
+  uint32_t h = hash(frame, isPROGMEM);
+  int16_t freeSlot = -1;
+  for (uint8_t i = 0; i < _numFrames; i++) {
+    if (_refCounts[i] == 0) {
+      if (freeSlot < 0) {freeSlot = i;}
+    }
+    else if (_hashes[i] == h && isEqual(i, frame, isPROGMEM)) {
+      if (_refCounts[i] == 255) {
+        return -1;
+      }
+      _refCounts[i]++;
+      return i;
+    }
+  }
+  if (freeSlot < 0) {
+    return -1;
+  }
+  byte *slot = _frames + (uint32_t) freeSlot * _frameLength;
+  if (isPROGMEM) {
+    memcpy_P(slot, frame, _frameLength);
+  }
+  else {
+    memcpy(slot, frame, _frameLength);
+  }
+  _hashes[freeSlot] = h;
+  _refCounts[freeSlot] = 1;
+  return freeSlot;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Finds a pooled frame identical to a frame, no reference is added.
+    @param  frame[] A frame in NKK native format, frameLength bytes.
+	@param  isPROGMEM true - frame[] is in PROGMEM.
+	@return Index of the pooled frame, -1 if none.
+*/
+/**************************************************************************/
+int16_t NKK_FramePool::find(const byte frame[], bool isPROGMEM) {
+  uint32_t h = hash(frame, isPROGMEM);
+  for (uint8_t i = 0; i < _numFrames; i++) {
+    if (_refCounts[i] != 0 && _hashes[i] == h && isEqual(i, frame, isPROGMEM)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Releases a reference to a pooled frame, the frame slot is freed with the last reference.
+    @param  index Index of the pooled frame.
+*/
+/**************************************************************************/
+void NKK_FramePool::release(int16_t index) {
+  if (isValid(index)) {
+    _refCounts[index]--;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Makes a key use a pooled frame as its imageBufferNKK[] (attachImageBufferNKK()) and adds a reference to the frame.
+	        The pooled frame the key used before (if any) is released, an own buffer of the key is freed.
+    @param  key A reference (pointer) to NKK_SmartDisplayLCD object.
+    @param  index Index of the pooled frame.
+	@return false if the frame is not in the pool, has 255 references or frameLength is shorter than getImageBufferLength() of the key.
+	@note   Upload the frame with display_NKK(). The frame is shared, a function of the key which changes imageBufferNKK[] 
+	        gives the key its own copy first (see setSingleBuffer()).
+*/
+/**************************************************************************/
+bool NKK_FramePool::attach(NKK_SmartDisplayLCD *key, int16_t index) {
+  if (!isValid(index) || _refCounts[index] == 255) {
+    return false;
+  }
+  int16_t previous = getIndex(key);
+  if (previous == index) {
+    return true;
+  }
+  //releases the previous frame
+  if (!key->attachImageBufferNKK(_frames + (uint32_t) index * _frameLength, _frameLength)) {
+    return false;
+  }
+  _refCounts[index]++;
+  key->_sharedRefCount = &_refCounts[index];
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gives a key its own imageBufferNKK[] again, with a copy of the pooled frame it used, and releases the frame.
+    @param  key A reference (pointer) to NKK_SmartDisplayLCD object.
+	@return false if the own buffer cannot be allocated (the key stays attached), true otherwise (also if the key is not attached).
+*/
+/**************************************************************************/
+bool NKK_FramePool::detach(NKK_SmartDisplayLCD *key) {
+  if (getIndex(key) < 0) {
+    return true;
+  }
+  return key->unshareImageBufferNKK();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the pooled frame a key uses as its imageBufferNKK[].
+    @param  key A reference (pointer) to NKK_SmartDisplayLCD object.
+	@return Index of the pooled frame, -1 if the key is not attached to the pool.
+*/
+/**************************************************************************/
+int16_t NKK_FramePool::getIndex(NKK_SmartDisplayLCD *key) {
+  byte *buffer = key->imageBufferNKK;
+  if (_numFrames == 0 || key->_sharedRefCount == NULL || buffer < _frames || buffer >= _frames + (uint32_t) _numFrames * _frameLength) {
+    return -1;
+  }
+  uint32_t offset = buffer - _frames;
+  if (offset % _frameLength != 0) {
+    return -1;
+  }
+  return offset / _frameLength;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets a pooled frame.
+    @param  index Index of the pooled frame.
+	@return The frame in NKK native format, NULL if the slot is free.
+*/
+/**************************************************************************/
+const byte *NKK_FramePool::getFrame(int16_t index) {
+  if (!isValid(index)) {
+    return NULL;
+  }
+  return _frames + (uint32_t) index * _frameLength;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the number of references (add() and attached keys) to a frame.
+    @param  index Index of the pooled frame.
+	@return Number of references, 0 - a free slot.
+*/
+/**************************************************************************/
+uint8_t NKK_FramePool::getRefCount(int16_t index) {
+  if (index < 0 || index >= _numFrames) {
+    return 0;
+  }
+  return _refCounts[index];
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the number of free frame slots.
+	@return Number of free slots.
+*/
+/**************************************************************************/
+uint8_t NKK_FramePool::getNumFree(void) {
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < _numFrames; i++) {
+    if (_refCounts[i] == 0) {n++;}
+  }
+  return n;
+}
+
+//A pooled frame with at least one reference
+bool NKK_FramePool::isValid(int16_t index) {
+  return index >= 0 && index < _numFrames && _refCounts[index] != 0;
+}
+
+//Byte compare of a pooled frame and a frame
+bool NKK_FramePool::isEqual(int16_t index, const byte frame[], bool isPROGMEM) {
+  const byte *slot = _frames + (uint32_t) index * _frameLength;
+  if (!isPROGMEM) {
+    return memcmp(slot, frame, _frameLength) == 0;
+  }
+  for (uint16_t i = 0; i < _frameLength; i++) {
+    if (slot[i] != pgm_read_byte(frame + i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// FNV-1a hash of a frame
+uint32_t NKK_FramePool::hash(const byte frame[], bool isPROGMEM) {
+  uint32_t h = 2166136261UL;
+  for (uint16_t i = 0; i < _frameLength; i++) {
+    h = (h ^ (isPROGMEM ? pgm_read_byte(frame + i) : frame[i])) * 16777619UL;
+  }
+  return h;
+}
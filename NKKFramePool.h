@@ -0,0 +1,76 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*********************************************************************
+Frame pool for NKK LCD 64x32 SmartDisplay
+
+On a panel many keys show one of a few identical icons. The pool keeps one copy of every
+different frame in NKK native format and lets keys use it as their imageBufferNKK[]:
+ - add() finds a frame by its content (FNV-1a hash, then a byte compare), an identical
+   frame is stored once and only its reference count grows.
+ - attach() points imageBufferNKK[] of a key to a pooled frame (attachImageBufferNKK()),
+   so switching a key to a pooled frame costs no conversion, no copy and no RAM.
+   display_NKK() uploads it.
+ - A frame is freed when its last reference (add() or attach()) is released.
+Pooled frames are shared and read only. Functions of the key which change imageBufferNKK[] (display(),
+convertGFX2NKK(), clear/invert/scroll, drawing in NKK format, setSingleBuffer(false)) copy the frame into
+an own buffer of the key first and release it (copy on write). Call setSingleBuffer(false) before writing
+imageBufferNKK[] of an attached key directly. A key releases its frame when it is destroyed.
+*********************************************************************/
+#ifndef _NKK_FramePool_H_
+#define _NKK_FramePool_H_
+
+#include <NKKSmartDisplayLCD.h>
+
+/**************************************************************************/
+/*!
+    @brief  Class that stores NKK native frames once per content, reference counted, and attaches them to NKK_SmartDisplayLCD objects.
+*/
+/**************************************************************************/
+class NKK_FramePool {
+
+public:
+NKK_FramePool(uint8_t numFrames, uint16_t frameLength=256);
+~NKK_FramePool(void);
+//Not copyable - the object owns the frames the keys point to
+NKK_FramePool(const NKK_FramePool&) = delete;
+NKK_FramePool& operator=(const NKK_FramePool&) = delete;
+
+//Adds a frame (frameLength bytes in NKK native format) or a reference to an identical pooled frame.
+//Returns the frame index, -1 if the pool is full. Call release() when the reference is not needed.
+  int16_t add(const byte frame[], bool isPROGMEM=false);
+//Index of a pooled frame identical to frame[], -1 if none. No reference is added
+  int16_t find(const byte frame[], bool isPROGMEM=false);
+//Releases a reference, the frame is freed with its last reference
+  void release(int16_t index);
+//Points imageBufferNKK[] of a key to a pooled frame and adds a reference, the frame the key used before is released.
+//Returns false if the frame is not in the pool or its length is shorter than the key image.
+  bool attach(NKK_SmartDisplayLCD *key, int16_t index);
+//Gives a key its own imageBufferNKK[] again with a copy of the pooled frame, releases the frame. Returns false if the own buffer cannot be allocated
+  bool detach(NKK_SmartDisplayLCD *key);
+//Index of the pooled frame a key uses, -1 if none
+  int16_t getIndex(NKK_SmartDisplayLCD *key);
+
+  const byte *getFrame(int16_t index);
+  uint8_t getRefCount(int16_t index);
+  uint8_t getNumFree(void);
+
+private:
+byte *_frames = NULL;     //numFrames*frameLength bytes
+uint8_t *_refCounts = NULL; //0 - a free slot
+uint32_t *_hashes = NULL;
+uint8_t _numFrames = 0;
+uint16_t _frameLength;
+
+  bool isValid(int16_t index);
+  bool isEqual(int16_t index, const byte frame[], bool isPROGMEM);
+  uint32_t hash(const byte frame[], bool isPROGMEM);
+};
+#endif // _NKK_FramePool_H_
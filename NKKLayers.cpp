@@ -0,0 +1,335 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+
+#include <NKKLayers.h>
+
+/**************************************************************************/
+/*!
+    @brief  Constructor for NKK_Layers object.
+    @param  key A reference (pointer) to NKK_SmartDisplayLCD object, its imageBufferNKK[] holds the composed image.
+	@return NKK_Layers object.
+*/
+/**************************************************************************/
+NKK_Layers::NKK_Layers(NKK_SmartDisplayLCD *key)
+{
+ _key = key;
+ for (uint8_t i = 0; i < NKK_Layers_MaxOverlays; i++) {
+   _overlays[i].bitmap = NULL;
+   _overlays[i].isVisible = false;
+   _overlays[i].isDirty = false;
+   _overlays[i].isComposed = false;
+ }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Destructor for NKK_Layers object.
+*/
+/**************************************************************************/
+NKK_Layers::~NKK_Layers(void) {
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the background image. The whole image is recomposed by the next commit().
+    @param  background[] Image in NKK native format for the current width, height and rotation of the key, getImageBufferLength() bytes.
+	        Not copied, shall stay valid. NULL - blank background.
+	@param  isPROGMEM true - the background is in PROGMEM.
+*/
+/**************************************************************************/
+void NKK_Layers::setBackground(const byte background[], bool isPROGMEM) {
+  _background = background;
+  _isBackgroundPROGMEM = isPROGMEM;
+  _isAllDirty = true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets an overlay. The overlay is visible.
+    @param  layer Overlay number, 0..NKK_Layers_MaxOverlays-1. Overlays are composed in the order of their numbers.
+	@param  bitmap 1 bit bitmap, LSB first rows. Not copied, shall stay valid. NULL removes the overlay.
+	@param  x Top left corner x coordinate.
+	@param  y Top left corner y coordinate.
+	@param  rop Raster operation with the image below, NKKblit_Copy, NKKblit_Or, NKKblit_And, NKKblit_Xor or NKKblit_AndNot.
+	@return false if the layer number is out of range.
+*/
+/**************************************************************************/
+bool NKK_Layers::setOverlay(uint8_t layer, const NKKsurface *bitmap, int16_t x, int16_t y, uint8_t rop) {
+  if (layer >= NKK_Layers_MaxOverlays) {
+    return false;
+  }
+  Overlay *overlay = &_overlays[layer];
+  overlay->bitmap = bitmap;
+  overlay->x = x;
+  overlay->y = y;
+  overlay->rop = rop;
+  overlay->isVisible = true;
+  overlay->isDirty = true;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Moves an overlay.
+    @param  layer Overlay number.
+	@param  x Top left corner x coordinate.
+	@param  y Top left corner y coordinate.
+	@return false if the layer number is out of range.
+*/
+/**************************************************************************/
+bool NKK_Layers::moveOverlay(uint8_t layer, int16_t x, int16_t y) {
+  if (layer >= NKK_Layers_MaxOverlays) {
+    return false;
+  }
+  Overlay *overlay = &_overlays[layer];
+  if (overlay->x != x || overlay->y != y) {
+    overlay->x = x;
+    overlay->y = y;
+    overlay->isDirty = true;
+  }
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Shows or hides an overlay.
+    @param  layer Overlay number.
+	@param  isVisible true - show, false - hide.
+	@return false if the layer number is out of range.
+*/
+/**************************************************************************/
+bool NKK_Layers::showOverlay(uint8_t layer, bool isVisible) {
+  if (layer >= NKK_Layers_MaxOverlays) {
+    return false;
+  }
+  Overlay *overlay = &_overlays[layer];
+  if (overlay->isVisible != isVisible) {
+    overlay->isVisible = isVisible;
+    overlay->isDirty = true;
+  }
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Marks an overlay as changed, call it after the overlay bitmap has been drawn.
+    @param  layer Overlay number.
+	@return false if the layer number is out of range.
+*/
+/**************************************************************************/
+bool NKK_Layers::invalidateOverlay(uint8_t layer) {
+  if (layer >= NKK_Layers_MaxOverlays) {
+    return false;
+  }
+  _overlays[layer].isDirty = true;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Recomposes the changed regions into imageBufferNKK[] (see compose()) and uploads the image with display_NKK().
+    @return true if the image has been uploaded, false if nothing changed or imageBufferNKK cannot be allocated.
+*/
+/**************************************************************************/
+bool NKK_Layers::commit(void) {
+  if (compose() == 0) {
+    return false;
+  }
+  _key->display_NKK();
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Recomposes the changed regions into imageBufferNKK[]. A region of an overlay is its old and new rectangle, the background
+	        of the region is copied back and all visible overlays are stamped into it. The whole image is recomposed after setBackground().
+    @return Number of regions recomposed, 0 - nothing changed or imageBufferNKK cannot be allocated.
+	@note   A key in the single buffer mode is switched to double buffer, the whole image is composed.
+*/
+/**************************************************************************/
+uint8_t NKK_Layers::compose(void) {
+  if (_key->imageBufferNKK == NULL) {
+    //single buffer mode - the composed image needs imageBufferNKK, it is allocated and composed as a whole
+    if (!_key->setSingleBuffer(false)) {
+      return 0;
+    }
+    _isAllDirty = true;
+  }
+  else if (!_key->setSingleBuffer(false)) {
+    return 0; //no RAM for a copy of a shared (NKK_FramePool) image
+  }
+  uint8_t regions = 0;
+  if (_isAllDirty) {
+    for (uint8_t i = 0; i < NKK_Layers_MaxOverlays; i++) {
+      _overlays[i].isDirty = true; //updates the composed rectangles, their regions are in the image
+    }
+  }
+  for (uint8_t i = 0; i < NKK_Layers_MaxOverlays; i++) {
+    Overlay *overlay = &_overlays[i];
+    if (!overlay->isDirty) {
+      continue;
+    }
+    overlay->isDirty = false;
+    int16_t x0 = 0x7FFF, y0 = 0x7FFF, x1 = -0x7FFF, y1 = -0x7FFF; //region, x1 and y1 are exclusive
+    if (overlay->isComposed) {
+      x0 = overlay->composedX;
+      y0 = overlay->composedY;
+      x1 = x0 + overlay->composedW;
+      y1 = y0 + overlay->composedH;
+    }
+    overlay->isComposed = (overlay->isVisible && overlay->bitmap != NULL);
+    if (overlay->isComposed) {
+      overlay->composedX = overlay->x;
+      overlay->composedY = overlay->y;
+      overlay->composedW = overlay->bitmap->w;
+      overlay->composedH = overlay->bitmap->h;
+      x0 = min(x0, overlay->x);
+      y0 = min(y0, overlay->y);
+      x1 = max(x1, (int16_t) (overlay->x + overlay->bitmap->w));
+      y1 = max(y1, (int16_t) (overlay->y + overlay->bitmap->h));
+    }
+    if (!_isAllDirty && x0 < x1 && y0 < y1) {
+      composeRect(x0, y0, x1 - x0, y1 - y0);
+      regions++;
+    }
+  }
+  if (_isAllDirty) {
+    composeRect(0, 0, _key->getWidth(), _key->getHeigth());
+    _isAllDirty = false;
+    regions++;
+  }
+  return regions;
+}
+
+//Copies the background of a rectangle back into imageBufferNKK[] and stamps the visible overlays into it. The rectangle is extended
+//to whole bytes of NKK lines (rows in Landscape, columns in Portrait), the overlays are clipped to the extended rectangle.
+void NKK_Layers::composeRect(int16_t x, int16_t y, int16_t w, int16_t h) {
+  int16_t imageW = _key->getWidth();
+  int16_t imageH = _key->getHeigth();
+  if (x < 0) {w += x; x = 0;}
+  if (y < 0) {h += y; y = 0;}
+  if (x + w > imageW) {w = imageW - x;}
+  if (y + h > imageH) {h = imageH - y;}
+  if (w <= 0 || h <= 0) {
+    return;
+  }
+  bool isLandscape = (imageW >= imageH);
+  uint8_t lineBytes = isLandscape ? imageW/8 : imageH/8;
+  uint16_t line0, line1;
+  uint8_t byte0, byte1;
+  if (isLandscape) {
+    //a row is a big endian number, pixel x is bit x%8 of byte lineBytes-1-x/8
+    line0 = y;
+    line1 = y + h;
+    byte0 = lineBytes - 1 - (x + w - 1)/8;
+    byte1 = lineBytes - x/8;
+  }
+  else {
+    //a column, pixel y is bit 7-y%8 of byte y/8
+    line0 = x;
+    line1 = x + w;
+    byte0 = y/8;
+    byte1 = (y + h - 1)/8 + 1;
+  }
+
+  for (uint16_t line = line0; line < line1; line++) {
+    byte *target = _key->imageBufferNKK + line*lineBytes;
+    uint16_t offset = line*lineBytes;
+    for (uint8_t b = byte0; b < byte1; b++) {
+      if (_background == NULL) {
+        target[b] = 0;
+      }
+      else {
+        target[b] = _isBackgroundPROGMEM ? pgm_read_byte(_background + offset + b) : _background[offset + b];
+      }
+    }
+  }
+  for (uint8_t i = 0; i < NKK_Layers_MaxOverlays; i++) {
+    if (_overlays[i].isVisible && _overlays[i].bitmap != NULL) {
+      stampOverlay(&_overlays[i], line0, line1, byte0, byte1);
+    }
+  }
+}
+
+//Stamps the lines line0..line1-1 of an overlay into imageBufferNKK[], 8 pixels at a time, only bytes byte0..byte1-1 of the lines are changed.
+//Landscape: bytes of an overlay row are LSB first as NKK rows. Portrait: 8 pixels of an overlay column are gathered MSB first.
+void NKK_Layers::stampOverlay(Overlay *overlay, uint16_t line0, uint16_t line1, uint8_t byte0, uint8_t byte1) {
+  const NKKsurface *bitmap = overlay->bitmap;
+  bool isLandscape = (_key->getWidth() >= _key->getHeigth());
+  uint8_t lineBytes = isLandscape ? _key->getWidth()/8 : _key->getHeigth()/8;
+  int16_t first = isLandscape ? overlay->y : overlay->x; //overlay lines and the position along them
+  int16_t pos = isLandscape ? overlay->x : overlay->y;
+  uint16_t numLines = isLandscape ? bitmap->h : bitmap->w;
+  uint16_t length = isLandscape ? bitmap->w : bitmap->h;
+
+  for (int32_t line = max((int32_t) line0, (int32_t) first); line < min((int32_t) line1, (int32_t) first + numLines); line++) {
+    byte *target = _key->imageBufferNKK + line*lineBytes;
+    uint16_t l = line - first;
+    for (uint16_t p = 0; p < length; p += 8) {
+      uint8_t n = (length - p < 8) ? length - p : 8;
+      byte bits = 0;
+      byte mask;
+      if (isLandscape) {
+        bits = bitmap->buffer[l*bitmap->stride + p/8];
+        mask = (n == 8) ? 0xFF : (1 << n) - 1;
+      }
+      else {
+        mask = (byte) (0xFF << (8 - n));
+        for (uint8_t i = 0; i < n; i++) {
+          if ((bitmap->buffer[(p + i)*bitmap->stride + l/8] >> (l & 7)) & 1) {
+            bits |= 0x80 >> i;
+          }
+        }
+      }
+      stampBits(target, lineBytes, pos + p, bits, mask, overlay->rop, byte0, byte1);
+    }
+  }
+}
+
+//Combines 8 pixels (the pixels set in mask) starting at pixel pos of an NKK line with bits by a raster operation, only bytes byte0..byte1-1
+//are changed. Pixel i of bits is pixel pos+i - bit i in Landscape (LSB first), bit 7-i in Portrait (MSB first), as NKK_SmartDisplayLCD::stampByteNKK().
+void NKK_Layers::stampBits(byte line[], uint8_t lineBytes, int16_t pos, byte bits, byte mask, uint8_t rop, uint8_t byte0, uint8_t byte1) {
+  if (pos <= -8 || pos >= 8*lineBytes) {
+    return;
+  }
+  int16_t index = (pos + 8) / 8 - 1; //rounded down for negative pos
+  uint8_t shift = pos - 8*index;
+  bool isLandscape = (_key->getWidth() >= _key->getHeigth());
+
+  for (uint8_t part = 0; part < 2; part++, index++) {
+    byte b, m;
+    if (isLandscape) {
+      b = part ? ((shift) ? bits >> (8 - shift) : 0) : bits << shift;
+      m = part ? ((shift) ? mask >> (8 - shift) : 0) : mask << shift;
+    }
+    else {
+      b = part ? ((shift) ? bits << (8 - shift) : 0) : bits >> shift;
+      m = part ? ((shift) ? mask << (8 - shift) : 0) : mask >> shift;
+    }
+    if (m == 0 || index < 0 || index >= lineBytes) {
+      continue;
+    }
+    uint8_t i = isLandscape ? lineBytes - 1 - index : index;
+    if (i < byte0 || i >= byte1) {
+      continue;
+    }
+    byte d = line[i];
+    byte r;
+    switch (rop) {
+      case NKKblit_Or:     r = d | b;  break;
+      case NKKblit_And:    r = d & b;  break;
+      case NKKblit_Xor:    r = d ^ b;  break;
+      case NKKblit_AndNot: r = d & ~b; break;
+      default:             r = b;      break;
+    }
+    line[i] = (d & ~m) | (r & m);
+  }
+}
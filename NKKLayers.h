@@ -0,0 +1,86 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*********************************************************************
+Layered composition for NKK LCD 64x32 SmartDisplay
+
+A key image is often a static frame or icon plus a small changing element. Layers keep
+them apart so the static part is never drawn or converted again:
+ - Background - a full image in NKK native format (for the current width, height and rotation),
+   in RAM or PROGMEM, e.g. made with the NKK Bitmap builder or convertGFX2NKK() once.
+ - Overlays - small 1 bit bitmaps (NKKsurface, LSB first rows as XBM) with a position and a
+   raster operation, composed over the background in the order of their numbers.
+imageBufferNKK[] of the key holds the composed image. commit() recomposes only the regions
+of the overlays which moved, were shown, hidden or changed (the old and the new place):
+the background bytes of a region are copied back and the overlays are stamped into it in
+NKK native format, then the image is uploaded.
+*********************************************************************/
+#ifndef _NKK_Layers_H_
+#define _NKK_Layers_H_
+
+#include <NKKSmartDisplayLCD.h>
+#include <nkkblit.h>
+
+#define NKK_Layers_MaxOverlays 4
+
+/**************************************************************************/
+/*!
+    @brief  Class that composes a static background in NKK native format and overlays into imageBufferNKK[] of an NKK_SmartDisplayLCD object,
+	        recomposing only the regions which changed.
+*/
+/**************************************************************************/
+class NKK_Layers {
+
+public:
+NKK_Layers(NKK_SmartDisplayLCD *key);
+~NKK_Layers(void);
+
+//Background in NKK native format, getImageBufferLength() bytes, not copied (shall stay valid). NULL - blank background.
+//The whole image is recomposed by the next commit().
+  void setBackground(const byte background[], bool isPROGMEM=false);
+//Overlays 0..NKK_Layers_MaxOverlays-1, drawn in this order. The bitmap is not copied (shall stay valid), NULL removes the overlay.
+//rop - NKKblit_Copy, NKKblit_Or, NKKblit_And, NKKblit_Xor or NKKblit_AndNot. Return false if the layer number is out of range.
+  bool setOverlay(uint8_t layer, const NKKsurface *bitmap, int16_t x, int16_t y, uint8_t rop=NKKblit_Or);
+  bool moveOverlay(uint8_t layer, int16_t x, int16_t y);
+  bool showOverlay(uint8_t layer, bool isVisible);
+  //The overlay bitmap has been changed
+  bool invalidateOverlay(uint8_t layer);
+//Recomposes the changed regions into imageBufferNKK[] and uploads the image (display_NKK()) if anything changed.
+//Returns false if nothing changed or imageBufferNKK cannot be allocated (single buffer mode is switched off).
+  bool commit(void);
+//Recomposes the changed regions without the upload, returns the number of regions recomposed
+  uint8_t compose(void);
+
+private:
+NKK_SmartDisplayLCD *_key;
+const byte *_background = NULL;
+bool _isBackgroundPROGMEM = false;
+bool _isAllDirty = true; //the whole image shall be recomposed
+
+struct Overlay {
+  const NKKsurface *bitmap; // NULL - no overlay
+  int16_t x;                // position
+  int16_t y;
+  uint8_t rop;
+  bool isVisible;
+  bool isDirty;             // moved, shown, hidden or changed since it was composed
+  bool isComposed;          // it is in the image, at the composed rectangle
+  int16_t composedX;        // rectangle where it has been composed
+  int16_t composedY;
+  uint16_t composedW;
+  uint16_t composedH;
+};
+Overlay _overlays[NKK_Layers_MaxOverlays];
+
+   void composeRect(int16_t x, int16_t y, int16_t w, int16_t h);
+   void stampOverlay(Overlay *overlay, uint16_t line0, uint16_t line1, uint8_t byte0, uint8_t byte1);
+   void stampBits(byte line[], uint8_t lineBytes, int16_t pos, byte bits, byte mask, uint8_t rop, uint8_t byte0, uint8_t byte1);
+};
+#endif // _NKK_Layers_H_
@@ -0,0 +1,338 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+
+#include <NKKMultiBus.h>
+
+//Image upload command, image, colour and brightness commands
+#define NKK_MultiBus_FrameOverhead 5
+
+/**************************************************************************/
+/*!
+    @brief  Constructor for NKK_MultiBus object.
+    @param  keys[] Keys to upload, bound to any of the SPI objects. The array is copied.
+	@param  numKeys Number of elements in keys[], up to 32.
+	@return NKK_MultiBus object.
+    @note   Call begin() of the keys and then begin() of this object before use.
+*/
+/**************************************************************************/
+NKK_MultiBus::NKK_MultiBus(NKK_SmartDisplayLCD *keys[], uint8_t numKeys)
+{
+ if (numKeys > NKK_MultiBus_MaxKeys) {_numKeys = NKK_MultiBus_MaxKeys;} else {_numKeys = numKeys;}
+ for (uint8_t k = 0; k < _numKeys; k++) {
+   _keys[k] = keys[k];
+   _keyBus[k] = NKK_MultiBus_MaxBuses;
+ }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Destructor for NKK_MultiBus object.
+*/
+/**************************************************************************/
+NKK_MultiBus::~NKK_MultiBus(void) {
+}
+
+/**************************************************************************/
+/*!
+    @brief  Groups the keys by their SPI objects, a bus per SPI object.
+	@return false if the keys use more than NKK_MultiBus_MaxBuses SPI objects, keys of the other SPI objects are not uploaded.
+*/
+/**************************************************************************/
+bool NKK_MultiBus::begin(void) {
+  bool isOk = true;
+
+  _numBuses = 0;
+  for (uint8_t k = 0; k < _numKeys; k++) {
+    NKK_SmartDisplayLCD *key = _keys[k];
+    uint8_t b = 0;
+    _keyBus[k] = NKK_MultiBus_MaxBuses;
+    if (key == NULL) {
+      continue;
+    }
+    while (b < _numBuses && _buses[b].SPI_A != key->_SPI) {
+      b++;
+    }
+    if (b == _numBuses) {
+      if (_numBuses == NKK_MultiBus_MaxBuses) {
+        isOk = false;
+        continue;
+      }
+      _buses[b].SPI_A = key->_SPI;
+      _buses[b].freq = key->_freqSPI;
+      _buses[b].numKeys = 0;
+      _numBuses++;
+    }
+    _buses[b].keys[_buses[b].numKeys++] = k;
+    _keyBus[k] = b;
+  }
+  return isOk;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns the number of buses (SPI objects) in use
+	@return Number of buses
+*/
+/**************************************************************************/
+uint8_t NKK_MultiBus::getNumBuses(void) {
+return _numBuses;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns the bus of a key
+	@param  k Index of the key in keys[]
+	@return Bus index, NKK_MultiBus_MaxBuses if the key is not handled
+*/
+/**************************************************************************/
+uint8_t NKK_MultiBus::getBus(uint8_t k) {
+  if (k >= _numKeys) {
+    return NKK_MultiBus_MaxBuses;
+  }
+  return _keyBus[k];
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns the time of a frame of all keys on a bus - image, colour and brightness - at the SPI frequency of the bus
+	@param  bus Bus index
+	@return Time in microseconds, without Slave Select and transaction overhead
+*/
+/**************************************************************************/
+uint32_t NKK_MultiBus::getBusLoad(uint8_t bus) {
+  if (bus >= _numBuses || _buses[bus].freq == 0) {
+    return 0;
+  }
+  uint32_t bytes = 0;
+  for (uint8_t i = 0; i < _buses[bus].numKeys; i++) {
+    bytes += getFrameLength(_keys[_buses[bus].keys[i]]);
+  }
+  return (uint32_t) ((uint64_t) bytes * 8000000 / _buses[bus].freq);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns true if the buses are fed concurrently, false if the keys are uploaded one after another
+	@return Interleaved transfer flag
+*/
+/**************************************************************************/
+bool NKK_MultiBus::isInterleaved(void) {
+#if defined(NKK_MultiBus_Interleaved)
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**************************************************************************/
+/*!
+    @brief  Displays pictures in GFX format i.e. converts imageBufferGFX of the keys to NKK format and uploads them as display_NKK().
+	@param  mask Keys to upload, bit k is keys[k].
+	@return Number of keys uploaded.
+*/
+/**************************************************************************/
+uint8_t NKK_MultiBus::display(uint32_t mask) {
+
+  for (uint8_t k = 0; k < _numKeys; k++) {
+    if ((mask & ((uint32_t) 1 << k)) && _keys[k] != NULL && _keys[k]->imageBufferNKK != NULL) {
+      _keys[k]->convertGFX2NKK();
+    }
+  }
+  return display_NKK(mask);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Displays pictures in NKK format i.e. uploads imageBufferNKK of the keys, all buses at once, and sets colour and brightness
+	        as per each key's variables.
+	@param  mask Keys to upload, bit k is keys[k].
+	@return Number of keys uploaded.
+	@note   imageBufferNKK of the keys is not changed. Keys in the single buffer mode are uploaded from imageBufferGFX.
+*/
+/**************************************************************************/
+uint8_t NKK_MultiBus::display_NKK(uint32_t mask) {
+  uint8_t count = 0;
+
+#if defined(NKK_MultiBus_Interleaved)
+  uint8_t order[NKK_MultiBus_MaxBuses];
+  uint8_t numActive = 0;
+
+  for (uint8_t b = 0; b < _numBuses; b++) {
+    Bus *bus = &_buses[b];
+    bus->remaining = 0;
+    for (uint8_t i = 0; i < bus->numKeys; i++) {
+      if ((mask & ((uint32_t) 1 << bus->keys[i])) && hasImage(_keys[bus->keys[i]])) {
+        bus->remaining += getFrameLength(_keys[bus->keys[i]]);
+      }
+    }
+    bus->next = 0;
+    if (startKey(bus, mask)) {
+      order[numActive++] = b;
+      count++;
+    }
+  }
+
+  //a byte to every bus whose transmit register is empty, the most loaded bus first. A bus whose key has got its last byte 
+  //is polled until the byte has left the bus, the other buses are fed meanwhile
+  sortBuses(order, numActive);
+  while (numActive > 0) {
+    for (uint8_t i = 0; i < numActive; i++) {
+      Bus *bus = &_buses[order[i]];
+      spi_dev *dev = bus->SPI_A->dev();
+      if (!spi_is_tx_empty(dev)) {
+        continue;
+      }
+      if (bus->pos < bus->split) {
+        spi_tx_reg(dev, getFrameByte(bus->key, bus->pos));
+        bus->pos++;
+        bus->remaining--;
+        continue;
+      }
+      if (spi_is_busy(dev)) {
+        continue;
+      }
+      if (bus->pos < bus->length) {
+        nextCommand(bus);
+        continue;
+      }
+      finishKey(bus);
+      if (startKey(bus, mask)) {
+        count++;
+      }
+      else {
+        numActive--;
+        order[i] = order[numActive];
+      }
+      sortBuses(order, numActive);
+      break;
+    }
+  }
+#else
+  //no register access - one key after another
+  for (uint8_t k = 0; k < _numKeys; k++) {
+    if ((mask & ((uint32_t) 1 << k)) && _keyBus[k] < NKK_MultiBus_MaxBuses && hasImage(_keys[k])) {
+      _keys[k]->display_NKK();
+      count++;
+    }
+  }
+#endif
+  return count;
+}
+
+//Checks if a key has an image to send, a key without buffers (no RAM in its constructor) is skipped
+bool NKK_MultiBus::hasImage(NKK_SmartDisplayLCD *key)
+{
+ return key->imageBufferNKK != NULL || key->imageBufferGFX != NULL;
+}
+
+
+//Number of bytes sent to a key by display_NKK()
+uint16_t NKK_MultiBus::getFrameLength(NKK_SmartDisplayLCD *key)
+{
+ return key->_imageBufferLength + NKK_MultiBus_FrameOverhead;
+}
+
+#if defined(NKK_MultiBus_Interleaved)
+
+//Selects the next key of the bus in mask and starts its transaction, returns false if there is none
+bool NKK_MultiBus::startKey(Bus *bus, uint32_t mask)
+{
+ while (bus->next < bus->numKeys) {
+   uint8_t k = bus->keys[bus->next++];
+   if (!(mask & ((uint32_t) 1 << k)) || !hasImage(_keys[k])) {
+     continue;
+   }
+   NKK_SmartDisplayLCD *key = _keys[k];
+   key->bkgColour = key->bkgColour | 0x03; // apply masks, save settings into the key variables
+   key->bkgBrightnes = key->bkgBrightnes | 0x1F;
+   key->writeCS(LOW); // enable Slave Select
+   key->beginTransaction();
+   bus->key = key;
+   bus->pos = 0;
+   bus->length = getFrameLength(key);
+   bus->split = key->_isCSPerCommand ? key->_imageBufferLength + 1 : bus->length;
+   return true;
+ }
+ bus->key = NULL;
+ return false;
+}
+
+
+//Ends the transaction of the key, its last byte has left the bus (transmit register empty and the bus not busy, checked by the caller)
+void NKK_MultiBus::finishKey(Bus *bus)
+{
+ spi_dev *dev = bus->SPI_A->dev();
+ spi_rx_reg(dev); //received bytes are not used, reading DR and then SR clears the overrun flag
+ spi_is_rx_nonempty(dev);
+ bus->key->endTransaction();
+ bus->key->writeCS(HIGH); // disable Slave Select
+}
+
+
+//Starts a Slave Select session for the next command of the key, the previous command has left the bus (checked by the caller). 
+//Set RGB and Set Brightness are 2 bytes each
+void NKK_MultiBus::nextCommand(Bus *bus)
+{
+ spi_dev *dev = bus->SPI_A->dev();
+ spi_rx_reg(dev); //received bytes are not used
+ spi_is_rx_nonempty(dev);
+ bus->key->endTransaction();
+ bus->key->writeCS(HIGH); // disable Slave Select
+ bus->key->writeCS(LOW); // enable Slave Select
+ bus->key->beginTransaction();
+ bus->split = bus->pos + 2;
+}
+
+
+//Byte pos of the upload of a key - Image Upload command, the image (rotated 180 degrees and converted from GFX on the fly if needed),
+//Set RGB and Set Brightness commands
+byte NKK_MultiBus::getFrameByte(NKK_SmartDisplayLCD *key, uint16_t pos)
+{
+ uint16_t length = key->_imageBufferLength;
+ if (pos == 0) {
+   return NKK_SmartDisplayLCD_Img_Upload;
+ }
+ pos--;
+ if (pos < length) {
+   uint16_t n = key->_isRotate180 ? length - 1 - pos : pos;
+   byte b;
+   if (key->imageBufferNKK == NULL) {
+     b = key->convertByteGFX2NKK(key->imageBufferGFX, n); //single buffer mode
+   }
+   else {
+     b = key->imageBufferNKK[n];
+   }
+   return key->_isRotate180 ? key->reverseByte(b) : b;
+ }
+ switch (pos - length) {
+   case 0:  return NKK_SmartDisplayLCD_Set_RGB;
+   case 1:  return key->bkgColour;
+   case 2:  return NKK_SmartDisplayLCD_Set_Bright;
+   default: return key->bkgBrightnes;
+ }
+}
+
+
+//Sorts the active buses by the time left (bytes / SPI frequency), the longest first
+void NKK_MultiBus::sortBuses(uint8_t order[], uint8_t numBuses)
+{
+ for (uint8_t i = 1; i < numBuses; i++) {
+   uint8_t b = order[i];
+   uint8_t j = i;
+   while (j > 0 && (uint64_t) _buses[b].remaining * _buses[order[j-1]].freq > (uint64_t) _buses[order[j-1]].remaining * _buses[b].freq) {
+     order[j] = order[j-1];
+     j--;
+   }
+   order[j] = b;
+ }
+}
+
+#endif
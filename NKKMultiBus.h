@@ -0,0 +1,100 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*********************************************************************
+Multi-bus dispatch for NKK LCD 64x32 SmartDisplay
+
+Boards such as the Maple Mini have several SPI peripherals (SPI1, SPI2). Keys are spread over
+them by wiring - each NKK_SmartDisplayLCD object is bound to the SPI object of its bus - and
+this object uploads the keys of all buses at the same time:
+ - begin() groups the keys by their SPI object, a bus per SPI object.
+ - display_NKK() runs one upload (image, colour and brightness) per bus at a time and feeds
+   the transmit registers of all buses in turn, a byte whenever a register is empty, so the
+   buses shift concurrently. Buses with more time left (bytes / SPI frequency) are fed first,
+   so the buses finish together and a frame takes the time of the most loaded bus.
+ - getBusLoad() gives the time of a frame per bus, wire the keys so the loads are equal.
+The interleaved transfer needs register access to the SPI peripherals, provided for the
+Arduino STM32 core (libmaple, __STM32F1__). Other cores upload the keys one after another
+with display_NKK() of each key.
+Slave Select providers (NKKChipSelect.h) shall use own pins or the SPI object of their keys.
+*********************************************************************/
+#ifndef _NKK_MultiBus_H_
+#define _NKK_MultiBus_H_
+
+#include <NKKSmartDisplayLCD.h>
+
+#define NKK_MultiBus_MaxKeys 32
+#define NKK_MultiBus_MaxBuses 4
+
+//Non-blocking access to the transmit registers
+#if defined(__STM32F1__)
+  #define NKK_MultiBus_Interleaved
+#endif
+
+/**************************************************************************/
+/*!
+    @brief  Class that uploads NKK_SmartDisplayLCD objects bound to several SPI objects (buses) concurrently.
+*/
+/**************************************************************************/
+class NKK_MultiBus {
+
+public:
+//keys[] - keys on any of the buses, the array is copied. Bit k of the masks below is keys[k]
+NKK_MultiBus(NKK_SmartDisplayLCD *keys[], uint8_t numKeys);
+~NKK_MultiBus(void);
+
+//Groups the keys by their SPI objects. Returns false if there are more than NKK_MultiBus_MaxBuses SPI objects (those keys are not uploaded)
+  bool begin(void);
+
+  uint8_t getNumBuses(void);
+//Bus of keys[k]
+  uint8_t getBus(uint8_t k);
+//Time of a frame of all keys on a bus in microseconds, SPI clock only
+  uint32_t getBusLoad(uint8_t bus);
+//true if the buses are fed concurrently, false if the keys are uploaded one after another
+  bool isInterleaved(void);
+
+//Upload images from imageBufferNKK[] of the keys in mask, set background colour and brightness of each key. Returns the number of keys uploaded
+  uint8_t display_NKK(uint32_t mask = 0xFFFFFFFF);
+//Convert imageBufferGFX[] of the keys in mask and upload them as display_NKK()
+  uint8_t display(uint32_t mask = 0xFFFFFFFF);
+
+private:
+NKK_SmartDisplayLCD *_keys[NKK_MultiBus_MaxKeys];
+uint8_t _numKeys;
+uint8_t _keyBus[NKK_MultiBus_MaxKeys]; //bus per key, NKK_MultiBus_MaxBuses if not handled
+
+struct Bus {
+  SPIClass *SPI_A;
+  uint32_t freq;               //SPI frequency of the first key
+  uint8_t keys[NKK_MultiBus_MaxKeys]; //key indices
+  uint8_t numKeys;
+  //upload in progress
+  uint8_t next;                //next element of keys[] to check
+  NKK_SmartDisplayLCD *key;    //key being uploaded, NULL if the bus is done
+  uint16_t pos;                //next byte of the key
+  uint16_t length;             //bytes of the key
+  uint16_t split;              //Slave Select is cycled before this byte (setCSPerCommand() of the key), length - not at all
+  uint32_t remaining;          //bytes left on the bus
+};
+Bus _buses[NKK_MultiBus_MaxBuses];
+uint8_t _numBuses = 0;
+
+  bool hasImage(NKK_SmartDisplayLCD *key);
+  uint16_t getFrameLength(NKK_SmartDisplayLCD *key);
+#if defined(NKK_MultiBus_Interleaved)
+  bool startKey(Bus *bus, uint32_t mask);
+  void finishKey(Bus *bus);
+  void nextCommand(Bus *bus);
+  byte getFrameByte(NKK_SmartDisplayLCD *key, uint16_t pos);
+  void sortBuses(uint8_t order[], uint8_t numBuses);
+#endif
+};
+#endif // _NKK_MultiBus_H_
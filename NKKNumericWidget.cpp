@@ -0,0 +1,335 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+
+#include <NKKNumericWidget.h>
+
+/**************************************************************************/
+/*!
+    @brief  Constructor for NKK_NumericWidget object.
+    @param  key A reference (pointer) to NKK_SmartDisplayLCD object to draw into (imageBufferNKK[]).
+	@param  font A reference (pointer) to NKKfont with the orientation of the key, shall stay valid.
+	@param  x Top left corner x coordinate of the first (leftmost) cell.
+	@param  y Top left corner y coordinate of the cells.
+	@param  numDigits Number of cells, up to 10. One cell is used for the minus sign of negative values.
+	@return NKK_NumericWidget object.
+    @note   Call the object's begin() function before use.
+*/
+/**************************************************************************/
+NKK_NumericWidget::NKK_NumericWidget(NKK_SmartDisplayLCD *key, const NKKfont *font, int16_t x, int16_t y, uint8_t numDigits)
+{
+ _key = key;
+ _font = font;
+ _x = x;
+ _y = y;
+ if (numDigits > NKK_NumericWidget_MaxDigits) {_numDigits = NKK_NumericWidget_MaxDigits;} else {_numDigits = numDigits;}
+ invalidate();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Destructor for NKK_NumericWidget object.
+*/
+/**************************************************************************/
+NKK_NumericWidget::~NKK_NumericWidget(void) {
+  free(_mask);
+  free(_strip);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Measures the digit cells and pre-renders the digit strip: every glyph is drawn into the first cell
+	        by drawCharNKK() and its bytes are copied out. The cells are cleared.
+    @return true if the widget is ready, false if the font orientation does not match the key, the cells do not fit the image,
+	        imageBufferNKK or the strip cannot be allocated.
+	@note   A key in the single buffer mode is switched to double buffer (imageBufferNKK is allocated).
+*/
+/**************************************************************************/
+bool NKK_NumericWidget::begin(void) {
+
+  free(_mask);
+  free(_strip);
+  _mask = NULL;
+  _strip = NULL;
+  _numLines = 0;
+  invalidate();
+  clearDirty();
+
+  bool isLandscape = (_key->_w >= _key->_h);
+  if (_numDigits == 0 || isLandscape != (pgm_read_byte(&_font->orientation) == NKKfont_Landscape) || !_key->setSingleBuffer(false)) {
+    return false;
+  }
+
+  //cell - the union of the glyph boxes and advances of the digit strip characters, relative to the cursor
+  uint16_t first = pgm_read_word(&_font->first);
+  uint16_t last = pgm_read_word(&_font->last);
+  int16_t left = 0, right = 0, top = 0, bottom = 0;
+  bool isEmpty = true;
+  for (uint8_t g = 0; g < NKK_NumericWidget_NumGlyphs; g++) {
+    unsigned char c = (g == NKK_NumericWidget_Minus) ? '-' : '0' + g;
+    if (c < first || c > last) {
+      continue;
+    }
+    NKKglyph *glyph = pgm_read_nkkglyph_ptr(_font, c - first);
+    int16_t gx = (int8_t) pgm_read_byte(&glyph->xOffset);
+    int16_t gy = (int8_t) pgm_read_byte(&glyph->yOffset);
+    int16_t gw = pgm_read_byte(&glyph->width);
+    int16_t gh = pgm_read_byte(&glyph->height);
+    int16_t advance = pgm_read_byte(&glyph->xAdvance);
+    if (gw == 0 || gh == 0) {
+      gx = 0; gw = 0; //advance only
+      gy = 0; gh = 0;
+    }
+    if (isEmpty) {
+      left = gx; top = gy; right = gx + gw; bottom = gy + gh;
+      isEmpty = false;
+    }
+    if (gx < left) {left = gx;}
+    if (gy < top) {top = gy;}
+    if (gx + gw > right) {right = gx + gw;}
+    if (gy + gh > bottom) {bottom = gy + gh;}
+    if (advance > right) {right = advance;}
+  }
+  if (left > 0) {left = 0;}
+  if (isEmpty || right - left > 255 || bottom - top > 255 || bottom == top) {
+    return false;
+  }
+  _cellW = right - left;
+  _cellH = bottom - top;
+  _cursorX = -left;
+  _cursorY = -top;
+  //Landscape cells are 8 pixel aligned to each other, so every cell has the same bit alignment as the strip
+  _pitch = isLandscape ? (_cellW + 7) & ~7 : _cellW;
+  if (isLandscape && _pitch < _cellW) {
+    return false;
+  }
+  if (_x < 0 || _y < 0 || _x + getWidth() > _key->_w || _y + getHeight() > _key->_h) {
+    return false;
+  }
+
+  _lineBytes = isLandscape ? _key->_w/8 : _key->_h/8;
+  byte mask[256/8];
+  for (uint8_t i = 0; i < _numDigits; i++) {
+    int16_t cellX = _x + i*_pitch;
+    uint8_t span;
+    if (isLandscape) {
+      _cellLine[i] = _y;
+      getSpan(cellX, _cellW, &_cellByte[i], &span, mask);
+    }
+    else {
+      _cellLine[i] = cellX;
+      getSpan(_y, _cellH, &_cellByte[i], &span, mask);
+    }
+    if (i == 0) {
+      _spanBytes = span;
+      _mask = (byte *) malloc(_spanBytes);
+      if (_mask == NULL) {
+        return false;
+      }
+      memcpy(_mask, mask, _spanBytes);
+    }
+  }
+
+  uint8_t numLines = isLandscape ? _cellH : _cellW;
+  uint16_t glyphBytes = numLines * _spanBytes;
+  _strip = (byte *) malloc(NKK_NumericWidget_NumGlyphs * glyphBytes);
+  if (_strip == NULL) {
+    free(_mask);
+    _mask = NULL;
+    return false;
+  }
+  _numLines = numLines;
+
+  //render every glyph into the first cell and copy the cell out
+  for (uint8_t g = 0; g < NKK_NumericWidget_NumGlyphs; g++) {
+    blitCell(0, NULL);
+    _key->drawCharNKK(_font, _x + _cursorX, _y + _cursorY, (g == NKK_NumericWidget_Minus) ? '-' : '0' + g, 1);
+    byte *glyph = _strip + g*glyphBytes;
+    for (uint8_t l = 0; l < _numLines; l++) {
+      byte *line = _key->imageBufferNKK + (_cellLine[0] + l)*_lineBytes + _cellByte[0];
+      for (uint8_t b = 0; b < _spanBytes; b++) {
+        *glyph++ = line[b] & _mask[b];
+      }
+    }
+  }
+  for (uint8_t i = 0; i < _numDigits; i++) {
+    blitCell(i, NULL);
+    _cells[i] = NKK_NumericWidget_Blank;
+  }
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Shows a value, right aligned. Only the cells whose glyph changed are redrawn and added to the dirty region.
+    @param  value A value to show. A value which needs more cells than the widget has (including the minus sign) is shown as "----".
+	@param  isLeadingZeros true - unused cells on the left are zeros, false - blank.
+    @return Number of cells redrawn.
+*/
+/**************************************************************************/
+uint8_t NKK_NumericWidget::setValue(int32_t value, bool isLeadingZeros) {
+
+  if (_strip == NULL || !_key->setSingleBuffer(false)) {
+    return 0; //not begun or no RAM for a copy of a shared (NKK_FramePool) image
+  }
+  uint8_t glyphs[NKK_NumericWidget_MaxDigits];
+  bool isNegative = (value < 0);
+  uint32_t magnitude = isNegative ? 0 - (uint32_t) value : (uint32_t) value; //no overflow for INT32_MIN
+  int8_t i = _numDigits - 1;
+  do {
+    if (i < 0) {
+      break;
+    }
+    glyphs[i--] = magnitude % 10;
+    magnitude /= 10;
+  } while (magnitude != 0);
+
+  if (magnitude != 0 || (isNegative && i < 0)) {
+    for (i = 0; i < _numDigits; i++) {
+      glyphs[i] = NKK_NumericWidget_Minus; //does not fit
+    }
+  }
+  else {
+    int8_t sign = isNegative ? (isLeadingZeros ? 0 : i) : -1; //cell of the minus sign
+    for (; i >= 0; i--) {
+      glyphs[i] = (i == sign) ? NKK_NumericWidget_Minus : ((isLeadingZeros) ? 0 : NKK_NumericWidget_Blank);
+    }
+  }
+
+  uint8_t changed = 0;
+  uint16_t glyphBytes = _numLines * _spanBytes;
+  for (i = 0; i < _numDigits; i++) {
+    if (glyphs[i] == _cells[i]) {
+      continue;
+    }
+    blitCell(i, (glyphs[i] == NKK_NumericWidget_Blank) ? NULL : _strip + glyphs[i]*glyphBytes);
+    _cells[i] = glyphs[i];
+    changed++;
+    if (_dirtyFirst > _dirtyLast) {
+      _dirtyFirst = i;
+      _dirtyLast = i;
+    }
+    else {
+      if (i < _dirtyFirst) {_dirtyFirst = i;}
+      if (i > _dirtyLast) {_dirtyLast = i;}
+    }
+  }
+  return changed;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Marks all cells as unknown, so the next setValue() redraws them, e.g. after imageBufferNKK[] has been cleared or overwritten.
+*/
+/**************************************************************************/
+void NKK_NumericWidget::invalidate(void) {
+  for (uint8_t i = 0; i < NKK_NumericWidget_MaxDigits; i++) {
+    _cells[i] = 0xFF;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the dirty region - the bounding box of the cells redrawn since the last display() or clearDirty().
+    @param  x, y  Top left corner of the region.
+    @param  w, h  Size of the region in pixels.
+    @return false if no cell has been redrawn (the region is not set).
+*/
+/**************************************************************************/
+bool NKK_NumericWidget::getDirtyRect(int16_t *x, int16_t *y, uint16_t *w, uint16_t *h) {
+  if (_dirtyFirst > _dirtyLast) {
+    return false;
+  }
+  *x = _x + _dirtyFirst*_pitch;
+  *y = _y;
+  *w = (_dirtyLast - _dirtyFirst)*_pitch + _cellW;
+  *h = _cellH;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Clears the dirty region.
+*/
+/**************************************************************************/
+void NKK_NumericWidget::clearDirty(void) {
+  _dirtyFirst = 0;
+  _dirtyLast = -1;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Uploads imageBufferNKK[] of the key with display_NKK() if the dirty region is not empty, and clears the region.
+    @return true if the image has been uploaded.
+*/
+/**************************************************************************/
+bool NKK_NumericWidget::display(void) {
+  if (_dirtyFirst > _dirtyLast) {
+    return false;
+  }
+  _key->display_NKK();
+  clearDirty();
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the widget width (all cells) in pixels, valid after begin().
+    @return Width in pixels.
+*/
+/**************************************************************************/
+uint16_t NKK_NumericWidget::getWidth(void) {
+  return (_numDigits > 0) ? (_numDigits - 1)*_pitch + _cellW : 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the widget height in pixels, valid after begin().
+    @return Height in pixels.
+*/
+/**************************************************************************/
+uint16_t NKK_NumericWidget::getHeight(void) {
+  return _cellH;
+}
+
+//Covered bytes of an NKK line for length pixels from pixel pos - first byte, number of bytes and the bits of the pixels in them.
+//Uses stampByteNKK() of the key, so the bit order of the current orientation is respected.
+bool NKK_NumericWidget::getSpan(int16_t pos, uint8_t length, uint8_t *first, uint8_t *span, byte mask[]) {
+  byte line[256/8];
+  bool isLandscape = (_key->_w >= _key->_h);
+  memset(line, 0, _lineBytes);
+  for (uint16_t p = 0; p < length; p += 8) {
+    uint8_t n = (length - p < 8) ? length - p : 8;
+    byte bits = (n == 8) ? 0xFF : (isLandscape ? (1 << n) - 1 : (byte) (0xFF << (8 - n)));
+    _key->stampByteNKK(line, _lineBytes, pos + p, bits, 1);
+  }
+  uint8_t a = 0, b = _lineBytes;
+  while (a < _lineBytes && line[a] == 0) {
+    a++;
+  }
+  while (b > a && line[b - 1] == 0) {
+    b--;
+  }
+  *first = a;
+  *span = b - a;
+  memcpy(mask, line + a, b - a);
+  return b > a;
+}
+
+//Copies a pre-rendered glyph into a cell, only the cell bits are changed. NULL clears the cell.
+void NKK_NumericWidget::blitCell(uint8_t cell, const byte glyph[]) {
+  for (uint8_t l = 0; l < _numLines; l++) {
+    byte *line = _key->imageBufferNKK + (_cellLine[cell] + l)*_lineBytes + _cellByte[cell];
+    for (uint8_t b = 0; b < _spanBytes; b++) {
+      byte bits = (glyph != NULL) ? *glyph++ : 0;
+      line[b] = (line[b] & ~_mask[b]) | bits;
+    }
+  }
+}
@@ -0,0 +1,98 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*********************************************************************
+Numeric widget for NKK LCD 64x32 SmartDisplay
+
+Counters and readings updated many times per second. Digits are shown in fixed cells
+of imageBufferNKK[], every new value is compared with the shown one digit by digit and
+only the cells which changed are redrawn.
+
+- Digits '0'..'9' and '-' of an NKKfont (fontconvert -l or -p) are pre-rendered once in
+  begin() into a digit strip in NKK native format, at the bit alignment of the cells.
+  A changed cell is a masked byte copy from the strip, no glyph decoding and no GFX to
+  NKK conversion.
+- Cells in Landscape are 8 pixel aligned to each other, so all cells share the masks.
+- The changed cells are collected into a dirty region. display() uploads the image only
+  if something changed (NKK devices take whole images only).
+- The rest of imageBufferNKK[] (labels, frames) is not touched, draw it with drawTextNKK()
+  or convertGFX2NKK() once before begin().
+*********************************************************************/
+#ifndef _NKK_NumericWidget_H_
+#define _NKK_NumericWidget_H_
+
+#include <NKKSmartDisplayLCD.h>
+
+#define NKK_NumericWidget_MaxDigits 10
+#define NKK_NumericWidget_Minus 10  //glyph index of '-' in the digit strip
+#define NKK_NumericWidget_Blank 11  //an empty cell, not stored in the digit strip
+#define NKK_NumericWidget_NumGlyphs 11
+
+/**************************************************************************/
+/*!
+    @brief  Class that shows a number in fixed digit cells of imageBufferNKK[] and redraws only the digits which changed.
+*/
+/**************************************************************************/
+class NKK_NumericWidget {
+
+public:
+NKK_NumericWidget(NKK_SmartDisplayLCD *key, const NKKfont *font, int16_t x, int16_t y, uint8_t numDigits);
+~NKK_NumericWidget(void);
+
+//Pre-renders the digit strip and clears the cells. Call it after setRotation() of the key. Returns false if the font orientation
+//does not match the key, the cells do not fit the image, imageBufferNKK or the strip cannot be allocated.
+//A key in the single buffer mode gets imageBufferNKK allocated.
+bool begin(void);
+
+//Shows a value right aligned, with leading blanks (or zeros). A value which does not fit is shown as "----".
+//Returns the number of cells redrawn.
+  uint8_t setValue(int32_t value, bool isLeadingZeros=false);
+  //All cells are redrawn by the next setValue(), e.g. after imageBufferNKK[] has been cleared
+  void invalidate(void);
+
+//Dirty region - the cells redrawn since the last display() or clearDirty()
+  bool getDirtyRect(int16_t *x, int16_t *y, uint16_t *w, uint16_t *h);
+  void clearDirty(void);
+  //Uploads imageBufferNKK[] of the key (display_NKK()) if any cell changed, returns true if uploaded
+  bool display(void);
+
+//Widget size in pixels
+  uint16_t getWidth(void);
+  uint16_t getHeight(void);
+
+private:
+NKK_SmartDisplayLCD *_key;
+const NKKfont *_font;
+int16_t _x;             //top left corner of the first cell
+int16_t _y;
+uint8_t _numDigits;
+
+uint8_t _cellW = 0;     //cell size in pixels
+uint8_t _cellH = 0;
+uint8_t _pitch = 0;     //distance between cells in pixels
+int8_t _cursorX = 0;    //text cursor relative to the top left corner of a cell
+int8_t _cursorY = 0;
+
+uint8_t _lineBytes = 0; //NKK line (a row in Landscape, a column in Portrait) length in bytes
+uint8_t _numLines = 0;  //lines per cell
+uint8_t _spanBytes = 0; //bytes of a line covered by a cell
+byte *_mask = NULL;     //cell bits in the covered bytes of a line, _spanBytes
+byte *_strip = NULL;    //pre-rendered glyphs, _numLines*_spanBytes bytes per glyph
+uint16_t _cellLine[NKK_NumericWidget_MaxDigits]; //first line of a cell
+uint8_t _cellByte[NKK_NumericWidget_MaxDigits];  //first covered byte of a line
+uint8_t _cells[NKK_NumericWidget_MaxDigits];     //glyph shown in a cell, 0xFF - unknown
+
+int8_t _dirtyFirst = 0; //first and last redrawn cell, none if _dirtyFirst > _dirtyLast
+int8_t _dirtyLast = -1;
+
+   bool getSpan(int16_t pos, uint8_t length, uint8_t *first, uint8_t *span, byte mask[]);
+   void blitCell(uint8_t cell, const byte glyph[]);
+};
+#endif // _NKK_NumericWidget_H_
@@ -0,0 +1,332 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+
+#include <NKKParallelSPI.h>
+
+/**************************************************************************/
+/*!
+    @brief  Constructor for NKK_ParallelSPI object.
+    @param  clkpin Clock pin shared by all NKK devices.
+	@param  datapins[] Data pins, one per NKK device. Use pins of the same GPIO port for the fast path.
+	@param  numKeys Number of NKK devices (elements in datapins[]), up to 8.
+	@return NKK_ParallelSPI object.
+    @note   Call the object's begin() function before use.
+*/
+/**************************************************************************/
+NKK_ParallelSPI::NKK_ParallelSPI(uint8_t clkpin, const uint8_t datapins[], uint8_t numKeys)
+{
+ _clk = clkpin;
+
+ if (numKeys > NKK_ParallelSPI_MaxKeys) {_numKeys = NKK_ParallelSPI_MaxKeys;} else {_numKeys = numKeys;}
+ for (uint8_t k = 0; k < _numKeys; k++) {
+   _data[k] = datapins[k];
+ }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Destructor for NKK_ParallelSPI object.
+*/
+/**************************************************************************/
+NKK_ParallelSPI::~NKK_ParallelSPI(void) {
+}
+
+/**************************************************************************/
+/*!
+    @brief  Setups clock and data pins. Resolves the port registers if all data pins are on the same GPIO port.
+*/
+/**************************************************************************/
+void NKK_ParallelSPI::begin(void) {
+
+  pinMode(_clk, OUTPUT);
+  digitalWrite(_clk, HIGH); //SPI_MODE2 - clock is idle high
+
+  for (uint8_t k = 0; k < _numKeys; k++) {
+    pinMode(_data[k], OUTPUT);
+    digitalWrite(_data[k], LOW);
+  }
+
+  //Portable path - bit k of the port-wide value is key k
+  _fastIO = false;
+  _dataMask = 0;
+  for (uint8_t k = 0; k < _numKeys; k++) {
+    _dataBit[k] = 1 << k;
+    _dataMask |= _dataBit[k];
+  }
+
+#if defined(NKK_ParallelSPI_FastIO)
+  //Fast path - all data pins shall be on the same port
+  for (uint8_t k = 1; k < _numKeys; k++) {
+    if (digitalPinToPort(_data[k]) != digitalPinToPort(_data[0])) {
+      return;
+    }
+  }
+  _dataPort = portOutputRegister(digitalPinToPort(_data[0]));
+  _clkPort = portOutputRegister(digitalPinToPort(_clk));
+  _clkMask = digitalPinToBitMask(_clk);
+  _dataMask = 0;
+  for (uint8_t k = 0; k < _numKeys; k++) {
+    _dataBit[k] = digitalPinToBitMask(_data[k]);
+    _dataMask |= _dataBit[k];
+  }
+  _fastIO = true;
+#endif
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns number of NKK devices driven by the object
+	@return Number of NKK devices
+*/
+/**************************************************************************/
+uint8_t NKK_ParallelSPI::getNumKeys(void) {
+return _numKeys;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns true if the data pins are driven by port register stores, false if digitalWrite() is used
+	@return Fast path flag
+*/
+/**************************************************************************/
+bool NKK_ParallelSPI::isFastIO(void) {
+return _fastIO;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Displays pictures in GFX format i.e. converts imageBufferGFX of each key to NKK format, uploads all NKK devices at once,
+	        sets colour and brightness as per each key's variables.
+	@param  keys[] An array of pointers to NKK_SmartDisplayLCD objects, one per data pin.
+	@return false if the image sizes of the keys differ or a key has no image buffer, nothing is sent then. true otherwise
+*/
+/**************************************************************************/
+bool NKK_ParallelSPI::display(NKK_SmartDisplayLCD *keys[]) {
+
+  if (!isUploadable(keys)) {
+    return false;
+  }
+  for (uint8_t k = 0; k < _numKeys; k++) {
+    keys[k]->convertGFX2NKK();
+  }
+  return display_NKK(keys);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Displays pictures in NKK format i.e. uploads imageBufferNKK of each key to all NKK devices at once,
+	        sets colour and brightness as per each key's variables.
+	@param  keys[] An array of pointers to NKK_SmartDisplayLCD objects, one per data pin.
+	@return false if the image sizes of the keys differ or a key has no image buffer (begin() of the key returned false), 
+	        nothing is sent then. true otherwise
+	@note   imageBufferNKK of the keys is not changed. Keys in the single buffer mode are uploaded from imageBufferGFX.
+*/
+/**************************************************************************/
+bool NKK_ParallelSPI::display_NKK(NKK_SmartDisplayLCD *keys[]) {
+
+  if (!isUploadable(keys)) {
+    return false;
+  }
+  //image, colour and brightness in one Slave Select session, a session each if a key asks for it (setCSPerCommand())
+  selectKeys(keys, LOW); // enable Slave Select
+  transferImages(keys);
+  nextCommand(keys);
+  transferColourAndBrightness(keys);
+  selectKeys(keys, HIGH); // disable Slave Select
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets background colour and brightness for all NKK devices at once as per each key's variables.
+	@param  keys[] An array of pointers to NKK_SmartDisplayLCD objects, one per data pin.
+*/
+/**************************************************************************/
+void NKK_ParallelSPI::setColourAndBrightness(NKK_SmartDisplayLCD *keys[]) {
+
+  selectKeys(keys, LOW); // enable Slave Select
+  transferColourAndBrightness(keys);
+  selectKeys(keys, HIGH); // disable Slave Select
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sends a reset command to all NKK devices at once.
+	@param  keys[] An array of pointers to NKK_SmartDisplayLCD objects, one per data pin.
+*/
+/**************************************************************************/
+void NKK_ParallelSPI::reset(NKK_SmartDisplayLCD *keys[]) {
+
+  byte data[NKK_ParallelSPI_MaxKeys];
+
+  for (uint8_t k = 0; k < _numKeys; k++) {
+    data[k] = NKK_SmartDisplayLCD_Reset_data;
+  }
+  selectKeys(keys, LOW); // enable Slave Select
+  transferCommandAndData(NKK_SmartDisplayLCD_Reset, data);
+  selectKeys(keys, HIGH); // disable Slave Select
+}
+
+/******************************************************************************/
+/* Bit-sliced transfer helpers                                                */
+/******************************************************************************/
+
+//Function to write a NKK Image Upload command and imageBufferNKK of each key, transposed into port-wide values on the fly.
+//Keys in the single buffer mode send imageBufferGFX converted to NKK format byte by byte. Slave Select is handled by the caller
+void NKK_ParallelSPI::transferImages(NKK_SmartDisplayLCD *keys[])
+{
+ byte data[NKK_ParallelSPI_MaxKeys];
+ uint16_t length = keys[0]->_imageBufferLength;
+
+ for (uint8_t k = 0; k < _numKeys; k++) {
+   data[k] = NKK_SmartDisplayLCD_Img_Upload;
+ }
+ transferBytes(data);
+
+ for (uint16_t i = 0; i < length; i++) {
+   for (uint8_t k = 0; k < _numKeys; k++) {
+     uint16_t n = keys[k]->_isRotate180 ? length - 1 - i : i; //the image is rotated 180 degrees on the fly
+     if (keys[k]->imageBufferNKK == NULL) {
+       data[k] = keys[k]->convertByteGFX2NKK(keys[k]->imageBufferGFX, n); //single buffer mode - converted on the fly
+     }
+     else {
+       data[k] = keys[k]->imageBufferNKK[n];
+     }
+     if (keys[k]->_isRotate180) {
+       data[k] = keys[k]->reverseByte(data[k]);
+     }
+   }
+   transferBytes(data);
+ }
+}
+
+
+//Function to write colour and brightness commands as per each key's variables, Slave Select is handled by the caller
+void NKK_ParallelSPI::transferColourAndBrightness(NKK_SmartDisplayLCD *keys[])
+{
+ byte data[NKK_ParallelSPI_MaxKeys];
+
+ for (uint8_t k = 0; k < _numKeys; k++) {
+   keys[k]->bkgColour = keys[k]->bkgColour | 0x03; // apply mask
+   data[k] = keys[k]->bkgColour;
+ }
+ transferCommandAndData(NKK_SmartDisplayLCD_Set_RGB, data);
+ nextCommand(keys);
+
+ for (uint8_t k = 0; k < _numKeys; k++) {
+   keys[k]->bkgBrightnes = keys[k]->bkgBrightnes | 0x1F; // apply mask
+   data[k] = keys[k]->bkgBrightnes;
+ }
+ transferCommandAndData(NKK_SmartDisplayLCD_Set_Bright, data);
+}
+
+
+//Ends the Slave Select session and starts a new one if any key takes a session per command (setCSPerCommand() of the key)
+void NKK_ParallelSPI::nextCommand(NKK_SmartDisplayLCD *keys[])
+{
+ for (uint8_t k = 0; k < _numKeys; k++) {
+   if (keys[k]->_isCSPerCommand) {
+     selectKeys(keys, HIGH); // disable Slave Select
+     selectKeys(keys, LOW); // enable Slave Select
+     return;
+   }
+ }
+}
+
+
+//Function to write the same command and a data byte per key, Slave Select is handled by the caller
+void NKK_ParallelSPI::transferCommandAndData(byte command, const byte data[])
+{
+ byte commands[NKK_ParallelSPI_MaxKeys];
+
+ for (uint8_t k = 0; k < _numKeys; k++) {
+   commands[k] = command;
+ }
+
+ transferBytes(commands);
+ transferBytes(data);
+}
+
+
+//Function to check the images of the keys can be sent at once - the same length (transferImages() reads all keys with the length of 
+//the first one) and a buffer to read from
+bool NKK_ParallelSPI::isUploadable(NKK_SmartDisplayLCD *keys[])
+{
+ for (uint8_t k = 0; k < _numKeys; k++) {
+   if (keys[k]->_imageBufferLength != keys[0]->_imageBufferLength || (keys[k]->imageBufferNKK == NULL && keys[k]->imageBufferGFX == NULL)) {
+     return false;
+   }
+ }
+ return true;
+}
+
+
+//Function to send one byte per key, MSB first. Bit 7 of every byte goes out on the first clock edge and so on.
+void NKK_ParallelSPI::transferBytes(const byte data[])
+{
+ byte b[NKK_ParallelSPI_MaxKeys];
+
+ for (uint8_t k = 0; k < _numKeys; k++) {
+   b[k] = data[k];
+ }
+
+ for (uint8_t i = 0; i < 8; i++) {
+   //transpose - collect the current top bit of every key into one port-wide value
+   NKK_PortMask_t bits = 0;
+   for (uint8_t k = 0; k < _numKeys; k++) {
+     if (b[k] & 0x80) {
+       bits |= _dataBit[k];
+     }
+     b[k] = b[k] << 1;
+   }
+   writeBits(bits);
+ }
+}
+
+
+//Function to set the data pins and clock them. NKK takes the data on the falling edge of the clock (SPI_MODE2).
+//Port stores are read-modify-write: on AVR interrupts are held off as digitalWrite() does, on other cores other pins 
+//of the data and clock ports shall not be written from interrupt handlers.
+void NKK_ParallelSPI::writeBits(NKK_PortMask_t bits)
+{
+#if defined(NKK_ParallelSPI_FastIO)
+ if (_fastIO) {
+#if defined(__AVR__)
+   uint8_t oldSREG = SREG;
+   cli();
+#endif
+   *_dataPort = (*_dataPort & ~_dataMask) | bits;
+   *_clkPort &= ~_clkMask; //falling edge - data are taken by NKK
+   *_clkPort |= _clkMask;
+#if defined(__AVR__)
+   SREG = oldSREG;
+#endif
+   return;
+ }
+#endif
+ for (uint8_t k = 0; k < _numKeys; k++) {
+   digitalWrite(_data[k], (bits & _dataBit[k]) ? HIGH : LOW);
+ }
+ digitalWrite(_clk, LOW); //falling edge - data are taken by NKK
+ digitalWrite(_clk, HIGH);
+}
+
+
+//Sets Slave Select signal to level for all keys, Slave Select providers send the lines of all keys at once
+void NKK_ParallelSPI::selectKeys(NKK_SmartDisplayLCD *keys[], uint8_t level)
+{
+ for (uint8_t k = 0; k < _numKeys; k++) {
+   keys[k]->stageCS(level);
+ }
+ for (uint8_t k = 0; k < _numKeys; k++) {
+   keys[k]->updateCS();
+ }
+}
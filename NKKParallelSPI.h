@@ -0,0 +1,98 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*********************************************************************
+Bit-sliced parallel software SPI for NKK LCD 64x32 SmartDisplay
+
+Hardware SPI sends images to NKK devices one after another over a single MOSI line.
+This transport puts up to 8 NKK devices on 8 data pins with a shared clock pin, so
+every clock edge writes one bit to each device and up to 8 different images are
+uploaded in the time of one.
+
+- NKK images are transposed into port-wide values on the fly, no extra buffers are used.
+- Data pins shall be on the same GPIO port to use the fast path (a single register store
+  per clock edge). Otherwise, or if the core does not provide port register macros
+  (e.g. a host build with GPIO stand-ins), pins are driven with digitalWrite().
+  The register stores are read-modify-write: on AVR interrupts are held off during them, on
+  other cores other pins of the data and clock ports shall not be written by interrupt handlers.
+- Each key keeps its own Slave Select pin (cspin of the NKK_SmartDisplayLCD object) or
+  provider line (setChipSelect()), all of them are asserted together during a transfer.
+  An upload is one Slave Select session, or a session per command if any key has
+  setCSPerCommand() enabled.
+- Rotation by 180 degrees is respected per key. The keys shall have the same image size,
+  display() and display_NKK() return false and send nothing otherwise.
+- SPI object and SPI frequency of the keys are not used by this transport.
+*********************************************************************/
+#ifndef _NKK_ParallelSPI_H_
+#define _NKK_ParallelSPI_H_
+
+#include <NKKSmartDisplayLCD.h>
+
+#define NKK_ParallelSPI_MaxKeys 8
+
+//Port register access, resolved once in begin(), see NKKSmartDisplayLCD.h
+#if defined(NKK_SmartDisplayLCD_FastIO)
+  #define NKK_ParallelSPI_FastIO
+#endif
+
+/**************************************************************************/
+/*!
+    @brief  Class that drives up to 8 NKK SmartDisplay LCD devices at once with a bit-sliced software SPI.
+*/
+/**************************************************************************/
+class NKK_ParallelSPI {
+
+public:
+NKK_ParallelSPI(uint8_t clkpin, const uint8_t datapins[], uint8_t numKeys);
+~NKK_ParallelSPI(void);
+
+//Setups the pins, clock is idle high (SPI_MODE2)
+void begin(void);
+
+uint8_t getNumKeys(void);
+bool isFastIO(void);
+
+//NKK commands, keys[i] is connected to datapins[i]. Keys shall have the same image size.
+  //Upload images to the NKK devices from imageBufferGFX[] of each key, set background colour and brightness of each key.
+  //Return false and send nothing if the image sizes of the keys differ or a key has no image buffer
+  bool display(NKK_SmartDisplayLCD *keys[]);
+  //Upload images to the NKK devices from imageBufferNKK[] of each key, set background colour and brightness of each key
+  bool display_NKK(NKK_SmartDisplayLCD *keys[]);
+  //Set background colour and brightness of each key as per bkgColour and bkgBrightnes of each key
+  void setColourAndBrightness(NKK_SmartDisplayLCD *keys[]);
+  //Reset NKK devices
+  void reset(NKK_SmartDisplayLCD *keys[]);
+
+private:
+uint8_t _clk;
+uint8_t _data[NKK_ParallelSPI_MaxKeys];
+uint8_t _numKeys = 0;
+
+NKK_PortMask_t _dataBit[NKK_ParallelSPI_MaxKeys]; //port bit mask per key (fast path) or 1<<key (portable path)
+NKK_PortMask_t _dataMask = 0; //all data bits
+bool _fastIO = false;
+
+#if defined(NKK_ParallelSPI_FastIO)
+NKK_PortReg_t *_dataPort = NULL;
+NKK_PortReg_t *_clkPort = NULL;
+NKK_PortMask_t _clkMask = 0;
+#endif
+
+//Bit-sliced transfer helpers
+   void transferBytes(const byte data[]); //one byte per key, MSB first
+   void writeBits(NKK_PortMask_t bits);
+   void transferImages(NKK_SmartDisplayLCD *keys[]);
+   void transferColourAndBrightness(NKK_SmartDisplayLCD *keys[]);
+   void transferCommandAndData(byte command, const byte data[]);
+   void nextCommand(NKK_SmartDisplayLCD *keys[]);
+   void selectKeys(NKK_SmartDisplayLCD *keys[], uint8_t level);
+   bool isUploadable(NKK_SmartDisplayLCD *keys[]);
+};
+#endif // _NKK_ParallelSPI_H_
@@ -41,6 +41,21 @@ Key Features:
 *********************************************************************/
 
 #include <NKKSmartDisplayLCD.h>
+#include <NKKChipSelect.h>
+
+#ifndef PROGMEM
+  #define PROGMEM
+#endif
+
+//Level (0-3) of the closest NKK colour channel for 0-255 - levels 0, 85, 170, 255, i.e. round(x * 3 / 255), computed by the compiler
+#define NKK_SmartDisplayLCD_Level(x) (((x) + 42) / 85)
+#define NKK_SmartDisplayLCD_Level4(x) NKK_SmartDisplayLCD_Level(x), NKK_SmartDisplayLCD_Level((x) + 1), NKK_SmartDisplayLCD_Level((x) + 2), NKK_SmartDisplayLCD_Level((x) + 3)
+#define NKK_SmartDisplayLCD_Level16(x) NKK_SmartDisplayLCD_Level4(x), NKK_SmartDisplayLCD_Level4((x) + 4), NKK_SmartDisplayLCD_Level4((x) + 8), NKK_SmartDisplayLCD_Level4((x) + 12)
+#define NKK_SmartDisplayLCD_Level64(x) NKK_SmartDisplayLCD_Level16(x), NKK_SmartDisplayLCD_Level16((x) + 16), NKK_SmartDisplayLCD_Level16((x) + 32), NKK_SmartDisplayLCD_Level16((x) + 48)
+
+static const byte colourLevel[256] PROGMEM = {
+  NKK_SmartDisplayLCD_Level64(0), NKK_SmartDisplayLCD_Level64(64), NKK_SmartDisplayLCD_Level64(128), NKK_SmartDisplayLCD_Level64(192)
+};
 
 /**************************************************************************/
 /*!
@@ -51,6 +66,7 @@ Key Features:
     @param  cspin Slave Select(Chip Select) signal  (to allow use more than one NKK device with their own SS signals).
 	@param  freqSPI SPI frequency, Hz. 
 	@param  A reference (pointer) to native SPI object which handles SPI communications. 
+	@param  singleBuffer true - the single buffer mode, imageBufferNKK is not allocated (see setSingleBuffer()), false - both buffers are allocated. 
 	@return NKK_SmartDisplayLCD object.
     @note   Call the object's begin() function before use SPI begin() etc. is performed there!. CSPIN is included to handle multiple NKK devices with own SS signals. 
 */
@@ -60,7 +76,8 @@ NKK_SmartDisplayLCD::NKK_SmartDisplayLCD(uint8_t w,
                                    uint8_t isRotate180, //0- no rotation* 1 - 180 degree rotation    
 								   uint8_t cspin,
 								   uint32_t freqSPI,	
-								   SPIClass *SPI_A)
+								   SPIClass *SPI_A,
+								   bool singleBuffer)
 								   
 								   
 								   
@@ -87,15 +104,26 @@ NKK_SmartDisplayLCD::NKK_SmartDisplayLCD(uint8_t w,
   
   //set variables, some very basic validation applied just in case to fit the NKK devices as expected  - 64*32, Max w*h/8  = 65535 for this library. 
   //NKK Smart Display is 64bit*32bit, feel free to adjust if you adopt this library for other displays
-  if (w>64) {_w=64;}  else {_w = w;}
-  if (h>64) {_h=64;}  else {_h = h;}
-  if (w<32) {_w=32;}  else {_w = w;}
-  if (h<32) {_h=32;}  else {_h = h;}
+  if (w>64) {_w=64;}  else if (w<32) {_w=32;}  else {_w = w;}
+  if (h>64) {_h=64;}  else if (h<32) {_h=32;}  else {_h = h;}
  
 
  _imageBufferLength =_w*_h/8; //  image array length in bytes, max allowed in this library is uint16_t which is 65535.
  
+ //Image buffers, exact size. Single buffer mode - imageBufferNKK is allocated by setSingleBuffer(false) or on first use. 
+ //new returns NULL on AVR if there is no RAM left, begin() reports it 
+ imageBufferGFX = new byte[_imageBufferLength];
+ if (imageBufferGFX != NULL) {memset(imageBufferGFX, 0, _imageBufferLength);}
+ _isDoubleBuffer = !singleBuffer;
+ if (_isDoubleBuffer) {
+   imageBufferNKK = new byte[_imageBufferLength];
+   if (imageBufferNKK != NULL) {memset(imageBufferNKK, 0, _imageBufferLength);}
+ }
+ 
  _isRotate180 = isRotate180;
+ _baseW = _w;
+ _baseH = _h;
+ _baseRotate180 = isRotate180;
  
  //Set Slave Select(Chip Select) signal  (to allow use more than one NKK device with their own SS signals)
  _cs = cspin;
@@ -110,20 +138,101 @@ NKK_SmartDisplayLCD::NKK_SmartDisplayLCD(uint8_t w,
 */
 /**************************************************************************/
 NKK_SmartDisplayLCD::~NKK_SmartDisplayLCD(void) {
+  if (_isOwnImageBufferGFX) {delete[] imageBufferGFX;}
+  if (_isOwnImageBufferNKK) {delete[] imageBufferNKK;}
+  releaseSharedImageBufferNKK();
+  delete _spiSetting;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Move constructor, takes over the image buffers (and a shared NKK_FramePool frame) and the settings of other.
+    @param  other The object to move from, it is left without buffers and shall only be destroyed or assigned to.
+	@note   Allows NKK_SmartDisplayLCD NKK = NKK_SmartDisplayLCD(64,32,0,4); with C++11, where the copy is not guaranteed to be elided. 
+*/
+/**************************************************************************/
+NKK_SmartDisplayLCD::NKK_SmartDisplayLCD(NKK_SmartDisplayLCD &&other) {
+  moveFrom(other);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Move assignment, releases the buffers of this object and takes over the buffers and the settings of other.
+    @param  other The object to move from, it is left without buffers and shall only be destroyed or assigned to.
+	@return This object.
+*/
+/**************************************************************************/
+NKK_SmartDisplayLCD& NKK_SmartDisplayLCD::operator=(NKK_SmartDisplayLCD &&other) {
+  if (this != &other) {
+    if (_isOwnImageBufferGFX) {delete[] imageBufferGFX;}
+    if (_isOwnImageBufferNKK) {delete[] imageBufferNKK;}
+    releaseSharedImageBufferNKK();
+    delete _spiSetting;
+    moveFrom(other);
+  }
+  return *this;
+}
+
+//Takes over all members of other, other keeps no buffer, no shared frame and no SPI settings so its destructor releases nothing
+void NKK_SmartDisplayLCD::moveFrom(NKK_SmartDisplayLCD &other) {
+  imageBufferGFX = other.imageBufferGFX;
+  imageBufferNKK = other.imageBufferNKK;
+  bkgColour = other.bkgColour;
+  bkgBrightnes = other.bkgBrightnes;
+  _SPI = other._SPI;
+  _spiSetting = other._spiSetting;
+  _freqSPI = other._freqSPI;
+  _w = other._w;
+  _h = other._h;
+  _imageBufferLength = other._imageBufferLength;
+  _isRotate180 = other._isRotate180;
+  _baseW = other._baseW;
+  _baseH = other._baseH;
+  _baseRotate180 = other._baseRotate180;
+  _rotation = other._rotation;
+  _cs = other._cs;
+  _csProvider = other._csProvider;
+  _csLine = other._csLine;
+  _isFastCS = other._isFastCS;
+#if defined(NKK_SmartDisplayLCD_FastIO)
+  _csPort = other._csPort;
+  _csMask = other._csMask;
+#endif
+  _isOwnImageBufferGFX = other._isOwnImageBufferGFX;
+  _isOwnImageBufferNKK = other._isOwnImageBufferNKK;
+  _sharedRefCount = other._sharedRefCount;
+  _isDoubleBuffer = other._isDoubleBuffer;
+
+  other.imageBufferGFX = NULL;
+  other.imageBufferNKK = NULL;
+  other._spiSetting = NULL;
+  other._isOwnImageBufferGFX = false;
+  other._isOwnImageBufferNKK = false;
+  other._sharedRefCount = NULL;
 }
 
 /**************************************************************************/
 /*! 
     @brief  Starts the SPI interface and resets NKK hardware.
+	@return false if imageBufferGFX or imageBufferNKK (unless in the single buffer mode) could not be allocated in the constructor, 
+	        functions which work with the missing buffer do nothing then.
 */
 /**************************************************************************/
-void NKK_SmartDisplayLCD::begin(void) {
+bool NKK_SmartDisplayLCD::begin(void) {
 
   //Start of SPI interface
   _SPI->begin();  
 
+  //Slave Select pin as an output register and a bit mask, toggled by a store instead of digitalWrite() 
+#if defined(NKK_SmartDisplayLCD_FastIO)
+  _csPort = portOutputRegister(digitalPinToPort(_cs));
+  _csMask = digitalPinToBitMask(_cs);
+#endif
+
   //NKK reset
   reset();
+  
+  return imageBufferGFX != NULL && (imageBufferNKK != NULL || !_isDoubleBuffer);
 }
 
 /**************************************************************************/
@@ -143,6 +252,9 @@ void NKK_SmartDisplayLCD::reset(void) {
 /**************************************************************************/
 void NKK_SmartDisplayLCD::convertGFX2NKK(void){
 		
+	if (imageBufferNKK == NULL || imageBufferGFX == NULL || !unshareImageBufferNKK()) {
+		return; //single buffer mode or no RAM for the image
+	}
 	convertGFX2NKK(imageBufferGFX, imageBufferNKK);
 }
 
@@ -154,178 +266,331 @@ void NKK_SmartDisplayLCD::convertGFX2NKK(void){
 */
 /**************************************************************************/
 void NKK_SmartDisplayLCD::convertGFX2NKK(byte imageBufferGFX[], byte imageBufferNKK[]){
-//Serial.println("NKK_SmartDisplayLCD::convertGFX2NKK:started");	uint32_t startTime = millis();	
+	
+	uint8_t stripLength = getStripLength();
+	uint16_t numOfStrips = _imageBufferLength / stripLength;
+	
+	for (uint16_t s = 0; s<numOfStrips; s++) {
+		convertStripGFX2NKK(imageBufferGFX, s, imageBufferNKK + s*stripLength);
+	}
+}
 
+/**************************************************************************/
+/*! 
+    @brief  Returns length of an NKK strip - a part of the NKK image which depends on a whole number of GFX rows (Landscape) 
+	        or 8 row layers (Portrait) only, so it can be converted on its own. 
+	@return Strip length in bytes - a row (_w/8) in Landscape, a column of 8*8 bit blocks (_h) in Portrait. 
+*/
+/**************************************************************************/
+uint8_t NKK_SmartDisplayLCD::getStripLength(void){
+	if (_w>=_h) {
+		return _w/8;
+	}
+	return _h;
+}
 
-    uint16_t HeightInRows = _h;
+/**************************************************************************/
+/*! 
+    @brief  Converts one NKK strip of an image from GFX format to NKK native format. 
+	@param  imageBufferGFX[] An array with an image arranged as per the GFX format.  
+	@param  strip Strip number, 0 is the first strip of the NKK image. 
+	@param  stripNKK[] An array for the strip in NKK native format, getStripLength() bytes.  
+*/
+/**************************************************************************/
+void NKK_SmartDisplayLCD::convertStripGFX2NKK(byte imageBufferGFX[], uint16_t strip, byte stripNKK[]){
+	
+	uint16_t HeightInRows = _h;
 	uint16_t WidthInBytes = _w/8;
 
-	
  if (_w>=_h) {
-  //this is Landscape		
-			//swap bytes in every row      
-			//for each row 
-			 for (uint16_t i = 0; i<HeightInRows; i++) 
-			 {
-						 // for each column  - swap bytes 
-						  for (uint16_t j = 0; j<WidthInBytes; j++) {
-							imageBufferNKK[i*WidthInBytes+WidthInBytes-j-1] = imageBufferGFX[i*WidthInBytes+j];
-							//[i*WidthInBytes+WidthInBytes-j-1] : number of bytes in all full rows plus another full row minus current position in the row 
-							//[i*WidthInBytes+j]   :             number of bytes in all full rows plus current position in the row   
-							//Serial.print("converter1: i="); Serial.print(i);  Serial.print(" j="); Serial.println(j);
-							//Serial.print("converter1: source="); Serial.print(i*WidthInBytes+j);  Serial.print(" destination="); Serial.println(i*WidthInBytes+WidthInBytes-j-1);
-						  }
-		  
-			 } 
-			 
-			 
-	
+  //this is Landscape - a strip is a row, swap bytes in the row 
+	  byte *row = imageBufferGFX + strip*WidthInBytes;
+	  for (uint16_t j = 0; j<WidthInBytes; j++) {
+		stripNKK[WidthInBytes-j-1] = row[j];
+	  }
    }
    else {
-   //this is Portrait
-     
-	 //Divide picture to 8 bytes (8*8 bit block) and convert them using bitwise operations
-	 
-		uint16_t numOfLayers=_h/8; //number of layers of blocks
-		uint16_t blocksPerLayer=_w/8; //number of 8bit*8bit blocks per layer 
+   //this is Portrait - a strip is a column of 8*8 bit blocks, transpose every block 
+   
+		uint16_t numOfLayers=HeightInRows/8; //number of layers of blocks
+		uint16_t blocksPerLayer=WidthInBytes; //number of 8bit*8bit blocks per layer 
 
-            //Array  - collection of "vertical" layers
+            //Layer - "horisontal" line of blocks, block "strip" of every layer 
             for (uint16_t l = 0; l<numOfLayers; l++) {
-                
-                        //Layer - "horisontal" line of blocks 
-						uint16_t layerStartGFX=8*blocksPerLayer*l; //8 bytes per block 
-                        uint16_t layerStartNKK=1*l;  // just 1 byte vertical shift
-						//Serial.print("l:"); Serial.print(l); Serial.print(" layerStartGFX="); Serial.print(layerStartGFX); Serial.print(" layerStartNKK="); Serial.println(layerStartNKK);
-						
-                        for (uint16_t b = 0; b<blocksPerLayer; b++) {
+                        //Block  - 64 bits, 8 "horisontal" GFX bytes (blocksPerLayer apart) and 8 "vertical" NKK bytes (numOfLayers apart)
+                        uint16_t blockStartGFX=8*blocksPerLayer*l + strip; //8 bytes per block, 1 byte horisontal shift 
+                        uint16_t blockStartNKK=l;  // just 1 byte vertical shift
 						
-						        //Block  - 64 bits, 8 "horisontal" GFX bytes and 8 "vertical" NKK bytes 
-                                uint16_t blockStartGFX=layerStartGFX + 1*b ; // just 1 byte horisontal shift 
-                                uint16_t blockStartNKK=layerStartNKK + 8*numOfLayers*b ;//  8 bit shift per layer 
-                                //Serial.print("b:"); Serial.print(b); Serial.print(" blockStartGFX="); Serial.print(blockStartGFX); Serial.print(" blockStartNKK="); Serial.println(blockStartNKK);
-						   
-                                for (uint8_t s = 0; s<8; s++) {
-                                               
-										//Sub block - conversion of each bit in the block bytes
-										uint16_t subBlockStartGFX=blockStartGFX;
-										uint16_t subBlockStartNKK=blockStartNKK+s*numOfLayers;
-										//Serial.print("s:"); Serial.print(s); Serial.print(" subBlockStartGFX="); Serial.print(subBlockStartGFX); Serial.print(" subBlockStartNKK="); Serial.println(subBlockStartNKK);
-                                        
-																				
-										//setting an NKK byte 
-										  //Variable S is a number of NKK byte in the block from  left(0) to right (7) 
-										  // subBlockStartNKK is NKK adress in the NKK array  for the target NKK byte 
-										  // subBlockStartGFX is GFX adress  in the GFX array  for the first GFX byte in the block.  
-										  // Other GFX bytes adresses are subBlockStartGFX+ +blocksPerLayer*ByteNumberInTheBlock   ( 0-top, 7 - bottom )    
-										  // Variable i is a number of bit in the NKK byte from 0 (bottom bit) to 7 (top bit) 
-										byte targetByte=imageBufferNKK[subBlockStartNKK];
-										byte sourceByte=0;
-										byte mask0=0;
-										byte mask1=0;
-										
-										   //Setting bits in each NKK byte 
-											for (uint8_t i = 0; i<8; i++) {
-											
-											//Source Byte for each NKK bit: 
-											// for NKK bit 0: last GFX byte in the block : i=0,  GFXIndex=subBlockStartGFX+blocksPerLayer*7 = subBlockStartGFX+28
-											// for NKK bit 7: first GfX byte in the block: i=7,  GFXIndex=subBlockStartGFX        										
-											sourceByte= imageBufferGFX[subBlockStartGFX+blocksPerLayer*(7-i)];
-											
-											//Serial.print("i:"); Serial.print(i); Serial.print("step1       "); Serial.print(" GFXindex="); Serial.print(subBlockStartGFX+blocksPerLayer*(7-i)); Serial.print(" NKKindex="); Serial.print(subBlockStartNKK);  Serial.print(" GFX[]=");  Serial.print(sourceByte); Serial.print(" NKK[]=");  Serial.println(targetByte);
-											
-											//Set target bit i to 1 in NKK  - moving target bit=1, other bits are as they are.  So do OR with mask like 000010000 to get the target as 111x1111
-											mask0=1<<i; // orig math expression:2^i or bit shift as 1<<i
-											targetByte=targetByte | mask0;
-											
-											//Serial.print("i:"); Serial.print(i); Serial.print("step2-mask0 "); Serial.print(" GFXindex="); Serial.print(subBlockStartGFX+blocksPerLayer*(7-i)); Serial.print(" NKKindex="); Serial.print(subBlockStartNKK);  Serial.print(" GFX[]=");  Serial.print(sourceByte); Serial.print(" NKK[]=");  Serial.print(targetByte);Serial.print(" mask0=");  Serial.println(mask0);
-											
-											//Shift source byte accordingly  - for first byte in NKK block use bit 0 from GFX,  for last NKK byte use bit 7 as "bit in use" which will be copied to target
-											sourceByte=sourceByte>>s;
-											
-											
-											//Serial.print("i:"); Serial.print(i); Serial.print("step3-  >>s "); Serial.print(" GFXindex="); Serial.print(subBlockStartGFX+blocksPerLayer*(7-i)); Serial.print(" NKKindex="); Serial.print(subBlockStartNKK);  Serial.print(" GFX[]=");  Serial.print(sourceByte); Serial.print(" NKK[]=");  Serial.println(targetByte);
-											
-											
-											//Place bit in use of the source to bit i  in the target (at this step we "rotating" the source byte)
-											   //a)shift bit in use of the source to bit i  in the source 
-												 sourceByte=sourceByte<<i;
-											
-											      //Serial.print("i:"); Serial.print(i); Serial.print("step4-  <<i "); Serial.print(" GFXindex="); Serial.print(subBlockStartGFX+blocksPerLayer*(7-i)); Serial.print(" NKKindex="); Serial.print(subBlockStartNKK);  Serial.print(" GFX[]=");  Serial.print(sourceByte); Serial.print(" NKK[]=");  Serial.println(targetByte);
-											
-												//b)make unused source bits as 1 so we can do AND later.  So do OR with mask like 11101111  to get the source as 111x1111
-												  mask1=~(1<<i);//255 - (1<<i); //inverted mask0
-												  sourceByte=sourceByte | mask1;
-
-											      //Serial.print("i:"); Serial.print(i); Serial.print("step5-mask1 "); Serial.print(" GFXindex="); Serial.print(subBlockStartGFX+blocksPerLayer*(7-i)); Serial.print(" NKKindex="); Serial.print(subBlockStartNKK);  Serial.print(" GFX[]=");  Serial.print(sourceByte); Serial.print(" NKK[]=");  Serial.print(targetByte); Serial.print(" mask1=");  Serial.println(mask1);
-
-								
-												//c)bits are aligned, do AND with source and target  and get the bit i set in the target, other target bits are intact 
-												 targetByte=targetByte & sourceByte;
-												 
-											     //Serial.print("i:"); Serial.print(i); Serial.print("step6- tORs "); Serial.print(" GFXindex="); Serial.print(subBlockStartGFX+blocksPerLayer*(7-i)); Serial.print(" NKKindex="); Serial.print(subBlockStartNKK);  Serial.print(" GFX[]=");  Serial.print(sourceByte); Serial.print(" NKK[]=");  Serial.println(targetByte);											 
-											
-											//Write the target byte back to NKK array
-											imageBufferNKK[subBlockStartNKK]=targetByte;
-										
-										}
-										
-										
-										
-										
-                                }     
-                        }
+						transpose8x8(imageBufferGFX + blockStartGFX, blocksPerLayer, stripNKK + blockStartNKK, numOfLayers);
                 }
-
  }	
-
-//Serial.print("NKK_SmartDisplayLCD::convertGFX2NKK:finished, taken millis:"); Serial.println(millis() -	startTime);			 
 }
 
-  /**************************************************************************/
+/**************************************************************************/
 /*! 
-    @brief  Converts data in NKK image buffer so the image is rotated 180 degrees.
-	@param  imageBufferNKK[] An array with an image arranged as per the NKK native format.  
+    @brief  Converts one byte of an image from GFX format to NKK native format, for transports which send an image byte by byte. 
+	@param  imageBufferGFX[] An array with an image arranged as per the GFX format.  
+	@param  i Byte number in the NKK image.  
+	@return The byte of the image in NKK native format.  
 */
 /**************************************************************************/
-void NKK_SmartDisplayLCD::rotate180_NKK(byte imageBufferNKK[]) { 
- 	 //Divide picture to layers of bytes and convert them using bitwise operations
-		 //last byte in array become first byte
-		 //layers become mirrored 
-		 //byte bits get reversed 
+byte NKK_SmartDisplayLCD::convertByteGFX2NKK(byte imageBufferGFX[], uint16_t i){
+	
+	uint16_t WidthInBytes = _w/8;
 
-	//Serial.println("NKK_SmartDisplayLCD::rotate180_NKK:started");	 
-		 
- 
-		uint8_t numOfLayers=_h; //number of layers 
-	    uint8_t blocksPerLayer=_w/8; //number of bytes per layer 
-		
+ if (_w>=_h) {
+  //this is Landscape - bytes are swapped in every row 
+	  uint16_t rowStart = i - i % WidthInBytes;
+	  return imageBufferGFX[rowStart + WidthInBytes - 1 - i % WidthInBytes];
+   }
+   
+   //this is Portrait - NKK byte s of a block gets bit s of the 8 GFX bytes of the block, top one goes to bit 7 
+   uint16_t numOfLayers=_h/8; 
+   uint16_t strip = i / _h; 
+   uint16_t s = (i % _h) / numOfLayers; 
+   uint16_t l = (i % _h) % numOfLayers; 
+   byte *src = imageBufferGFX + 8*WidthInBytes*l + strip; 
+   byte b = 0;
+   for (uint8_t r = 0; r<8; r++) {
+		b = (b << 1) | ((src[r*WidthInBytes] >> s) & 1);
+   }
+   return b;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Converts a rectangle of a canvas to NKK native format into imageBufferNKK in one pass, without imageBufferGFX.  
+	@param  canvas[] Canvas buffer - rows of (canvasW+7)/8 bytes, pixel x of a row is bit (7-x%8) of byte x/8 (MSB first, 
+	        as Adafruit GFXcanvas1 getBuffer()).  
+	@param  canvasW Canvas width in pixels.  
+	@param  canvasH Canvas height in pixels.  
+	@param  x Left edge of the rectangle on the canvas, may be negative.  
+	@param  y Top edge of the rectangle on the canvas, may be negative. The rectangle is _w*_h pixels.  
+	@return false if imageBufferNKK cannot be allocated, true otherwise 
+	@note   Rotation of the object is applied as for imageBufferGFX i.e. pixel (x,y) of the canvas is pixel (0,0) of the key. 
+	        Pixels of the rectangle outside of the canvas are cleared. Use display_NKK() to upload the image. 
+	        In the single buffer mode imageBufferNKK is allocated and the mode is switched off.
+*/
+/**************************************************************************/
+bool NKK_SmartDisplayLCD::convertCanvas2NKK(const byte canvas[], uint16_t canvasW, uint16_t canvasH, int16_t x, int16_t y){
+	
+	if (!setSingleBuffer(false)) {
+		return false; //no RAM for imageBufferNKK
+	}
+	
+	uint16_t HeightInRows = _h;
+	uint16_t WidthInBytes = _w/8;
+	
+ if (_w>=_h) {
+  //this is Landscape - NKK byte j of a row is GFX byte (WidthInBytes-1-j) i.e. 8 canvas pixels with bits reversed 
+	  for (uint16_t i = 0; i<HeightInRows; i++) {
+		  byte *row = imageBufferNKK + i*WidthInBytes;
+		  for (uint16_t j = 0; j<WidthInBytes; j++) {
+			row[WidthInBytes-j-1] = reverseByte(readCanvasByte(canvas, canvasW, canvasH, x + 8*j, y + i));
+		  }
+	  }
+   }
+   else {
+   //this is Portrait - collect 8 canvas bytes of a block as GFX bytes and transpose them 
+		uint16_t numOfLayers=HeightInRows/8; 
+		uint16_t blocksPerLayer=WidthInBytes; 
+		byte block[8];
 		
-		    //Array  - collection of "vertical" layers. Cycle through the first half of them and swap the bytes 
-            for (uint8_t l = 0; l<(numOfLayers/2); l++) {
-                
-                        //Layer - "horisontal" line of bytes
-                        uint8_t layer1StartNKK=blocksPerLayer*l;  // just 1 byte vertical shift down
-						uint8_t layer2StartNKK=_imageBufferLength - blocksPerLayer - blocksPerLayer*l;  // just 1 byte vertical shift up
-						//Serial.print("l:"); Serial.print(l); Serial.print(" layer1StartNKK="); Serial.print(layer1StartNKK); Serial.print(" layer2StartNKK="); Serial.println(layer2StartNKK);
-						
-				
-						// bytes in the layer  
-                        for (uint8_t b = 0; b<blocksPerLayer; b++) {
-						     uint8_t index1 =layer1StartNKK + b;  //array index for the original byte 
-							 uint8_t index2 = layer2StartNKK + blocksPerLayer - b-1; //array index for the mirrored byte 
-                            //Serial.print("b:"); Serial.print(b); Serial.print(" index1="); Serial.print(index1); Serial.print(" index2="); Serial.println(index2);
-		                      
-							//swap the bytes and reverse them 
-							uint8_t tmpByte=imageBufferNKK[index2];
-							imageBufferNKK[index2]=reverseByte(imageBufferNKK[index1]);
-							imageBufferNKK[index1]=reverseByte(tmpByte);
-
-                        }
-						
-			}			
+		for (uint16_t l = 0; l<numOfLayers; l++) {
+			for (uint16_t b = 0; b<blocksPerLayer; b++) {
+				for (uint8_t r = 0; r<8; r++) {
+					block[r] = reverseByte(readCanvasByte(canvas, canvasW, canvasH, x + 8*b, y + 8*l + r));
+				}
+				transpose8x8(block, 1, imageBufferNKK + l + 8*numOfLayers*b, numOfLayers);
+			}
+		}
+ }
+ return true;
+}
 
-						
-	//Serial.println("NKK_SmartDisplayLCD::rotate180_NKK:started:finished"); 					
+//Reads 8 pixels of a canvas row starting at x, MSB first (bit 7 is pixel x), pixels outside of the canvas are 0
+byte NKK_SmartDisplayLCD::readCanvasByte(const byte canvas[], uint16_t canvasW, uint16_t canvasH, int16_t x, int16_t y){
+	if (y < 0 || y >= (int16_t) canvasH || x <= -8 || x >= (int16_t) canvasW) {
+		return 0;
+	}
+	uint16_t rowBytes = (canvasW + 7) / 8;
+	const byte *row = canvas + (uint16_t) y * rowBytes;
+	
+	if (x >= 0 && x + 8 <= (int16_t) canvasW) {
+		//whole byte inside the canvas - one or two byte reads 
+		uint8_t bitShift = x % 8;
+		if (bitShift == 0) {
+			return row[x / 8];
+		}
+		return (row[x / 8] << bitShift) | (row[x / 8 + 1] >> (8 - bitShift));
+	}
+	
+	//canvas edge - pixel by pixel 
+	byte b = 0;
+	for (uint8_t k = 0; k<8; k++) {
+		int16_t px = x + k;
+		if (px >= 0 && px < (int16_t) canvasW && (row[px / 8] & (0x80 >> (px % 8)))) {
+			b |= 0x80 >> k;
+		}
+	}
+	return b;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Draws a character of an NKK font directly into imageBufferNKK[].  
+	@param  font A reference (pointer) to NKKfont, generated by fontconvert with -l (Landscape) or -p (Portrait) option.  
+	@param  x Cursor x coordinate.  
+	@param  y Cursor y coordinate, the baseline of the text.  
+	@param  c The character.  
+	@param  color 0 - clear pixels of the glyph, any other value - set them. Other pixels are not changed.  
+	@return Cursor x coordinate for the next character, x if the character is not in the font  
+	@note   Glyph rows (Landscape) or columns (Portrait) are byte aligned in the font, every glyph byte is ORed into 
+	        at most two bytes of imageBufferNKK[]. Pixels outside of the image are clipped. Glyphs compressed per row 
+	        are decoded byte by byte while they are drawn. In the single buffer mode imageBufferNKK is allocated and the mode is switched off.
+*/
+/**************************************************************************/
+int16_t NKK_SmartDisplayLCD::drawCharNKK(const NKKfont *font, int16_t x, int16_t y, unsigned char c, uint8_t color){
+	
+	uint16_t first = pgm_read_word(&font->first);
+	if (c < first || c > pgm_read_word(&font->last)) {
+		return x;
+	}
+	NKKglyph *glyph = pgm_read_nkkglyph_ptr(font, c - first);
+	NKKglyphReader bitmap;
+	uint8_t w = pgm_read_byte(&glyph->width);
+	uint8_t h = pgm_read_byte(&glyph->height);
+	int16_t gx = x + (int8_t) pgm_read_byte(&glyph->xOffset);
+	int16_t gy = y + (int8_t) pgm_read_byte(&glyph->yOffset);
+	int16_t next = x + pgm_read_byte(&glyph->xAdvance);
+	
+	bool isLandscape = (_w>=_h);
+	if (isLandscape != (pgm_read_byte(&font->orientation) == NKKfont_Landscape) || !setSingleBuffer(false)) {
+		return next;
+	}
+	
+ if (isLandscape) {
+	//glyph rows go to NKK rows, a row is LSB first in the font 
+	uint8_t rowBytes = (w + 7) / 8;
+	uint8_t lineBytes = _w/8;
+	nkkglyph_begin(&bitmap, font, glyph, rowBytes);
+	for (uint8_t r = 0; r<h; r++) {
+		int16_t Y = gy + r;
+		if (Y >= _h) {
+			break;
+		}
+		for (uint8_t m = 0; m<rowBytes; m++) {
+			byte bits = nkkglyph_read(&bitmap); //bytes are read in order, compressed glyphs are decoded on the fly
+			if (Y >= 0) {
+				stampByteNKK(imageBufferNKK + Y*lineBytes, lineBytes, gx + 8*m, bits, color);
+			}
+		}
+	}
+ }
+ else {
+	//glyph columns go to NKK rows (GFX columns), a column is MSB first in the font 
+	uint8_t colBytes = (h + 7) / 8;
+	uint8_t lineBytes = _h/8;
+	nkkglyph_begin(&bitmap, font, glyph, colBytes);
+	for (uint8_t col = 0; col<w; col++) {
+		int16_t X = gx + col;
+		if (X >= _w) {
+			break;
+		}
+		for (uint8_t m = 0; m<colBytes; m++) {
+			byte bits = nkkglyph_read(&bitmap); //bytes are read in order, compressed glyphs are decoded on the fly
+			if (X >= 0) {
+				stampByteNKK(imageBufferNKK + X*lineBytes, lineBytes, gy + 8*m, bits, color);
+			}
+		}
+	}
+ }
+ return next;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Draws a single line text of an NKK font directly into imageBufferNKK[].  
+	@param  font A reference (pointer) to NKKfont, generated by fontconvert with -l (Landscape) or -p (Portrait) option.  
+	@param  x Cursor x coordinate.  
+	@param  y Cursor y coordinate, the baseline of the text.  
+	@param  text Zero terminated string.  
+	@param  color 0 - clear pixels of the glyphs, any other value - set them.  
+	@return Cursor x coordinate after the text  
+*/
+/**************************************************************************/
+int16_t NKK_SmartDisplayLCD::drawTextNKK(const NKKfont *font, int16_t x, int16_t y, const char *text, uint8_t color){
+	while (*text) {
+		x = drawCharNKK(font, x, y, (unsigned char) *text++, color);
+	}
+	return x;
+}
+
+//ORs (color) or clears (!color) 8 pixels starting at pixel pos of an NKK row - pixel i of bits is pixel pos+i. 
+//Landscape: the row is a big endian number, pixel x is bit x and bits are LSB first. 
+//Portrait: the row is a GFX column, pixel y is bit 7-y%8 of byte y/8 and bits are MSB first.
+void NKK_SmartDisplayLCD::stampByteNKK(byte line[], uint8_t lineBytes, int16_t pos, byte bits, uint8_t color){
+	if (bits == 0 || pos <= -8 || pos >= 8*lineBytes) {
+		return;
+	}
+	int16_t index = (pos + 8) / 8 - 1; //rounded down for negative pos
+	uint8_t shift = pos - 8*index;
+	bool isLandscape = (_w>=_h);
+	
+	for (uint8_t part = 0; part < 2; part++, index++) {
+		byte b;
+		if (isLandscape) {
+			b = part ? ((shift) ? bits >> (8 - shift) : 0) : bits << shift;
+		}
+		else {
+			b = part ? ((shift) ? bits << (8 - shift) : 0) : bits >> shift;
+		}
+		if (b == 0 || index < 0 || index >= lineBytes) {
+			continue;
+		}
+		byte *target = isLandscape ? &line[lineBytes - 1 - index] : &line[index];
+		if (color) {
+			*target |= b;
+		}
+		else {
+			*target &= ~b;
+		}
+	}
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Transposes an 8*8 bit block from GFX format to NKK native format (Portrait). 
+	        NKK byte s gets bit s of GFX bytes 0..7, GFX byte 0 (top) goes to bit 7.
+	@param  src[] First GFX byte of the block (top row).  
+	@param  srcStride Distance between GFX bytes of the block in bytes.  
+	@param  dst[] First NKK byte of the block.  
+	@param  dstStride Distance between NKK bytes of the block in bytes.  
+*/
+/**************************************************************************/
+void NKK_SmartDisplayLCD::transpose8x8(byte src[], uint8_t srcStride, byte dst[], uint8_t dstStride) { 
+	//Packed 8x8 bit matrix transpose (Hacker's Delight, transpose8rS32) - three swap steps of 1, 2 and 4 bit sub blocks instead of 64 single bit moves
+	uint32_t x = ((uint32_t) src[0] << 24) | ((uint32_t) src[srcStride] << 16) | ((uint32_t) src[2*srcStride] << 8) | src[3*srcStride];
+	uint32_t y = ((uint32_t) src[4*srcStride] << 24) | ((uint32_t) src[5*srcStride] << 16) | ((uint32_t) src[6*srcStride] << 8) | src[7*srcStride];
+	uint32_t t;
+	
+	t = (x ^ (x >> 7)) & 0x00AA00AA;  x = x ^ t ^ (t << 7);
+	t = (y ^ (y >> 7)) & 0x00AA00AA;  y = y ^ t ^ (t << 7);
+	t = (x ^ (x >> 14)) & 0x0000CCCC;  x = x ^ t ^ (t << 14);
+	t = (y ^ (y >> 14)) & 0x0000CCCC;  y = y ^ t ^ (t << 14);
+	t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+	y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+	x = t;
+	
+	//transposed byte i holds bit (7-i) of the source bytes, so NKK byte s is transposed byte (7-s)
+	dst[7*dstStride] = x >> 24;
+	dst[6*dstStride] = x >> 16;
+	dst[5*dstStride] = x >> 8;
+	dst[4*dstStride] = x;
+	dst[3*dstStride] = y >> 24;
+	dst[2*dstStride] = y >> 16;
+	dst[1*dstStride] = y >> 8;
+	dst[0]           = y;
  }
  
 /**************************************************************************/
@@ -374,18 +639,33 @@ void NKK_SmartDisplayLCD::setColourNKK(byte data) {
 */
 /**************************************************************************/ 	  
 void NKK_SmartDisplayLCD::setColourRGB(byte R, byte G, byte B) {
-	 //map and constrain to 2 bit each 
-	 R = map (R, 0,255, 0, 3);
-     G = map (G,0,255, 0, 3);
-	 B = map (B,0,255, 0, 3);
+	//convert and set the colour  
+    setColourNKK(convertRGB2NKK(R, G, B));
+	 }  
+
+ /**************************************************************************/
+/*! 
+    @brief  Converts a colour specified as RGB to a closest available colour in NKK format.  
+	        Each channel is rounded to the closest of the levels 0, 85, 170 and 255 with a lookup table.  
+	@param  A byte to define Red component.  
+	@param  A byte to define Green component.  
+	@param  A byte to define Blue component.  
+	@return A byte to define colour in NKK format (RRGGBBxx). 
+*/
+/**************************************************************************/ 	  
+byte NKK_SmartDisplayLCD::convertRGB2NKK(byte R, byte G, byte B) {
+	 //closest 2 bit level of each channel from the table, no multiply or divide 
+	 R = pgm_read_byte(colourLevel + R);
+     G = pgm_read_byte(colourLevel + G);
+	 B = pgm_read_byte(colourLevel + B);
 	 
 	 //shift bits to fit NKK format
 	 R=R<<6;
 	 G=G<<4;
 	 B=B<<2;
 	 
-	//combine all together and set the colour  
-    setColourNKK(R | G | B);
+	//combine all together 
+    return (R | G | B);
 	 }  
 	 
  /**************************************************************************/
@@ -409,21 +689,22 @@ void NKK_SmartDisplayLCD::setBrightness(byte data) {
  void NKK_SmartDisplayLCD::display(void) {
         //Serial.println("NKK_SmartDisplayLCD::display started");
 		
-		 //convert GFX image to native NKK one 
-		 convertGFX2NKK(imageBufferGFX, imageBufferNKK);
-		 
-		//rotation and send to SPI
-		if (_isRotate180) {
-			rotate180_NKK(imageBufferNKK);
-			sendImageToSPI(imageBufferNKK, _imageBufferLength);
-			} 
+		if (imageBufferGFX == NULL) {
+			return; //no RAM for the image
+		}
+		
+		//image, colour and brightness are sent in one transaction 
+		if (imageBufferNKK == NULL || !unshareImageBufferNKK()) {
+			//single buffer mode (or no RAM for a copy of a shared frame) - send to SPI converting GFX image to native NKK one on the fly
+			sendFrameToSPI(imageBufferGFX, _imageBufferLength, true);
+		}
 		else {
-			sendImageToSPI(imageBufferNKK, _imageBufferLength);
-			}
-		 
-		//set colour and brightness
-		setColourNKK(bkgColour);
-		setBrightness(bkgBrightnes);
+			 //convert GFX image to native NKK one 
+			 convertGFX2NKK(imageBufferGFX, imageBufferNKK);
+			 
+			//send to SPI, 180 degree rotation is applied on the fly
+			sendFrameToSPI(imageBufferNKK, _imageBufferLength, false);
+		}
 		 
         //Serial.println("NKK_SmartDisplayLCD::display finished");		 
 	}
@@ -435,24 +716,200 @@ void NKK_SmartDisplayLCD::setBrightness(byte data) {
 /**************************************************************************/	
 void NKK_SmartDisplayLCD::display_NKK(void) {
 		//Serial.println("NKK_SmartDisplayLCD::display_NKK started");
+		
+		if (imageBufferNKK == NULL) {
+			display(); //single buffer mode
+			return;
+		}
 		 
-		//rotation and send to SPI 
-		if (_isRotate180) {
-			rotate180_NKK(imageBufferNKK);
-			sendImageToSPI(imageBufferNKK, _imageBufferLength);
-			} 
-		else {
-			sendImageToSPI(imageBufferNKK, _imageBufferLength);
-			}
+		//send to SPI with colour and brightness in one transaction, 180 degree rotation is applied on the fly so imageBufferNKK is not changed
+		sendFrameToSPI(imageBufferNKK, _imageBufferLength, false);
 
 			 //Serial.println("NKK_SmartDisplayLCD::display_NKK finished");
+		}	
+		
+/**************************************************************************/
+/*! 
+    @brief  Broadcasts a picture in GFX format i.e. converts imageBufferGFX of this object to NKK format and uploads it 
+	        to all keys at once, sets colour and brightness of this object on all keys.
+	@param  keys[] An array of pointers to NKK_SmartDisplayLCD objects to be updated. 
+	@param  numKeys Number of elements in keys[]. 
+	@return Number of NKK devices updated.  
+	@note   Keys shall share the SPI object and image size of this object, other keys are skipped. Each key's rotation setting is respected.
+*/
+/**************************************************************************/ 
+uint8_t NKK_SmartDisplayLCD::broadcast(NKK_SmartDisplayLCD *keys[], uint8_t numKeys) {
+	
+		if (imageBufferGFX == NULL) {
+			return 0; //no RAM for the image
+		}
+		if (imageBufferNKK == NULL || !unshareImageBufferNKK()) {
+			return broadcastFrame(keys, numKeys, imageBufferGFX, true); //single buffer mode
+		}
+		//convert GFX image to native NKK one 
+		convertGFX2NKK(imageBufferGFX, imageBufferNKK);
+		return broadcastFrame(keys, numKeys, imageBufferNKK, false);
+	}
+
+/**************************************************************************/
+/*! 
+    @brief  Broadcasts a picture in NKK format i.e. uploads imageBufferNKK of this object to all keys at once,  
+	        sets colour and brightness of this object on all keys.
+	@param  keys[] An array of pointers to NKK_SmartDisplayLCD objects to be updated. 
+	@param  numKeys Number of elements in keys[]. 
+	@return Number of NKK devices updated.  
+	@note   Keys shall share the SPI object and image size of this object, other keys are skipped. Each key's rotation setting is respected.
+	        imageBufferNKK of this object is not changed. In the single buffer mode imageBufferGFX is converted on the fly.
+*/
+/**************************************************************************/ 
+uint8_t NKK_SmartDisplayLCD::broadcast_NKK(NKK_SmartDisplayLCD *keys[], uint8_t numKeys) {
+	
+		//image, colour and brightness are sent in one transaction per rotation setting in use
+		if (imageBufferNKK == NULL) {
+			if (imageBufferGFX == NULL) {
+				return 0; //no RAM for the image
+			}
+			return broadcastFrame(keys, numKeys, imageBufferGFX, true); //single buffer mode
+		}
+		return broadcastFrame(keys, numKeys, imageBufferNKK, false);
+	}
+
+/**************************************************************************/
+/*! 
+    @brief  Sets the same background colour on all keys at once.    
+	@param  keys[] An array of pointers to NKK_SmartDisplayLCD objects to be updated. 
+	@param  numKeys Number of elements in keys[]. 
+	@param  A byte to define colour in NKK format (RRGGBBxx). 
+	@return Number of NKK devices updated.  
+	@note   Keys shall share the SPI object of this object, other keys are skipped.
+*/
+/**************************************************************************/ 
+uint8_t NKK_SmartDisplayLCD::broadcastColourNKK(NKK_SmartDisplayLCD *keys[], uint8_t numKeys, byte data) {
+	
+		data=data | 0x03; // apply mask 
+		return broadcastCommandAndData(keys, numKeys, false, NKK_SmartDisplayLCD_Set_RGB, data);
+	}
+
+/**************************************************************************/
+/*! 
+    @brief  Sets the same background colour specified as RGB on all keys at once.  
+	@param  keys[] An array of pointers to NKK_SmartDisplayLCD objects to be updated. 
+	@param  numKeys Number of elements in keys[]. 
+	@param  A byte to define Red component.  
+	@param  A byte to define Green component.  
+	@param  A byte to define Blue component.  
+	@return Number of NKK devices updated.  
+*/
+/**************************************************************************/ 
+uint8_t NKK_SmartDisplayLCD::broadcastColourRGB(NKK_SmartDisplayLCD *keys[], uint8_t numKeys, byte R, byte G, byte B) {
+	
+		return broadcastColourNKK(keys, numKeys, convertRGB2NKK(R, G, B));
+	}
+
+/**************************************************************************/
+/*! 
+    @brief  Sets the same background brightness on all keys at once.    
+	@param  keys[] An array of pointers to NKK_SmartDisplayLCD objects to be updated. 
+	@param  numKeys Number of elements in keys[]. 
+	@param  A byte to define background brightness in NKK format (BBBxxxxx). 
+	@return Number of NKK devices updated.  
+	@note   Keys shall share the SPI object of this object, other keys are skipped.
+*/
+/**************************************************************************/ 
+uint8_t NKK_SmartDisplayLCD::broadcastBrightness(NKK_SmartDisplayLCD *keys[], uint8_t numKeys, byte data) {
+	
+		data=data | 0x1F; // apply mask 
+		return broadcastCommandAndData(keys, numKeys, false, NKK_SmartDisplayLCD_Set_Bright, data);
+	}
+
+/**************************************************************************/
+/*! 
+    @brief  Sets a colour specified as RGB per key, all keys in one transaction. Only the keys whose colour changes are sent a command.
+	@param  keys[] An array of pointers to NKK_SmartDisplayLCD objects to be updated. 
+	@param  numKeys Number of elements in keys[]. 
+	@param  rgb[] Colours of the keys, 3 bytes (Red, Green, Blue) per element of keys[]. 
+	@return Number of NKK devices updated.  
+	@note   Keys shall share the SPI object of this object, other keys are skipped. A key whose closest NKK colour is already 
+	        in its bkgColour is skipped too, use setColourNKK() to send a colour again e.g. after reset().
+*/
+/**************************************************************************/ 
+uint8_t NKK_SmartDisplayLCD::setColoursRGB(NKK_SmartDisplayLCD *keys[], uint8_t numKeys, const byte rgb[]) {
+	
+		uint8_t count = 0;
+		NKK_SmartDisplayLCD *selected = NULL;
+		
+		beginTransaction();
+		for (uint8_t k = 0; k < numKeys; k++) {
+			NKK_SmartDisplayLCD *key = keys[k];
+			if (!isBroadcastTarget(key, false)) {
+				continue;
+			}
+			byte data = convertRGB2NKK(rgb[3*k], rgb[3*k + 1], rgb[3*k + 2]) | 0x03; // apply mask 
+			if (data == (key->bkgColour | 0x03)) {
+				continue; // the key shows that colour already
+			}
+			if (key != selected || key->_isCSPerCommand) {
+				switchCS(selected, key);
+				selected = key;
+			}
+			key->bkgColour = data;
+			_SPI->transfer((byte) NKK_SmartDisplayLCD_Set_RGB);
+			_SPI->transfer((byte) data);
+			count++;
+		}
+		switchCS(selected, NULL);
+		endTransaction();
 		
+		return count;
+	}
+
+/**************************************************************************/
+/*! 
+    @brief  Sends commands to several keys in one transaction. The bus is reserved once and Slave Select is switched only when 
+	        the key changes, so consecutive commands for a key are sent in one Slave Select session (a session each for a key 
+	        with setCSPerCommand() enabled).
+	@param  commands[] An array of commands - key, NKK command and data byte. Group the commands by key for the fewest Slave Select switches.
+	@param  numCommands Number of elements in commands[]. 
+	@return Number of commands sent.  
+	@note   Keys shall share the SPI object of this object, other commands are skipped. Colour and brightness are masked and saved 
+	        into the key variables.
+*/
+/**************************************************************************/ 
+uint8_t NKK_SmartDisplayLCD::sendCommands(const NKK_Command commands[], uint8_t numCommands) {
+	
+		uint8_t count = 0;
+		NKK_SmartDisplayLCD *selected = NULL;
 		
-        //set colour and brightness
-        setColourNKK(bkgColour);
-		setBrightness(bkgBrightnes);
-		}	
+		beginTransaction();
+		for (uint8_t i = 0; i < numCommands; i++) {
+			NKK_SmartDisplayLCD *key = commands[i].key;
+			if (!isBroadcastTarget(key, false)) {
+				continue;
+			}
+			if (key != selected || key->_isCSPerCommand) {
+				switchCS(selected, key);
+				selected = key;
+			}
+			
+			byte data = commands[i].data;
+			if (commands[i].command == NKK_SmartDisplayLCD_Set_RGB) {
+				data = data | 0x03; // apply mask 
+				key->bkgColour = data;
+			}
+			else if (commands[i].command == NKK_SmartDisplayLCD_Set_Bright) {
+				data = data | 0x1F; // apply mask 
+				key->bkgBrightnes = data;
+			}
+			_SPI->transfer((byte) commands[i].command);
+			_SPI->transfer((byte) data);
+			count++;
+		}
+		switchCS(selected, NULL);
+		endTransaction();
 		
+		return count;
+	}
+
  /**************************************************************************/
 /*! 
     @brief  Returns image width as configured for the NKK_SmartDisplayLCD object 
@@ -483,6 +940,239 @@ uint16_t NKK_SmartDisplayLCD::getImageBufferLength(void) {
 return _imageBufferLength;
 }
 
+/**************************************************************************/
+/*!
+    @brief  Sets image rotation on top of the configuration set in the constructor (landscape/portrait and 180 degree flip).  
+    @param  r Rotation in 90 degree steps clockwise, 0-3 (as Adafruit_GFX setRotation()). Rotation 1 and 3 swap width and height. 
+	@note   Nothing is rotated at draw time. Rotation by 90 degrees uses the Portrait (transposed) conversion and rotation by 180 degrees  
+	        is applied while the image is sent to the NKK device. Redraw the image after the rotation is changed.
+*/
+/**************************************************************************/
+void NKK_SmartDisplayLCD::setRotation(uint8_t r) {
+  _rotation = r & 3;
+  
+  //Landscape is rotation 0 of the NKK device and Portrait is rotation 1, the 180 degree flip adds 2
+  uint8_t total = ((_baseW >= _baseH) ? 0 : 1) + _rotation + (_baseRotate180 ? 2 : 0);
+  
+  if (_rotation & 1) {
+    _w = _baseH;
+    _h = _baseW;
+  }
+  else {
+    _w = _baseW;
+    _h = _baseH;
+  }
+  _isRotate180 = ((total & 3) >= 2) ? 1 : 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns image rotation set by setRotation()
+	@return Rotation in 90 degree steps clockwise, 0-3 
+*/
+/**************************************************************************/
+uint8_t NKK_SmartDisplayLCD::getRotation(void) {
+return _rotation;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Switches the single buffer mode on or off. In the single buffer mode imageBufferNKK is released (set to NULL) and display() 
+	        converts imageBufferGFX to NKK format on the fly, strip by strip, while the image is sent to the NKK device.  
+    @param  enable true - single buffer mode, false - both imageBufferGFX and imageBufferNKK are used (default)
+	@return false if imageBufferNKK cannot be allocated, true otherwise
+	@note   Saves _w*_h/8 bytes of RAM per key (256 bytes for 64*32). display() takes the same time as the conversion is done 
+	        while SPI is busy. display_NKK() works as display() in this mode, clear, invert and scroll of imageBufferNKK and 
+	        convertGFX2NKK() do nothing. Drawing in NKK format allocates imageBufferNKK i.e. switches the mode off.
+	        Switching the mode off makes imageBufferNKK writable: a shared frame of NKK_FramePool is copied into an own buffer.
+*/
+/**************************************************************************/
+bool NKK_SmartDisplayLCD::setSingleBuffer(bool enable) {
+  if (enable) {
+    return attachImageBufferNKK(NULL, 0);
+  }
+  _isDoubleBuffer = true;
+  if (imageBufferNKK == NULL) {
+    imageBufferNKK = new byte[_imageBufferLength];
+    if (imageBufferNKK == NULL) {
+      return false;
+    }
+    memset(imageBufferNKK, 0, _imageBufferLength);
+    _isOwnImageBufferNKK = true;
+  }
+  return unshareImageBufferNKK();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Attaches an external (caller owned) array as imageBufferGFX, the own buffer of the object is released.  
+    @param  buffer[] An array for an image in GFX format, NULL - allocate a new own buffer.  
+    @param  length Number of elements (bytes) in buffer[], shall be at least getImageBufferLength().  
+	@return false if buffer[] is too short or a new own buffer cannot be allocated (the current buffer is kept), true otherwise
+	        (also if buffer[] is imageBufferGFX already, nothing is changed then)
+	@note   The array is not cleared and shall stay valid while the object uses it. Several keys of the same size may share one array 
+	        e.g. to mirror the same image.
+*/
+/**************************************************************************/
+bool NKK_SmartDisplayLCD::attachImageBufferGFX(byte buffer[], uint16_t length) {
+  bool isOwn = false;
+  if (buffer != NULL && buffer == imageBufferGFX) {
+    return true; //already attached, the own buffer would be freed below
+  }
+  if (buffer == NULL) {
+    if (_isOwnImageBufferGFX && imageBufferGFX != NULL) {
+      return true;
+    }
+    buffer = new byte[_imageBufferLength];
+    if (buffer == NULL) {
+      return false;
+    }
+    memset(buffer, 0, _imageBufferLength);
+    isOwn = true;
+  }
+  else if (length < _imageBufferLength) {
+    return false;
+  }
+  
+  if (_isOwnImageBufferGFX) {
+    delete[] imageBufferGFX;
+  }
+  _isOwnImageBufferGFX = isOwn;
+  imageBufferGFX = buffer;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Attaches an external (caller owned) array as imageBufferNKK, the own buffer of the object is released.  
+    @param  buffer[] An array for an image in NKK native format, NULL - no buffer i.e. the single buffer mode.  
+    @param  length Number of elements (bytes) in buffer[], shall be at least getImageBufferLength().  
+	@return false if buffer[] is too short (the current buffer is kept), true otherwise (also if buffer[] is imageBufferNKK already, 
+	        nothing is changed then)
+	@note   The array is not cleared and shall stay valid while the object uses it. Keys which are uploaded with display() only may share 
+	        one array as a conversion scratch buffer, imageBufferNKK is converted just before it is sent.
+	        A shared frame of NKK_FramePool the key used is released.
+*/
+/**************************************************************************/
+bool NKK_SmartDisplayLCD::attachImageBufferNKK(byte buffer[], uint16_t length) {
+  if (buffer != NULL && buffer == imageBufferNKK) {
+    return true; //already attached, the own buffer would be freed below
+  }
+  if (buffer != NULL && length < _imageBufferLength) {
+    return false;
+  }
+  
+  if (_isOwnImageBufferNKK) {
+    delete[] imageBufferNKK;
+  }
+  releaseSharedImageBufferNKK();
+  _isOwnImageBufferNKK = false;
+  _isDoubleBuffer = buffer != NULL;
+  imageBufferNKK = buffer;
+  return true;
+}
+
+//Copy on write - gives the object an own copy of a shared (NKK_FramePool) imageBufferNKK before it is changed and releases the shared one.
+//Returns false if the copy cannot be allocated, the shared frame is kept
+bool NKK_SmartDisplayLCD::unshareImageBufferNKK(void) {
+  if (_sharedRefCount == NULL) {
+    return true;
+  }
+  byte *buffer = new byte[_imageBufferLength];
+  if (buffer == NULL) {
+    return false;
+  }
+  memcpy(buffer, imageBufferNKK, _imageBufferLength);
+  releaseSharedImageBufferNKK();
+  imageBufferNKK = buffer;
+  _isOwnImageBufferNKK = true;
+  return true;
+}
+
+//Drops the reference to a shared imageBufferNKK, the pointer itself is left to the caller
+void NKK_SmartDisplayLCD::releaseSharedImageBufferNKK(void) {
+  if (_sharedRefCount != NULL) {
+    (*_sharedRefCount)--;
+    _sharedRefCount = NULL;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns true if the object works in the single buffer mode i.e. imageBufferNKK is not used
+	@return Single buffer mode flag
+*/
+/**************************************************************************/
+bool NKK_SmartDisplayLCD::isSingleBuffer(void) {
+return imageBufferNKK == NULL;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Enables or disables the port register store for the Slave Select pin (resolved in begin()), digitalWrite() is used otherwise
+    @param  enable true - port register store (default), false - digitalWrite()
+	@return false if the core does not provide port registers, digitalWrite() is used then
+*/
+/**************************************************************************/
+bool NKK_SmartDisplayLCD::setFastCS(bool enable) {
+  _isFastCS = enable;
+#if defined(NKK_SmartDisplayLCD_FastIO)
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns true if the Slave Select pin is driven by port register stores, false if digitalWrite() is used
+	@return Fast Slave Select flag, false before begin()
+*/
+/**************************************************************************/
+bool NKK_SmartDisplayLCD::isFastCS(void) {
+#if defined(NKK_SmartDisplayLCD_FastIO)
+  return _isFastCS && _csPort != NULL;
+#else
+  return false;
+#endif
+}
+
+/**************************************************************************/
+/*!
+    @brief  Cycles Slave Select between the commands of an upload i.e. Image Upload, Set RGB and Set Brightness are sent in a Slave Select 
+	        session each, as the library did before. By default one session carries all commands of an upload.
+    @param  enable true - a session per command, false - one session per upload (default)
+	@note   Command after command in one session has not been verified on every NKK device, enable it if colour or brightness is not 
+	        applied after display(). Broadcasts and NKK_ParallelSPI cycle Slave Select if any selected key has it enabled.
+*/
+/**************************************************************************/
+void NKK_SmartDisplayLCD::setCSPerCommand(bool enable) {
+  _isCSPerCommand = enable;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns true if Slave Select is cycled between the commands of an upload
+	@return Slave Select per command flag
+*/
+/**************************************************************************/
+bool NKK_SmartDisplayLCD::isCSPerCommand(void) {
+  return _isCSPerCommand;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Drives the Slave Select signal through a provider (shift registers, I/O expanders) instead of the cspin pin
+    @param  provider Slave Select provider, begin() of the provider shall be called before begin() of this object. NULL - the cspin pin is used.
+	@param  line Line of the provider the Slave Select of this NKK device is connected to
+    @note   The cspin pin is still set up by the constructor, pass a spare pin or SS.
+*/
+/**************************************************************************/
+void NKK_SmartDisplayLCD::setChipSelect(NKK_ChipSelect *provider, uint16_t line) {
+  _csProvider = provider;
+  _csLine = line;
+}
+
 /**************************************************************************/
 /*!
     @brief  Draw a pixel to the imageBufferGFX[]
@@ -493,6 +1183,8 @@ return _imageBufferLength;
 /**************************************************************************/
 void NKK_SmartDisplayLCD::drawPixel( uint8_t x, uint8_t y, uint8_t color)
     {
+      if (imageBufferGFX == NULL) {return;} // no RAM for the image
+	  
       // input data validation 
           if (x > _w -1) {x=_w-1; }   // _w is 1:64 , x is 0:63
           if (y > _h -1) {y=_h-1; }   // _h is 1:32 , y is 0:31
@@ -530,65 +1222,218 @@ void NKK_SmartDisplayLCD::drawPixel( uint8_t x, uint8_t y, uint8_t color)
 /* Image Buffer helpers                                                       */
 /******************************************************************************/	
 void NKK_SmartDisplayLCD::clearImageBufferGFX(void) {
+if (imageBufferGFX == NULL) {return;}
 for(uint16_t i=0; i<_imageBufferLength; i++)
 	   {
 		   imageBufferGFX[i] = 0;
 	   }
 }
 void NKK_SmartDisplayLCD::clearImageBufferNKK(void) {
+if (imageBufferNKK == NULL || !unshareImageBufferNKK()) {return;}
 for(uint16_t i=0; i<_imageBufferLength; i++)
 	   {
 		   imageBufferNKK[i] = 0;
 	   }
 }
 void NKK_SmartDisplayLCD::invertImageBufferGFX(void) {
+if (imageBufferGFX == NULL) {return;}
 for(uint16_t i=0; i<_imageBufferLength; i++)
 	   {
 		   imageBufferGFX[i] = ~imageBufferGFX[i];
 	   }
 }
 void NKK_SmartDisplayLCD::invertImageBufferNKK(void) {
+if (imageBufferNKK == NULL || !unshareImageBufferNKK()) {return;}
 for(uint16_t i=0; i<_imageBufferLength; i++)
 	   {
 		   imageBufferNKK[i] = ~imageBufferNKK[i];
 	   }
 }
 
+/**************************************************************************/
+/*!
+    @brief  Scrolls imageBufferGFX[], vacated pixels are cleared. 
+    @param  dx Number of pixels to shift the image to the right, negative - to the left 
+    @param  dy Number of pixels to shift the image down, negative - up
+*/
+/**************************************************************************/
+void NKK_SmartDisplayLCD::scrollImageBufferGFX(int16_t dx, int16_t dy) {
+  if (imageBufferGFX == NULL) {
+    return;
+  }
+     //GFX format - a row is a little endian number with pixel x at bit x, rows go top to bottom 
+     shiftBitsInRows(imageBufferGFX, _h, _w/8, dx, false);
+     shiftRows(imageBufferGFX, _h, _w/8, dy);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Scrolls imageBufferNKK[] directly in NKK native format (no conversion), vacated pixels are cleared. 
+    @param  dx Number of pixels to shift the image to the right, negative - to the left 
+    @param  dy Number of pixels to shift the image down, negative - up
+	@note   Directions are as per the GFX image i.e. the same as for scrollImageBufferGFX()
+*/
+/**************************************************************************/
+void NKK_SmartDisplayLCD::scrollImageBufferNKK(int16_t dx, int16_t dy) {
+  if (imageBufferNKK == NULL || !unshareImageBufferNKK()) {
+    return;
+  }
+  if (_w>=_h) {
+     //Landscape - a row is a big endian number (bytes swapped vs GFX) with pixel x at bit x, rows go top to bottom 
+     shiftBitsInRows(imageBufferNKK, _h, _w/8, dx, true);
+     shiftRows(imageBufferNKK, _h, _w/8, dy);
+  }
+  else {
+     //Portrait - an NKK row is a GFX column x, a big endian number with pixel y at bit (_h-1-y) 
+     shiftBitsInRows(imageBufferNKK, _w, _h/8, -dy, true);
+     shiftRows(imageBufferNKK, _w, _h/8, dx);
+  }
+}
+
+//Moves rows of a buffer by n rows towards the end of the buffer (negative n - towards the beginning), vacated rows are cleared 
+void NKK_SmartDisplayLCD::shiftRows(byte buffer[], uint16_t numRows, uint8_t rowBytes, int16_t n) {
+  if (n == 0) {
+    return;
+  }
+  uint16_t shift = (n > 0) ? n : -n; 
+  if (shift > numRows) {shift = numRows;}
+  uint16_t shiftBytes = shift * rowBytes;
+  uint16_t length = numRows * rowBytes;
+  
+  if (n > 0) {
+    memmove(buffer + shiftBytes, buffer, length - shiftBytes);
+    memset(buffer, 0, shiftBytes);
+  }
+  else {
+    memmove(buffer, buffer + shiftBytes, length - shiftBytes);
+    memset(buffer + length - shiftBytes, 0, shiftBytes);
+  }
+}
+
+//Shifts every row of a buffer as a number by n bits towards its most significant bit (negative n - towards the least significant one), 
+//using byte shifts with carry. isBigEndian - the most significant byte is the first byte of the row (NKK), otherwise the last one (GFX)
+void NKK_SmartDisplayLCD::shiftBitsInRows(byte buffer[], uint16_t numRows, uint8_t rowBytes, int16_t n, bool isBigEndian) {
+  if (n == 0) {
+    return;
+  }
+  uint16_t shift = (n > 0) ? n : -n; 
+  if (shift > rowBytes * 8) {shift = rowBytes * 8;}
+  uint8_t byteShift = shift / 8;
+  uint8_t bitShift = shift % 8;
+  
+  for (uint16_t r = 0; r < numRows; r++) {
+    byte *row = buffer + r * rowBytes;
+    
+    //j is the byte significance, 0 is the least significant byte of the row
+    if (n > 0) {
+      for (int16_t j = rowBytes - 1; j >= 0; j--) {
+        int16_t src = j - byteShift;
+        byte hi = (src >= 0) ? row[isBigEndian ? rowBytes - 1 - src : src] : 0;
+        byte lo = (src - 1 >= 0) ? row[isBigEndian ? rowBytes - src : src - 1] : 0;
+        row[isBigEndian ? rowBytes - 1 - j : j] = bitShift ? (hi << bitShift) | (lo >> (8 - bitShift)) : hi;
+      }
+    }
+    else {
+      for (int16_t j = 0; j < rowBytes; j++) {
+        int16_t src = j + byteShift;
+        byte lo = (src < rowBytes) ? row[isBigEndian ? rowBytes - 1 - src : src] : 0;
+        byte hi = (src + 1 < rowBytes) ? row[isBigEndian ? rowBytes - 2 - src : src + 1] : 0;
+        row[isBigEndian ? rowBytes - 1 - j : j] = bitShift ? (lo >> bitShift) | (hi << (8 - bitShift)) : lo;
+      }
+    }
+  }
+}
+
 /******************************************************************************/
 /* actual read/write functions for SPI interface                              */
 /******************************************************************************/
 
-//Function to write a NKK Image Upload command and an array to SPI
-void NKK_SmartDisplayLCD::sendImageToSPI(byte buffer[], uint16_t length)
+//Function to write a NKK Image Upload command, an array, colour and brightness to SPI in one transaction. 
+//Slave Select is toggled once, or per command if setCSPerCommand() is enabled
+void NKK_SmartDisplayLCD::sendFrameToSPI(byte buffer[], uint16_t length, bool isGFX)
 {
-//Serial.println("NKK_SmartDisplayLCD::sendImageToSPI: array will be transferred");
+//Serial.println("NKK_SmartDisplayLCD::sendFrameToSPI: array will be transferred");
+
+ bkgColour = bkgColour | 0x03; // apply masks, save settings into the class variables
+ bkgBrightnes = bkgBrightnes | 0x1F;
 	 
- digitalWrite(_cs, LOW); // enable Slave Select
+ writeCS(LOW); // enable Slave Select
  beginTransaction();
 
- _SPI->transfer((byte) NKK_SmartDisplayLCD_Img_Upload) ; 
-  //Serial.println((byte) NKK_SmartDisplayLCD_Img_Upload);
-
-  for (int i = 0; i < length; i++) {
-   _SPI->transfer((byte) buffer[i] ); //Send the array element  over SPI
- //Serial.print(i);  Serial.print(":"); Serial.println((byte) buffer[i]);
- }  
-
+ transferImage(buffer, length, _isRotate180, isGFX);
+ nextCommand();
+ transferColourAndBrightness(bkgColour, bkgBrightnes);
 
   endTransaction();
-  digitalWrite(_cs, HIGH); // disable Slave Select
+  writeCS(HIGH); // disable Slave Select
 
 
-//Serial.println("NKK_SmartDisplayLCD::sendImageToSPI: array transferred");
+//Serial.println("NKK_SmartDisplayLCD::sendFrameToSPI: array transferred");
 } 
 
 
+//Function to transfer Set RGB and Set Brightness commands to SPI, Slave Select and transaction are handled by the caller.
+//keys, numKeys, isRotate180 and group are the selected keys as in nextCommand()
+void NKK_SmartDisplayLCD::transferColourAndBrightness(byte colour, byte brightness, NKK_SmartDisplayLCD *keys[], uint8_t numKeys, int8_t isRotate180, NKK_SmartDisplayLCD *group)
+{
+ _SPI->transfer((byte) NKK_SmartDisplayLCD_Set_RGB);
+ _SPI->transfer((byte) colour);
+ nextCommand(keys, numKeys, isRotate180, group);
+ _SPI->transfer((byte) NKK_SmartDisplayLCD_Set_Bright);
+ _SPI->transfer((byte) brightness);
+}
+
+
+//Function to transfer a NKK Image Upload command and an array to SPI, Slave Select and transaction are handled by the caller.
+//If isRotate180 is set the array is sent from the last byte to the first one with bits reversed i.e. the image is rotated 180 degrees on the fly
+//If isGFX is set the array is in GFX format and converted to NKK format on the fly, one strip at a time
+void NKK_SmartDisplayLCD::transferImage(byte buffer[], uint16_t length, uint8_t isRotate180, bool isGFX)
+{
+ _SPI->transfer((byte) NKK_SmartDisplayLCD_Img_Upload) ; 
+  //Serial.println((byte) NKK_SmartDisplayLCD_Img_Upload);
+
+ if (isGFX) {
+  byte strip[NKK_SmartDisplayLCD_MaxStripLength];
+  uint8_t stripLength = getStripLength();
+  uint16_t numOfStrips = length / stripLength;
+  
+  for (uint16_t k = 0; k < numOfStrips; k++) {
+   if (isRotate180) {
+    convertStripGFX2NKK(buffer, numOfStrips - 1 - k, strip);
+    for (uint8_t i = stripLength; i > 0; i--) {
+     _SPI->transfer(reverseByte(strip[i-1])); //Send the mirrored strip element over SPI
+    }
+   }
+   else {
+    convertStripGFX2NKK(buffer, k, strip);
+    for (uint8_t i = 0; i < stripLength; i++) {
+     _SPI->transfer((byte) strip[i]); //Send the strip element over SPI
+    }
+   }
+  }
+  return;
+ }
+
+ if (isRotate180) {
+  for (uint16_t i = length; i > 0; i--) {
+   _SPI->transfer(reverseByte(buffer[i-1])); //Send the mirrored array element over SPI
+  }
+ }
+ else {
+  for (uint16_t i = 0; i < length; i++) {
+   _SPI->transfer((byte) buffer[i] ); //Send the array element  over SPI
+ //Serial.print(i);  Serial.print(":"); Serial.println((byte) buffer[i]);
+  }
+ }
+}
+
+
 //Function to transfer an array to an SPI port
 void NKK_SmartDisplayLCD::sendArrayToSPI(byte buffer[], uint16_t length)
 {
 //Serial.println("NKK_SmartDisplayLCD::sendArrayToSPI: array will be transferred");
 	 
- digitalWrite(_cs, LOW); // enable Slave Select
+ writeCS(LOW); // enable Slave Select
  beginTransaction();
 
  for (int i = 0; i < length; i++) {
@@ -598,7 +1443,7 @@ void NKK_SmartDisplayLCD::sendArrayToSPI(byte buffer[], uint16_t length)
 
 
   endTransaction();
-  digitalWrite(_cs, HIGH); // disable Slave Select
+  writeCS(HIGH); // disable Slave Select
 
 
 //Serial.println("NKK_SmartDisplayLCD::sendArrayToSPI: array transferred");
@@ -609,14 +1454,14 @@ void NKK_SmartDisplayLCD::sendArrayToSPI(byte buffer[], uint16_t length)
 void NKK_SmartDisplayLCD::sendCommandAndDataToSPI(byte command, byte data)
 {
   
- digitalWrite(_cs, LOW); // enable Slave Select
+ writeCS(LOW); // enable Slave Select
  beginTransaction();
    
   _SPI->transfer((byte) command); 
   _SPI->transfer((byte) data);  
  
   endTransaction();
-  digitalWrite(_cs, HIGH); // disable Slave Select
+  writeCS(HIGH); // disable Slave Select
 
 } 
 
@@ -631,8 +1476,240 @@ void NKK_SmartDisplayLCD::beginTransaction(void) {
 
 //Manually end a transaction (calls endTransaction if hardware SPI)
 void NKK_SmartDisplayLCD::endTransaction(void) {
-_SPI->endTransaction();
   if (_SPI) {
     _SPI->endTransaction();
   }
 }
+
+
+//Sets Slave Select signal to level, a provider sends it at once
+void NKK_SmartDisplayLCD::writeCS(uint8_t level) {
+ stageCS(level);
+ updateCS();
+}
+
+
+//Sets Slave Select signal to level, a provider keeps it until updateCS() so a group of keys is switched at once
+void NKK_SmartDisplayLCD::stageCS(uint8_t level) {
+ if (_csProvider) {
+   _csProvider->write(_csLine, level);
+ }
+#if defined(NKK_SmartDisplayLCD_FastIO)
+ else if (_isFastCS && _csPort) {
+#if defined(__AVR__)
+   uint8_t oldSREG = SREG; //read-modify-write of the port, interrupts are held off as digitalWrite() does
+   cli();
+#endif
+   if (level == LOW) {
+     *_csPort &= ~_csMask;
+   }
+   else {
+     *_csPort |= _csMask;
+   }
+#if defined(__AVR__)
+   SREG = oldSREG;
+#endif
+ }
+#endif
+ else {
+   digitalWrite(_cs, level);
+ }
+}
+
+
+//Sends the Slave Select signal kept by the provider, nothing if it has not changed
+void NKK_SmartDisplayLCD::updateCS(void) {
+ if (_csProvider) {
+   _csProvider->update();
+ }
+}
+
+
+//Checks if the Slave Select provider sends the lines over the SPI object of this object
+bool NKK_SmartDisplayLCD::isCSOnBus(void) {
+ return _csProvider != NULL && _SPI != NULL && _csProvider->getSPI() == _SPI;
+}
+
+
+//Ends the Slave Select session and starts a new one inside a transaction of this object, if a selected key takes a session per 
+//command (setCSPerCommand()). keys == NULL - this key is selected, otherwise the broadcast targets with the rotation setting 
+//isRotate180 in the Slave Select group of the group key
+void NKK_SmartDisplayLCD::nextCommand(NKK_SmartDisplayLCD *keys[], uint8_t numKeys, int8_t isRotate180, NKK_SmartDisplayLCD *group) {
+ bool isPerCommand = (keys == NULL) && _isCSPerCommand;
+ for (uint8_t k = 0; k < numKeys && !isPerCommand; k++) {
+   isPerCommand = isBroadcastTarget(keys[k], true, isRotate180) && group->isSameCSGroup(keys[k]) && keys[k]->_isCSPerCommand;
+ }
+ if (!isPerCommand) {
+   return;
+ }
+ endTransaction();
+ if (keys == NULL) {
+   writeCS(HIGH); // disable Slave Select
+   writeCS(LOW); // enable Slave Select
+ }
+ else {
+   selectKeys(keys, numKeys, true, isRotate180, group, HIGH);
+   selectKeys(keys, numKeys, true, isRotate180, group, LOW);
+ }
+ beginTransaction();
+}
+
+
+//Moves Slave Select from one key to another (NULL - none) inside a transaction of this object. The transaction is paused 
+//while a provider which shares the SPI object sends the lines
+void NKK_SmartDisplayLCD::switchCS(NKK_SmartDisplayLCD *from, NKK_SmartDisplayLCD *to) {
+ bool isOnBus = (from != NULL && from->isCSOnBus()) || (to != NULL && to->isCSOnBus());
+ if (isOnBus) {
+   endTransaction();
+ }
+ if (from != NULL) {
+   from->writeCS(HIGH); // disable Slave Select
+ }
+ if (to != NULL) {
+   to->writeCS(LOW); // enable Slave Select
+ }
+ if (isOnBus) {
+   beginTransaction();
+ }
+}
+
+
+/******************************************************************************/
+/* Broadcast helpers                                                          */
+/******************************************************************************/
+
+//Checks if a key can receive a broadcast from this object - same SPI object and, for images, the same image size. 
+//isRotate180 >= 0 - the key shall have that rotation setting as well
+bool NKK_SmartDisplayLCD::isBroadcastTarget(NKK_SmartDisplayLCD *key, bool checkImageSize, int8_t isRotate180)
+{
+ if (key == NULL || key->_SPI != _SPI) {
+   return false;
+ }
+ if (checkImageSize && (key->_w != _w || key->_h != _h)) {
+   return false;
+ }
+ if (isRotate180 >= 0 && (key->_isRotate180 ? 1 : 0) != isRotate180) {
+   return false;
+ }
+ return true;
+}
+
+
+//Checks if a key can be selected together with this one - the same Slave Select provider and the same group of its lines 
+//(pins are always one group). A provider sends the lines of a group in one update, so no key of the group clocks in provider traffic
+bool NKK_SmartDisplayLCD::isSameCSGroup(NKK_SmartDisplayLCD *key)
+{
+ if (key->_csProvider != _csProvider) {
+   return false;
+ }
+ return _csProvider == NULL || _csProvider->getGroup(_csLine) == _csProvider->getGroup(key->_csLine);
+}
+
+
+//Checks if keys[k] is a broadcast target and no target before it is in its Slave Select group, a broadcast sends a transfer per group
+bool NKK_SmartDisplayLCD::isFirstOfCSGroup(NKK_SmartDisplayLCD *keys[], uint8_t k, bool checkImageSize, int8_t isRotate180)
+{
+ if (!isBroadcastTarget(keys[k], checkImageSize, isRotate180)) {
+   return false;
+ }
+ for (uint8_t i = 0; i < k; i++) {
+   if (isBroadcastTarget(keys[i], checkImageSize, isRotate180) && keys[k]->isSameCSGroup(keys[i])) {
+     return false;
+   }
+ }
+ return true;
+}
+
+
+//Sets Slave Select signal to level for all broadcast targets in the Slave Select group of the group key, 
+//isRotate180 = -1 selects keys regardless of their rotation setting. Returns number of keys handled
+uint8_t NKK_SmartDisplayLCD::selectKeys(NKK_SmartDisplayLCD *keys[], uint8_t numKeys, bool checkImageSize, int8_t isRotate180, NKK_SmartDisplayLCD *group, uint8_t level)
+{
+ uint8_t count = 0;
+ for (uint8_t k = 0; k < numKeys; k++) {
+   if (!isBroadcastTarget(keys[k], checkImageSize, isRotate180) || !group->isSameCSGroup(keys[k])) {
+     continue;
+   }
+   keys[k]->stageCS(level);
+   count++;
+ }
+ //providers send all lines of the group at once
+ for (uint8_t k = 0; k < numKeys; k++) {
+   if (keys[k] != NULL) {
+     keys[k]->updateCS();
+   }
+ }
+ return count;
+}
+
+
+//Function to write a command and data to all broadcast targets, one transfer per Slave Select group, saves the settings into the key variables
+uint8_t NKK_SmartDisplayLCD::broadcastCommandAndData(NKK_SmartDisplayLCD *keys[], uint8_t numKeys, bool checkImageSize, byte command, byte data)
+{
+ uint8_t count = 0;
+ for (uint8_t g = 0; g < numKeys; g++) {
+   if (!isFirstOfCSGroup(keys, g, checkImageSize, -1)) {
+     continue;
+   }
+   count += selectKeys(keys, numKeys, checkImageSize, -1, keys[g], LOW); // enable Slave Select
+   beginTransaction();
+   
+   _SPI->transfer((byte) command); 
+   _SPI->transfer((byte) data);  
+ 
+   endTransaction();
+   selectKeys(keys, numKeys, checkImageSize, -1, keys[g], HIGH); // disable Slave Select
+ }
+ if (count == 0) {
+   return 0;
+ }
+
+ //save settings into the key variables
+ for (uint8_t k = 0; k < numKeys; k++) {
+   if (!isBroadcastTarget(keys[k], checkImageSize)) {
+     continue;
+   }
+   if (command == NKK_SmartDisplayLCD_Set_RGB) {
+     keys[k]->bkgColour = data;
+   }
+   else if (command == NKK_SmartDisplayLCD_Set_Bright) {
+     keys[k]->bkgBrightnes = data;
+   }
+ }
+ return count;
+}
+
+
+//Function to write an image, colour and brightness of this object to all broadcast targets, one transfer per rotation setting 
+//and Slave Select group in use. Saves the settings into the key variables
+uint8_t NKK_SmartDisplayLCD::broadcastFrame(NKK_SmartDisplayLCD *keys[], uint8_t numKeys, byte buffer[], bool isGFX)
+{
+ uint8_t count = 0;
+ byte colour = bkgColour | 0x03; // apply masks
+ byte brightness = bkgBrightnes | 0x1F;
+ for (int8_t r = 0; r <= 1; r++) {
+   for (uint8_t g = 0; g < numKeys; g++) {
+     if (!isFirstOfCSGroup(keys, g, true, r)) {
+       continue;
+     }
+     count += selectKeys(keys, numKeys, true, r, keys[g], LOW); // enable Slave Select
+     beginTransaction();
+   
+     transferImage(buffer, _imageBufferLength, r, isGFX);
+     nextCommand(keys, numKeys, r, keys[g]);
+     transferColourAndBrightness(colour, brightness, keys, numKeys, r, keys[g]);
+   
+     endTransaction();
+     selectKeys(keys, numKeys, true, r, keys[g], HIGH); // disable Slave Select
+   }
+ }
+
+ //save settings into the key variables
+ for (uint8_t k = 0; k < numKeys; k++) {
+   if (isBroadcastTarget(keys[k], true)) {
+     keys[k]->bkgColour = colour;
+     keys[k]->bkgBrightnes = brightness;
+   }
+ }
+ return count;
+}
@@ -44,6 +44,36 @@ Key Features:
 
 
 #include <SPI.h> 
+#include <nkkfont.h>
+
+class NKK_ChipSelect; // Slave Select provider, see NKKChipSelect.h
+class NKK_SmartDisplayLCD;
+
+//A command for NKK_SmartDisplayLCD::sendCommands() - an NKK command (e.g. NKK_SmartDisplayLCD_Set_RGB) and its data byte for a key
+struct NKK_Command {
+  NKK_SmartDisplayLCD *key;
+  byte command;
+  byte data;
+};
+
+//Max length of an NKK strip (a part of the NKK image converted at once when imageBufferGFX is sent on the fly) - one row in Landscape, 
+//one column of 8*8 bit blocks (image height in bytes) in Portrait. Max image size supported is 64*64.
+#define NKK_SmartDisplayLCD_MaxStripLength 64
+
+//Port register access for Slave Select pins and NKK_ParallelSPI, resolved once in begin(). Cores without the port register macros 
+//(e.g. a host build with GPIO stand-ins) use digitalWrite().
+#if defined(portOutputRegister) && defined(digitalPinToPort) && defined(digitalPinToBitMask)
+  #define NKK_SmartDisplayLCD_FastIO
+  #if defined(__AVR__)
+    typedef volatile uint8_t NKK_PortReg_t;
+    typedef uint8_t NKK_PortMask_t;
+  #else
+    typedef volatile uint32_t NKK_PortReg_t;
+    typedef uint32_t NKK_PortMask_t;
+  #endif
+#else
+    typedef uint8_t NKK_PortMask_t;
+#endif
  
  /**************************************************************************/
 /*! 
@@ -51,6 +81,12 @@ Key Features:
 */
 /**************************************************************************/
 class NKK_SmartDisplayLCD { 
+
+friend class NKK_ParallelSPI; // software transport which drives several NKK devices at once
+friend class NKK_NumericWidget; // digit cells blitted directly into imageBufferNKK
+friend class NKK_MultiBus; // uploads keys of several SPI objects concurrently
+friend class NKK_Transitions; // colour and brightness fades sent as batches of commands
+friend class NKK_FramePool; // shared read only imageBufferNKK, reference counted
   
 #define NKK_SmartDisplayLCD_Img_Upload 0x55  /** int 85**/
 #define NKK_SmartDisplayLCD_Set_RGB 0x40  /**int 64 **/
@@ -64,24 +100,32 @@ NKK_SmartDisplayLCD(          uint8_t w=64,
                                uint8_t isRotate180=0,   //0- no rotation* 1 - 180 degree rotation  
 							   uint8_t cspin = SS,
                                uint32_t freqSPI=1000000, // in Hz									  
-  							   SPIClass *SPI_A=&SPI);								   
+  							   SPIClass *SPI_A=&SPI,
+							   bool singleBuffer=false); // true - imageBufferNKK is not allocated, see setSingleBuffer()								   
 								   
 
 ~NKK_SmartDisplayLCD(void);								   
 
+//Not copyable - the object owns its image buffers. Movable, the buffers move with it, so 
+//NKK_SmartDisplayLCD NKK = NKK_SmartDisplayLCD(64,32,0,4); builds with C++11 as well 
+NKK_SmartDisplayLCD(const NKK_SmartDisplayLCD&) = delete;
+NKK_SmartDisplayLCD& operator=(const NKK_SmartDisplayLCD&) = delete;
+NKK_SmartDisplayLCD(NKK_SmartDisplayLCD &&other);
+NKK_SmartDisplayLCD& operator=(NKK_SmartDisplayLCD &&other);
   
   
-//Setups the SPI interface and hardware
-void begin(void);
+//Setups the SPI interface and hardware. Returns false if imageBufferGFX or imageBufferNKK (unless in the single buffer mode) could not 
+//be allocated in the constructor (out of RAM), the object then sends commands only and functions which work with the missing buffer do nothing
+bool begin(void);
 
 //Current image
-// Note  - Arduino compiler (C++ v.11) require the size of the array declared as we use independent arrays per a class instance. 
-// NKK Smart Display is 64bit*32bit so array size is 256 bytes. Cannot use undefined length like imageBufferGFX[] and initialise 
-// with values forvided. The library code supports array size up to 65535. 
+// Note - imageBufferGFX is allocated in the constructor with the exact image size (_w*_h/8 bytes, 256 bytes for NKK Smart Display 64bit*32bit). 
+// So is imageBufferNKK, unless the constructor flag singleBuffer is set (NULL then), see setSingleBuffer(). The library code supports 
+// array size up to 65535. External buffers can be attached instead, see attachImageBufferGFX() and attachImageBufferNKK().
 //current image (GFX format)
-byte imageBufferGFX[256] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}; 
+byte *imageBufferGFX = NULL; 
  // current image (NKK native format)
-byte imageBufferNKK[256] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}; 
+byte *imageBufferNKK = NULL; 
   
 //Colour and Brightness  settings for NKK device, in NKK format as per NKK specs
 byte bkgColour=255;  //background colour, WHITE
@@ -92,6 +136,43 @@ byte bkgBrightnes= 31;  //background colour brightness, 0FF
   uint8_t getHeigth(void); 
   uint16_t getImageBufferLength(void);
 
+//Image rotation in 90 degree steps clockwise (0-3, as Adafruit_GFX setRotation()), on top of the configuration set in the constructor. 
+//Rotation 1 and 3 swap width and height. Applied when the image is converted and uploaded, so drawing costs nothing extra.
+  void setRotation(uint8_t r);
+  uint8_t getRotation(void);
+
+//Single buffer mode - imageBufferNKK is released and display() converts imageBufferGFX on the fly while the image is sent to the NKK device, 
+//so a key needs half of the RAM. Off by default; the constructor flag singleBuffer sets it without allocating imageBufferNKK at all. 
+//display_NKK() works as display() in this mode and clearImageBufferNKK(), invertImageBufferNKK(), scrollImageBufferNKK() and 
+//convertGFX2NKK() do nothing. Drawing in NKK format (drawTextNKK(), convertCanvas2NKK(), NKK_NumericWidget, NKK_Layers) allocates 
+//imageBufferNKK on first use. setSingleBuffer(false) allocates it again before imageBufferNKK[] is written directly, 
+//it also gives a key attached to an NKK_FramePool frame its own copy. Returns false if the buffer cannot be allocated.
+  bool setSingleBuffer(bool enable);
+  bool isSingleBuffer(void);
+
+//External buffers - use a caller owned array as imageBufferGFX or imageBufferNKK e.g. placed in a specific memory region (DMA, CCM RAM) 
+//or shared by several keys. length shall be at least getImageBufferLength(), returns false otherwise and the current buffer is kept. 
+//The own buffer of the object is released. NULL attaches a new own buffer (GFX) or switches the single buffer mode on (NKK).
+  bool attachImageBufferGFX(byte buffer[], uint16_t length);
+  bool attachImageBufferNKK(byte buffer[], uint16_t length);
+
+//Slave Select pin driven by a port register store (resolved in begin()), a few cycles instead of digitalWrite(). Enabled by default, 
+//false forces digitalWrite() e.g. if interrupts drive other pins of the same port on a core with no atomic port access. 
+//Returns false if the core does not provide port registers.
+  bool setFastCS(bool enable);
+  bool isFastCS(void);
+
+//Slave Select cycled between the commands of an upload (Image Upload, Set RGB, Set Brightness) as the library did before one session 
+//per upload. Disabled by default: one Slave Select session carries all commands of an upload, which has not been verified on every 
+//NKK device - enable it if colour or brightness is not applied after display(). Broadcasts and NKK_ParallelSPI cycle Slave Select 
+//if any selected key has it enabled, NKK_MultiBus and sendCommands() per key.
+  void setCSPerCommand(bool enable);
+  bool isCSPerCommand(void);
+
+//Slave Select through a provider (74HC595 chain, MCP23S17 expanders, see NKKChipSelect.h) instead of the cspin pin, e.g. for more keys
+//than free pins. line is the provider line of this key. NULL switches back to the cspin pin.
+  void setChipSelect(NKK_ChipSelect *provider, uint16_t line);
+
 //NKK commands   
   //Set background colour 
   void setColourNKK(byte data);  // set as per NKK specs 
@@ -105,6 +186,27 @@ byte bkgBrightnes= 31;  //background colour brightness, 0FF
   //Upload an image to the NKK device from imageBufferNKK[], set background colour and brightness
   void display_NKK(void);  // display the native NKK format
    
+//Broadcast commands
+// NKK devices are write-only (SDO is not used), so several devices sharing the SPI object can receive the same transfer 
+// with their Slave Select signals asserted together. Target keys shall use the same SPI object and image size as this object, 
+// other keys are skipped. This object does not need to be in the keys[] list. Return the number of NKK devices updated.
+  //Upload an image from imageBufferGFX[] of this object to all keys, set background colour and brightness of this object
+  uint8_t broadcast(NKK_SmartDisplayLCD *keys[], uint8_t numKeys);
+  //Upload an image from imageBufferNKK[] of this object to all keys, set background colour and brightness of this object
+  uint8_t broadcast_NKK(NKK_SmartDisplayLCD *keys[], uint8_t numKeys);
+  //Set the same background colour and brightness on all keys
+  uint8_t broadcastColourNKK(NKK_SmartDisplayLCD *keys[], uint8_t numKeys, byte data);
+  uint8_t broadcastColourRGB(NKK_SmartDisplayLCD *keys[], uint8_t numKeys, byte R, byte G, byte B);
+  uint8_t broadcastBrightness(NKK_SmartDisplayLCD *keys[], uint8_t numKeys, byte data);
+
+//Batched commands - different commands for several keys in one transaction: the bus is reserved once and Slave Select is switched only 
+// when the key changes, consecutive commands for a key share one Slave Select session. Keys shall use the same SPI object as this object, 
+// other commands are skipped. Colour and brightness are masked and saved into the key variables. Returns the number of commands sent.
+  uint8_t sendCommands(const NKK_Command commands[], uint8_t numCommands);
+//A colour per key from rgb[] (R, G, B for each element of keys[]) in one transaction, only the keys whose NKK colour changes are sent 
+// a command. Returns the number of keys updated.
+  uint8_t setColoursRGB(NKK_SmartDisplayLCD *keys[], uint8_t numKeys, const byte rgb[]);
+ 
  
 //Image Buffer commands
 // Note - these commands need a separate call to  display() methods to make the results visible in the display device.
@@ -118,8 +220,21 @@ byte bkgBrightnes= 31;  //background colour brightness, 0FF
   void invertImageBufferGFX(void);
   //Invert imageBufferNKK[]
   void invertImageBufferNKK(void);   
+  //Scroll imageBufferGFX[] by dx pixels to the right (negative - to the left) and dy pixels down (negative - up), vacated pixels are cleared
+  void scrollImageBufferGFX(int16_t dx, int16_t dy);
+  //Scroll imageBufferNKK[] in the same way, directly in the NKK native format 
+  void scrollImageBufferNKK(int16_t dx, int16_t dy);
   //Convert current image buffers from GFX format to NKK native format and vice versa 
   void convertGFX2NKK(void);
+  //Convert a _w*_h rectangle at x,y of a canvas (MSB first rows, as Adafruit GFXcanvas1 buffer) into imageBufferNKK[] in one pass.
+  //Pixels outside of the canvas are cleared. imageBufferNKK is allocated if needed, returns false if it cannot be allocated.
+  bool convertCanvas2NKK(const byte canvas[], uint16_t canvasW, uint16_t canvasH, int16_t x=0, int16_t y=0);
+  
+//Text in NKK native format - glyphs of an NKKfont (fontconvert -l or -p) are stamped into imageBufferNKK[] with shifts and ORs, no conversion. 
+//x,y is the cursor on the baseline as for Adafruit_GFX fonts. Return the cursor x after the text. Nothing is drawn if the font orientation 
+//does not match the current width and height (Landscape: _w>=_h) or imageBufferNKK cannot be allocated, the cursor is still advanced.
+  int16_t drawCharNKK(const NKKfont *font, int16_t x, int16_t y, unsigned char c, uint8_t color=1);
+  int16_t drawTextNKK(const NKKfont *font, int16_t x, int16_t y, const char *text, uint8_t color=1);
    
    
 private:
@@ -127,23 +242,66 @@ SPIClass *_SPI;
 SPISettings *_spiSetting;
 uint32_t _freqSPI=1000000;	
 
-uint8_t _w=64; //Max w is  256 and  Max w*h/8  = 65535 for this library code.
-uint8_t _h=32; //Max h is  256 and  Max w*h/8  = 65535 for this library code.
+uint8_t _w=64; //Max w is  256 and  Max w*h/8  = 65535 for this library code. Current width, includes the rotation 
+uint8_t _h=32; //Max h is  256 and  Max w*h/8  = 65535 for this library code. Current height, includes the rotation
 uint16_t _imageBufferLength =256; // in bytes, _w*_h/8 , 65535 max
-uint8_t _isRotate180 = 0; // no rotation 
+uint8_t _isRotate180 = 0; // no rotation. Current 180 degree flip applied on upload, includes the rotation
+uint8_t _baseW=64; // width as configured in the constructor 
+uint8_t _baseH=32; // height as configured in the constructor
+uint8_t _baseRotate180 = 0; // 180 degree flip as configured in the constructor 
+uint8_t _rotation = 0; // rotation set by setRotation()
 uint8_t _cs = SS; // SPI Slave Select(Chip Select) pin 
+NKK_ChipSelect *_csProvider = NULL; // Slave Select provider, NULL - the cspin pin is used
+uint16_t _csLine = 0; // line of the Slave Select provider 
+bool _isFastCS = true; // port register store for the cspin pin, if the core provides it
+bool _isCSPerCommand = false; // Slave Select cycled between the commands of an upload, see setCSPerCommand()
+#if defined(NKK_SmartDisplayLCD_FastIO)
+NKK_PortReg_t *_csPort = NULL; // output register of the cspin pin, resolved in begin()
+NKK_PortMask_t _csMask = 0;
+#endif
+bool _isOwnImageBufferGFX = true; // imageBufferGFX is allocated by the object 
+bool _isOwnImageBufferNKK = true; // imageBufferNKK is allocated by the object 
+uint8_t *_sharedRefCount = NULL; // reference count of a shared read only imageBufferNKK (NKK_FramePool), NULL - not shared 
+bool _isDoubleBuffer = true; // imageBufferNKK is expected i.e. not the single buffer mode, begin() checks it was allocated 
 
  
 //Image Buffer commands and helpers
    void convertGFX2NKK(byte imageBufferGFX[], byte imageBufferNKK[]); 
-   void rotate180_NKK(byte imageBufferNKK[]); 
+   void moveFrom(NKK_SmartDisplayLCD &other);
+   bool unshareImageBufferNKK(void);
+   void releaseSharedImageBufferNKK(void);
+   uint8_t getStripLength(void);
+   void convertStripGFX2NKK(byte imageBufferGFX[], uint16_t strip, byte stripNKK[]); 
+   byte convertByteGFX2NKK(byte imageBufferGFX[], uint16_t i); 
+   byte readCanvasByte(const byte canvas[], uint16_t canvasW, uint16_t canvasH, int16_t x, int16_t y); 
+   void stampByteNKK(byte line[], uint8_t lineBytes, int16_t pos, byte bits, uint8_t color); 
+   void transpose8x8(byte src[], uint8_t srcStride, byte dst[], uint8_t dstStride); 
    byte reverseByte(byte b);
+   byte convertRGB2NKK(byte R, byte G, byte B);
+   void shiftRows(byte buffer[], uint16_t numRows, uint8_t rowBytes, int16_t n);
+   void shiftBitsInRows(byte buffer[], uint16_t numRows, uint8_t rowBytes, int16_t n, bool isBigEndian);
    
 //SPI operations & Slave Select(Chip Select) pin handling per NKK_SmartDisplayLCD instance (thus allows management of multiple NKK devices)
    void sendArrayToSPI(byte buffer[], uint16_t length);
-   void sendImageToSPI(byte buffer[], uint16_t length);
+   void sendFrameToSPI(byte buffer[], uint16_t length, bool isGFX);
    void sendCommandAndDataToSPI(byte command, byte data);
+   void transferImage(byte buffer[], uint16_t length, uint8_t isRotate180, bool isGFX);
+   void transferColourAndBrightness(byte colour, byte brightness, NKK_SmartDisplayLCD *keys[]=NULL, uint8_t numKeys=0, int8_t isRotate180=-1, NKK_SmartDisplayLCD *group=NULL);
+   void nextCommand(NKK_SmartDisplayLCD *keys[]=NULL, uint8_t numKeys=0, int8_t isRotate180=-1, NKK_SmartDisplayLCD *group=NULL);
    void beginTransaction(void);
    void endTransaction(void);
+   void writeCS(uint8_t level);
+   void stageCS(uint8_t level);
+   void updateCS(void);
+   bool isCSOnBus(void);
+   void switchCS(NKK_SmartDisplayLCD *from, NKK_SmartDisplayLCD *to);
+   
+//Broadcast helpers - Slave Select handling for a group of NKK devices sharing the SPI object 
+   bool isBroadcastTarget(NKK_SmartDisplayLCD *key, bool checkImageSize, int8_t isRotate180=-1);
+   bool isSameCSGroup(NKK_SmartDisplayLCD *key);
+   bool isFirstOfCSGroup(NKK_SmartDisplayLCD *keys[], uint8_t k, bool checkImageSize, int8_t isRotate180);
+   uint8_t selectKeys(NKK_SmartDisplayLCD *keys[], uint8_t numKeys, bool checkImageSize, int8_t isRotate180, NKK_SmartDisplayLCD *group, uint8_t level);
+   uint8_t broadcastCommandAndData(NKK_SmartDisplayLCD *keys[], uint8_t numKeys, bool checkImageSize, byte command, byte data);
+   uint8_t broadcastFrame(NKK_SmartDisplayLCD *keys[], uint8_t numKeys, byte buffer[], bool isGFX);
 };  
 #endif // _NKK_SmartDisplayLCD_H_
\ No newline at end of file
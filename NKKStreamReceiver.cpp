@@ -0,0 +1,262 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+
+#include <NKKStreamReceiver.h>
+
+//Parser states
+#define STATE_SYNC0 0
+#define STATE_SYNC1 1
+#define STATE_HEADER 2
+#define STATE_PAYLOAD 3
+#define STATE_CRC0 4
+#define STATE_CRC1 5
+
+/**************************************************************************/
+/*!
+    @brief  Constructor for NKK_StreamReceiver object.
+    @param  stream A reference (pointer) to Stream object to receive from, e.g. &Serial. NULL - only receiveByte() is used.
+	@param  keys[] An array of references (pointers) to NKK_SmartDisplayLCD objects, a key id is an index in the array. The array is copied.
+	@param  numKeys Number of keys, up to NKK_StreamReceiver_MaxKeys.
+	@return NKK_StreamReceiver object.
+    @note   Call the object's begin() function before use.
+*/
+/**************************************************************************/
+NKK_StreamReceiver::NKK_StreamReceiver(Stream *stream, NKK_SmartDisplayLCD *keys[], uint8_t numKeys)
+{
+ _stream = stream;
+ if (numKeys > NKK_StreamReceiver_MaxKeys) {numKeys = NKK_StreamReceiver_MaxKeys;}
+ _numKeys = numKeys;
+ for (uint8_t i = 0; i < numKeys; i++) {
+   _keys[i] = keys[i];
+ }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Destructor for NKK_StreamReceiver object. The keys get their own imageBufferNKK[] back, with the current images.
+*/
+/**************************************************************************/
+NKK_StreamReceiver::~NKK_StreamReceiver(void) {
+  if (_frames == NULL) {
+    return;
+  }
+  for (uint8_t i = 0; i < _numKeys; i++) {
+    byte *frame = _keys[i]->imageBufferNKK;
+    if (frame >= _frames && frame < _frames + (uint32_t) (_numKeys + 1) * _frameLength) {
+      _keys[i]->attachImageBufferNKK(NULL, 0);
+      if (_keys[i]->setSingleBuffer(false)) {
+        memcpy(_keys[i]->imageBufferNKK, frame, _frameLength);
+      }
+    }
+  }
+  free(_frames);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Allocates numKeys+1 frames, copies the current image of every key into a frame and attaches it to the key
+	        (the own imageBufferNKK[] of the key is released). The last frame is the spare one.
+    @return false if there are no keys, the image sizes of the keys differ or the frames cannot be allocated, true otherwise.
+	@note   Keys in the single buffer mode get a frame as well (their image is blank). Call setRotation() of the keys before begin().
+	        Do not attach other buffers to the keys while the receiver is used, the frames are swapped between the keys.
+*/
+/**************************************************************************/
+bool NKK_StreamReceiver::begin(void) {
+  if (_frames != NULL) {
+    return true;
+  }
+  if (_numKeys == 0) {
+    return false;
+  }
+  uint16_t frameLength = _keys[0]->getImageBufferLength();
+  for (uint8_t i = 1; i < _numKeys; i++) {
+    if (_keys[i]->getImageBufferLength() != frameLength) {
+      return false;
+    }
+  }
+  _frames = (byte *) malloc((uint32_t) (_numKeys + 1) * frameLength);
+  if (_frames == NULL) {
+    return false;
+  }
+  _frameLength = frameLength;
+  for (uint8_t i = 0; i < _numKeys; i++) {
+    byte *frame = _frames + (uint32_t) i * frameLength;
+    if (_keys[i]->imageBufferNKK != NULL) {
+      memcpy(frame, _keys[i]->imageBufferNKK, frameLength);
+    }
+    else {
+      memset(frame, 0, frameLength);
+    }
+    _keys[i]->attachImageBufferNKK(frame, frameLength);
+  }
+  _spare = _frames + (uint32_t) _numKeys * frameLength;
+  _state = STATE_SYNC0;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Parses all bytes available in the stream. Complete valid packets are committed: the received image is attached to the key
+	        and uploaded, colour and brightness are set.
+    @return Number of packets committed.
+	@note   Call it often enough for the receive buffer of the serial driver not to overflow, e.g. every loop().
+*/
+/**************************************************************************/
+uint8_t NKK_StreamReceiver::poll(void) {
+  uint8_t n = 0;
+  if (_stream == NULL) {
+    return 0;
+  }
+  while (_stream->available() > 0) {
+    int data = _stream->read();
+    if (data < 0) {
+      break;
+    }
+    if (receiveByte((byte) data) && n < 255) {
+      n++;
+    }
+  }
+  return n;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Parses one byte of the stream, e.g. from a DMA buffer or a different interface.
+    @param  data A byte.
+    @return true if the byte completed a valid packet and it has been committed.
+	@note   A packet with a wrong CRC, key id or payload length is dropped, the parser searches for the next sync bytes.
+	        A delta which is not based on the current frame of the key is dropped as well.
+*/
+/**************************************************************************/
+bool NKK_StreamReceiver::receiveByte(byte data) {
+  if (_spare == NULL) {
+    return false;
+  }
+  switch (_state) {
+    case STATE_SYNC0:
+      if (data == NKKstream_Sync0) {
+        _state = STATE_SYNC1;
+      }
+      break;
+    case STATE_SYNC1:
+      if (data == NKKstream_Sync1) {
+        _state = STATE_HEADER;
+        _count = 2;
+        _crc = 0xFFFF;
+      }
+      else if (data != NKKstream_Sync0) {
+        _state = STATE_SYNC0;
+      }
+      break;
+    case STATE_HEADER:
+      _header[_count++] = data;
+      _crc = nkkstream_crc16(_crc, &data, 1);
+      if (_count == NKKstream_HeaderLength) {
+        _length = _header[6] | (_header[7] << 8);
+        if (!isHeaderValid()) {
+          _numErrors++;
+          _state = STATE_SYNC0;
+          break;
+        }
+        _count = 0;
+        _state = (_length > 0) ? STATE_PAYLOAD : STATE_CRC0;
+      }
+      break;
+    case STATE_PAYLOAD:
+      _spare[_count++] = data;
+      _crc = nkkstream_crc16(_crc, &data, 1);
+      if (_count == _length) {
+        _state = STATE_CRC0;
+      }
+      break;
+    case STATE_CRC0:
+      _count = data;
+      _state = STATE_CRC1;
+      break;
+    default:
+      _state = STATE_SYNC0;
+      if ((_count | (data << 8)) != _crc || !commit()) {
+        _numErrors++;
+        break;
+      }
+      _numPackets++;
+      return true;
+  }
+  return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the number of packets committed since begin().
+    @return Number of packets, wraps around.
+*/
+/**************************************************************************/
+uint16_t NKK_StreamReceiver::getNumPackets(void) {
+  return _numPackets;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the number of packets dropped (wrong CRC, key id, payload length or delta base frame) since begin().
+    @return Number of packets, wraps around.
+*/
+/**************************************************************************/
+uint16_t NKK_StreamReceiver::getNumErrors(void) {
+  return _numErrors;
+}
+
+//Key id in range and the payload length matches the payload type
+bool NKK_StreamReceiver::isHeaderValid(void) {
+  if (_header[2] >= _numKeys) {
+    return false;
+  }
+  switch (_header[3] & NKKstream_PayloadMask) {
+    case NKKstream_None:  return _length == 0;
+    case NKKstream_Image: return _length == _frameLength;
+    case NKKstream_Delta: return _length >= 2 && _length <= _frameLength;
+    default:              return false;
+  }
+}
+
+//Applies a valid packet: swaps the received image with the frame of the key (or applies the delta to it in place) and uploads it,
+//sets colour and brightness. Returns false if a delta is based on a different frame
+bool NKK_StreamReceiver::commit(void) {
+  NKK_SmartDisplayLCD *key = _keys[_header[2]];
+  byte flags = _header[3];
+
+  if ((flags & NKKstream_PayloadMask) == NKKstream_None) {
+    if (flags & NKKstream_Colour) {
+      key->setColourNKK(_header[4]);
+    }
+    if (flags & NKKstream_Brightness) {
+      key->setBrightness(_header[5]);
+    }
+    return true;
+  }
+  if ((flags & NKKstream_PayloadMask) == NKKstream_Delta) {
+    if (!nkkstream_deltaDecode(key->imageBufferNKK, _frameLength, _spare, _length)) {
+      return false;
+    }
+  }
+  else {
+    byte *frame = key->imageBufferNKK;
+    key->attachImageBufferNKK(_spare, _frameLength);
+    _spare = frame;
+  }
+  if (flags & NKKstream_Colour) {
+    key->bkgColour = _header[4];
+  }
+  if (flags & NKKstream_Brightness) {
+    key->bkgBrightnes = _header[5];
+  }
+  key->display_NKK(); //sends colour and brightness as well
+  return true;
+}
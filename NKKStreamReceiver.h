@@ -0,0 +1,81 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*********************************************************************
+Frame stream receiver for NKK LCD 64x32 SmartDisplay
+
+Receives packets of the frame streaming protocol (nkkstream.h) from a Stream (e.g. Serial)
+and uploads them to the keys. Double buffered with no copy of the frames:
+ - begin() attaches every key to a receiver owned frame (attachImageBufferNKK(), the own
+   buffers of the keys are released) and keeps one spare frame.
+ - A payload is received straight into the spare frame. A valid packet is committed by
+   swapping the frames: the received frame is attached to the key and the frame the key
+   used becomes the spare one, then the image is uploaded with display_NKK().
+ - A delta (NKKstream_Delta) is received into the spare frame as well and applied to the
+   frame of the key in place, then the image is uploaded.
+ - Bytes which arrive while an image is uploaded are kept by the interrupt driven receive
+   buffer of the serial driver and parsed into the spare frame by the next poll(), so the
+   reception of frame N+1 overlaps the upload of frame N.
+The extra RAM is one frame (256 bytes for 64*32) for any number of keys.
+*********************************************************************/
+#ifndef _NKK_StreamReceiver_H_
+#define _NKK_StreamReceiver_H_
+
+#include <NKKSmartDisplayLCD.h>
+#include <nkkstream.h>
+
+#define NKK_StreamReceiver_MaxKeys 32
+
+/**************************************************************************/
+/*!
+    @brief  Class that receives streamed frames, colours and brightness for NKK_SmartDisplayLCD objects and uploads them, double buffered.
+*/
+/**************************************************************************/
+class NKK_StreamReceiver {
+
+public:
+//keys[] - key ids of the protocol are the indices, all keys shall have the same image size. The array is copied
+NKK_StreamReceiver(Stream *stream, NKK_SmartDisplayLCD *keys[], uint8_t numKeys);
+~NKK_StreamReceiver(void);
+//Not copyable - the object owns the frames attached to the keys
+NKK_StreamReceiver(const NKK_StreamReceiver&) = delete;
+NKK_StreamReceiver& operator=(const NKK_StreamReceiver&) = delete;
+
+//Allocates the frames and attaches the keys, the current images are kept. Returns false if the image sizes differ or no memory
+  bool begin(void);
+//Parses the bytes available in the stream, commits and uploads complete packets. Returns the number of packets committed
+  uint8_t poll(void);
+//Parses one byte e.g. from another source, returns true if a packet has been committed
+  bool receiveByte(byte data);
+
+//Statistics
+  uint16_t getNumPackets(void);
+  uint16_t getNumErrors(void);
+
+private:
+Stream *_stream;
+NKK_SmartDisplayLCD *_keys[NKK_StreamReceiver_MaxKeys];
+uint8_t _numKeys;
+byte *_frames = NULL;     //(numKeys + 1) frames, attached to the keys and the spare one
+byte *_spare = NULL;      //the frame a payload is received into
+uint16_t _frameLength = 0;
+
+uint8_t _state = 0;       //parser state
+byte _header[NKKstream_HeaderLength];
+uint16_t _count = 0;      //bytes of the current part received
+uint16_t _length = 0;     //payload length
+uint16_t _crc = 0;        //CRC of the packet so far
+uint16_t _numPackets = 0;
+uint16_t _numErrors = 0;
+
+  bool isHeaderValid(void);
+  bool commit(void);
+};
+#endif // _NKK_StreamReceiver_H_
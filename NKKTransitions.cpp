@@ -0,0 +1,327 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+
+#include <NKKTransitions.h>
+
+/**************************************************************************/
+/*!
+    @brief  Constructor for NKK_Transitions object.
+	@return NKK_Transitions object, no transitions running.
+*/
+/**************************************************************************/
+NKK_Transitions::NKK_Transitions(void)
+{
+ for (uint8_t i = 0; i < NKK_Transitions_MaxTransitions; i++) {
+   _transitions[i].key = NULL;
+ }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Destructor for NKK_Transitions object.
+*/
+/**************************************************************************/
+NKK_Transitions::~NKK_Transitions(void) {
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts a fade of the background colour of a key from its current colour.
+    @param  key NKK_SmartDisplayLCD object, begin() called.
+	@param  colour Target colour in NKK format (RRGGBBxx).
+	@param  duration Time of the fade in ms, 0 sets the colour on the next tick().
+	@param  curve NKK_Transitions_Linear or NKK_Transitions_Ease.
+	@return false if all transitions are in use.
+	@note   Replaces a running colour transition of the key.
+*/
+/**************************************************************************/
+bool NKK_Transitions::fadeColour(NKK_SmartDisplayLCD *key, byte colour, uint16_t duration, uint8_t curve) {
+  return start(key, NKK_SmartDisplayLCD_Set_RGB, colour, duration, curve, 0);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts a fade of the background colour of a key to the closest NKK colour of an RGB colour.
+    @param  key NKK_SmartDisplayLCD object, begin() called.
+	@param  R A byte to define Red component.
+	@param  G A byte to define Green component.
+	@param  B A byte to define Blue component.
+	@param  duration Time of the fade in ms.
+	@param  curve NKK_Transitions_Linear or NKK_Transitions_Ease.
+	@return false if all transitions are in use.
+*/
+/**************************************************************************/
+bool NKK_Transitions::fadeColourRGB(NKK_SmartDisplayLCD *key, byte R, byte G, byte B, uint16_t duration, uint8_t curve) {
+  if (key == NULL) {
+    return false;
+  }
+  return start(key, NKK_SmartDisplayLCD_Set_RGB, key->convertRGB2NKK(R, G, B), duration, curve, 0);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts a fade of the background brightness of a key from its current brightness.
+    @param  key NKK_SmartDisplayLCD object, begin() called.
+	@param  brightness Target brightness in NKK format (BBBxxxxx).
+	@param  duration Time of the fade in ms, 0 sets the brightness on the next tick().
+	@param  curve NKK_Transitions_Linear or NKK_Transitions_Ease.
+	@return false if all transitions are in use.
+	@note   Replaces a running brightness transition of the key.
+*/
+/**************************************************************************/
+bool NKK_Transitions::fadeBrightness(NKK_SmartDisplayLCD *key, byte brightness, uint16_t duration, uint8_t curve) {
+  return start(key, NKK_SmartDisplayLCD_Set_Bright, brightness, duration, curve, 0);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts a pulse of the background colour of a key - from its current colour to a colour and back in each period.
+    @param  key NKK_SmartDisplayLCD object, begin() called.
+	@param  colour Colour at the middle of a period in NKK format (RRGGBBxx).
+	@param  period Time of a period in ms, not 0.
+	@param  count Number of periods, 0 - until stop() or another transition of the key colour.
+	@return false if all transitions are in use or period is 0.
+*/
+/**************************************************************************/
+bool NKK_Transitions::pulseColour(NKK_SmartDisplayLCD *key, byte colour, uint16_t period, uint8_t count) {
+  if (period == 0) {
+    return false;
+  }
+  return start(key, NKK_SmartDisplayLCD_Set_RGB, colour, period, NKK_Transitions_Pulse, count);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts a pulse of the background brightness of a key - from its current brightness to a brightness and back in each period.
+    @param  key NKK_SmartDisplayLCD object, begin() called.
+	@param  brightness Brightness at the middle of a period in NKK format (BBBxxxxx).
+	@param  period Time of a period in ms, not 0.
+	@param  count Number of periods, 0 - until stop() or another transition of the key brightness.
+	@return false if all transitions are in use or period is 0.
+*/
+/**************************************************************************/
+bool NKK_Transitions::pulseBrightness(NKK_SmartDisplayLCD *key, byte brightness, uint16_t period, uint8_t count) {
+  if (period == 0) {
+    return false;
+  }
+  return start(key, NKK_SmartDisplayLCD_Set_Bright, brightness, period, NKK_Transitions_Pulse, count);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Stops the transitions of a key, colour and brightness stay as sent by the last tick().
+    @param  key NKK_SmartDisplayLCD object, NULL stops all transitions.
+*/
+/**************************************************************************/
+void NKK_Transitions::stop(NKK_SmartDisplayLCD *key) {
+  for (uint8_t i = 0; i < NKK_Transitions_MaxTransitions; i++) {
+    if (key == NULL || _transitions[i].key == key) {
+      _transitions[i].key = NULL;
+    }
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Checks if a key has a colour or brightness transition running.
+    @param  key NKK_SmartDisplayLCD object.
+	@return true if a transition of the key is running.
+*/
+/**************************************************************************/
+bool NKK_Transitions::isRunning(NKK_SmartDisplayLCD *key) {
+  for (uint8_t i = 0; i < NKK_Transitions_MaxTransitions; i++) {
+    if (key != NULL && _transitions[i].key == key) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns the number of running transitions.
+	@return Number of transitions, up to NKK_Transitions_MaxTransitions.
+*/
+/**************************************************************************/
+uint8_t NKK_Transitions::getNumRunning(void) {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < NKK_Transitions_MaxTransitions; i++) {
+    if (_transitions[i].key != NULL) {
+      count++;
+    }
+  }
+  return count;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Moves all transitions to a time and sends the colours and brightness levels which differ from the ones of the keys.
+    @param  now Time in ms on the time base of millis(), wraps around.
+	@return Number of commands sent.
+	@note   Commands of a key are sent together and the commands of each SPI object in one transaction (sendCommands()).
+	        Finished transitions are freed. Call it from loop(), e.g. when a timer sets a flag, not from an interrupt handler.
+*/
+/**************************************************************************/
+uint8_t NKK_Transitions::tick(uint32_t now) {
+  NKK_Command commands[NKK_Transitions_MaxTransitions];
+  uint8_t numCommands = 0;
+  uint8_t count = 0;
+
+  for (uint8_t i = 0; i < NKK_Transitions_MaxTransitions; i++) {
+    Transition *t = &_transitions[i];
+    NKK_SmartDisplayLCD *key = t->key;
+    if (key == NULL) {
+      continue;
+    }
+
+    uint32_t elapsed = now - t->start;
+    bool isDone = false;
+    byte value;
+    if (t->curve == NKK_Transitions_Pulse) {
+      if (elapsed >= t->duration) {
+        uint32_t periods = elapsed / t->duration;
+        if (t->count != 0 && periods >= t->count) {
+          isDone = true;
+        }
+        else {
+          if (t->count != 0) {
+            t->count -= periods;
+          }
+          t->start += periods * t->duration;
+          elapsed -= periods * t->duration;
+        }
+      }
+      value = isDone ? t->from : interpolate(t->command, t->from, t->to, getCurve(t->curve, elapsed, t->duration));
+    }
+    else if (elapsed >= t->duration) {
+      isDone = true;
+      value = t->to;
+    }
+    else {
+      value = interpolate(t->command, t->from, t->to, getCurve(t->curve, elapsed, t->duration));
+    }
+    if (isDone) {
+      t->key = NULL;
+    }
+
+    //only the levels which change, next to the other command of the key so Slave Select is switched once per key
+    if (value == getValue(key, t->command)) {
+      continue;
+    }
+    uint8_t pos = numCommands;
+    for (uint8_t j = 0; j < numCommands; j++) {
+      if (commands[j].key == key) {
+        pos = j + 1;
+      }
+    }
+    for (uint8_t j = numCommands; j > pos; j--) {
+      commands[j] = commands[j-1];
+    }
+    commands[pos].key = key;
+    commands[pos].command = t->command;
+    commands[pos].data = value;
+    numCommands++;
+  }
+
+  //a transaction per SPI object, sendCommands() skips the keys of the other SPI objects
+  for (uint8_t i = 0; i < numCommands; i++) {
+    uint8_t j = 0;
+    while (j < i && commands[j].key->_SPI != commands[i].key->_SPI) {
+      j++;
+    }
+    if (j == i) {
+      count += commands[i].key->sendCommands(commands, numCommands);
+    }
+  }
+  return count;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Moves all transitions to millis() and sends the changed values as tick(now).
+	@return Number of commands sent.
+*/
+/**************************************************************************/
+uint8_t NKK_Transitions::tick(void) {
+  return tick(millis());
+}
+
+//Finds the transition of the key and channel or a free one and starts it from the current value of the key
+bool NKK_Transitions::start(NKK_SmartDisplayLCD *key, byte command, byte to, uint16_t duration, uint8_t curve, uint8_t count)
+{
+ if (key == NULL) {
+   return false;
+ }
+ Transition *t = NULL;
+ for (uint8_t i = 0; i < NKK_Transitions_MaxTransitions; i++) {
+   if (_transitions[i].key == key && _transitions[i].command == command) {
+     t = &_transitions[i];
+     break;
+   }
+   if (t == NULL && _transitions[i].key == NULL) {
+     t = &_transitions[i];
+   }
+ }
+ if (t == NULL) {
+   return false;
+ }
+ t->key = key;
+ t->command = command;
+ t->curve = curve;
+ t->from = getValue(key, command);
+ t->to = (command == NKK_SmartDisplayLCD_Set_RGB) ? (to | 0x03) : (to | 0x1F); // apply mask
+ t->start = millis();
+ t->duration = duration;
+ t->count = count;
+ return true;
+}
+
+
+//Position on the curve at elapsed ms of duration, 0 (from) to 256 (to)
+uint16_t NKK_Transitions::getCurve(uint8_t curve, uint32_t elapsed, uint16_t duration)
+{
+ uint32_t x = elapsed * 256 / duration;
+ if (curve == NKK_Transitions_Pulse) {
+   x = (x < 128) ? x * 2 : (256 - x) * 2; // there and back
+ }
+ if (curve != NKK_Transitions_Linear) {
+   x = (x * x * (768 - 2 * x) + 32768) >> 16; // smoothstep 3x^2 - 2x^3
+ }
+ return (uint16_t) x;
+}
+
+
+//Value at f/256 of the way, per 2 bit channel for colours (RRGGBBxx) and over 3 bits for brightness (BBBxxxxx)
+byte NKK_Transitions::interpolate(byte command, byte from, byte to, uint16_t f)
+{
+ if (command == NKK_SmartDisplayLCD_Set_Bright) {
+   int16_t a = from >> 5;
+   int16_t b = to >> 5;
+   return (byte) (((a * 256 + (b - a) * (int16_t) f + 128) >> 8) << 5) | 0x1F;
+ }
+ byte value = 0x03;
+ for (uint8_t shift = 2; shift <= 6; shift += 2) {
+   int16_t a = (from >> shift) & 0x03;
+   int16_t b = (to >> shift) & 0x03;
+   value |= (byte) (((a * 256 + (b - a) * (int16_t) f + 128) >> 8) << shift);
+ }
+ return value;
+}
+
+
+//Colour or brightness of the key as sent to the NKK device
+byte NKK_Transitions::getValue(NKK_SmartDisplayLCD *key, byte command)
+{
+ if (command == NKK_SmartDisplayLCD_Set_RGB) {
+   return key->bkgColour | 0x03;
+ }
+ return key->bkgBrightnes | 0x1F;
+}
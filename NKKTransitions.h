@@ -0,0 +1,85 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*********************************************************************
+Colour and brightness transitions for NKK LCD 64x32 SmartDisplay
+
+Fades and pulses without delay(): a transition is started once and tick() moves all of them
+on one time base (millis() or the time passed to tick()), e.g. from loop() or when a timer
+flag is set. tick() sends SPI commands, do not call it from an interrupt handler.
+ - Colours are faded per channel over the 4 levels of R, G and B (64 NKK colours),
+   brightness over its 8 levels.
+ - Curves: NKK_Transitions_Linear, NKK_Transitions_Ease (slow start and end) and pulses
+   (from the current value to a level and back, eased, for a number of periods or forever).
+ - A level changes only a few times during a fade, so tick() sends a command only when the
+   quantised value of a key differs from the value the key has (bkgColour, bkgBrightnes).
+   The commands of a tick are sent with sendCommands(), one transaction per SPI object.
+A key has up to one colour and one brightness transition, a new one replaces the running one
+and starts from the current value.
+*********************************************************************/
+#ifndef _NKK_Transitions_H_
+#define _NKK_Transitions_H_
+
+#include <NKKSmartDisplayLCD.h>
+
+#define NKK_Transitions_MaxTransitions 16
+
+//Curves
+#define NKK_Transitions_Linear 0
+#define NKK_Transitions_Ease 1   // smoothstep, slow start and end
+#define NKK_Transitions_Pulse 2  // there and back in a period, eased (pulseColour(), pulseBrightness())
+
+/**************************************************************************/
+/*!
+    @brief  Class that runs colour and brightness transitions of NKK_SmartDisplayLCD objects on a shared time base.
+*/
+/**************************************************************************/
+class NKK_Transitions {
+
+public:
+NKK_Transitions(void);
+~NKK_Transitions(void);
+
+//Fade from the current value to a colour (NKK format) or brightness (NKK format) in duration ms. Return false if no transition is free
+  bool fadeColour(NKK_SmartDisplayLCD *key, byte colour, uint16_t duration, uint8_t curve = NKK_Transitions_Ease);
+  bool fadeColourRGB(NKK_SmartDisplayLCD *key, byte R, byte G, byte B, uint16_t duration, uint8_t curve = NKK_Transitions_Ease);
+  bool fadeBrightness(NKK_SmartDisplayLCD *key, byte brightness, uint16_t duration, uint8_t curve = NKK_Transitions_Ease);
+//Pulse from the current value to a colour or brightness and back, period in ms, count periods (0 - until stopped)
+  bool pulseColour(NKK_SmartDisplayLCD *key, byte colour, uint16_t period, uint8_t count = 0);
+  bool pulseBrightness(NKK_SmartDisplayLCD *key, byte brightness, uint16_t period, uint8_t count = 0);
+
+//Stop the transitions of a key (NULL - all keys), the current values are kept
+  void stop(NKK_SmartDisplayLCD *key = NULL);
+  bool isRunning(NKK_SmartDisplayLCD *key);
+  uint8_t getNumRunning(void);
+
+//Move all transitions to now (ms) and send the changed values. Returns the number of commands sent
+  uint8_t tick(uint32_t now);
+  uint8_t tick(void);
+
+private:
+struct Transition {
+  NKK_SmartDisplayLCD *key;  //NULL - free
+  byte command;              //NKK_SmartDisplayLCD_Set_RGB or NKK_SmartDisplayLCD_Set_Bright
+  uint8_t curve;
+  byte from;                 //value at the start, NKK format
+  byte to;                   //target value, NKK format
+  uint32_t start;            //start of the current period, ms
+  uint16_t duration;         //ms, a period for pulses
+  uint8_t count;             //pulses: periods left, 0 - forever
+};
+Transition _transitions[NKK_Transitions_MaxTransitions];
+
+  bool start(NKK_SmartDisplayLCD *key, byte command, byte to, uint16_t duration, uint8_t curve, uint8_t count);
+  uint16_t getCurve(uint8_t curve, uint32_t elapsed, uint16_t duration);
+  byte interpolate(byte command, byte from, byte to, uint16_t f);
+  byte getValue(NKK_SmartDisplayLCD *key, byte command);
+};
+#endif // _NKK_Transitions_H_
@@ -0,0 +1,406 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+
+  #include "Adafruit_GFX_DisplayList.h"
+
+//List entries - an operation byte followed by int16_t arguments (little endian), a text is a length byte and the characters,
+//a pointer, a long and a double are stored as their bytes
+enum {
+  OP_FILL_SCREEN = 1, OP_DRAW_PIXEL, OP_DRAW_LINE, OP_DRAW_FAST_HLINE, OP_DRAW_FAST_VLINE, OP_DRAW_RECT, OP_FILL_RECT,
+  OP_DRAW_CIRCLE, OP_FILL_CIRCLE, OP_DRAW_ROUND_RECT, OP_FILL_ROUND_RECT, OP_DRAW_TRIANGLE, OP_FILL_TRIANGLE,
+  OP_DRAW_XBITMAP_ROP, OP_SET_CURSOR, OP_SET_TEXT_COLOR, OP_SET_TEXT_SIZE, OP_SET_TEXT_WRAP, OP_SET_FONT,
+  OP_PRINT_TEXT, OP_PRINT_NUMBER, OP_PRINT_FLOAT
+};
+
+//Number of int16_t arguments of an operation
+static const uint8_t numArgsOp[] = {0, 1, 3, 5, 4, 4, 5, 5, 4, 4, 6, 6, 7, 7, 5, 2, 2, 1, 1, 0, 0, 1, 1};
+
+//int16_t argument k of an entry
+static int16_t arg(const byte entry[], uint8_t k) {
+  return (int16_t) (entry[1 + 2*k] | (entry[2 + 2*k] << 8));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Constructor for Adafruit_GFX_DisplayList object.
+	  @param  AGFXExt A reference (pointer) to Adafruit_GFX_Ext object to draw with.
+	  @param  capacity Size of a list in bytes. An entry takes 1 byte plus 2 bytes per argument (e.g. 9 bytes for fillRect()),
+	          a text takes 2 bytes plus its length. Two lists are allocated.
+	  @return Adafruit_GFX_DisplayList object.
+	  @note   If the lists cannot be allocated every frame overflows, see isOverflow().
+*/
+/**************************************************************************/
+  Adafruit_GFX_DisplayList::Adafruit_GFX_DisplayList(Adafruit_GFX_Ext *AGFXExt, uint16_t capacity)
+    {
+	   _AGFXExt = AGFXExt;
+	   _list = (byte *) malloc(capacity);
+	   _prevList = (byte *) malloc(capacity);
+	   if (_list != NULL && _prevList != NULL) {
+	     _capacity = capacity;
+	   }
+    }
+
+/**************************************************************************/
+/*!
+    @brief  Destructor for Adafruit_GFX_DisplayList object.
+*/
+/**************************************************************************/
+Adafruit_GFX_DisplayList::~Adafruit_GFX_DisplayList(void) {
+  free(_list);
+  free(_prevList);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts recording a frame, the calls recorded until endFrame() describe the whole image.
+	  @note   A frame is drawn on a clear image with the Adafruit_GFX defaults: cursor 0,0, text colour 1 with no background,
+	          text size 1, text wrap on and the classic font.
+*/
+/**************************************************************************/
+void Adafruit_GFX_DisplayList::beginFrame(void)
+    {
+      _length = 0;
+      _isOverflow = false;
+    }
+
+/**************************************************************************/
+/*!
+    @brief  Ends a frame. If the list differs from the list of the previous frame, draws it into the imageBufferGFX[] and uploads
+	        the image with display() of the Adafruit_GFX_Ext object.
+    @return true if the frame has been drawn and uploaded, false if it did not change or did not fit into the capacity.
+	@note   A frame which did not fit is not drawn, the previous image stays on the NKK device.
+*/
+/**************************************************************************/
+bool Adafruit_GFX_DisplayList::endFrame(void)
+    {
+      if (_isOverflow) {
+        return false;
+      }
+      if (_isPrevValid && _length == _prevLength && memcmp(_list, _prevList, _length) == 0) {
+        return false;
+      }
+      replay();
+      _AGFXExt->display();
+      byte *list = _prevList; //the current list becomes the previous one
+      _prevList = _list;
+      _list = list;
+      _prevLength = _length;
+      _isPrevValid = true;
+      return true;
+    }
+
+/**************************************************************************/
+/*!
+    @brief  Makes the next endFrame() draw and upload the frame even if it does not change.
+	        Call it when the image changes without the list, e.g. after a recorded bitmap is changed or drawn on directly,
+	        or when the colour or brightness of the key is changed.
+*/
+/**************************************************************************/
+void Adafruit_GFX_DisplayList::invalidate(void)
+    {
+      _isPrevValid = false;
+    }
+
+/**************************************************************************/
+/*!
+    @brief  Checks if the frame did not fit into the capacity.
+    @return true if the calls recorded since beginFrame() did not fit, they are dropped.
+*/
+/**************************************************************************/
+bool Adafruit_GFX_DisplayList::isOverflow(void)
+    {
+      return _isOverflow;
+    }
+
+/**************************************************************************/
+/*!
+    @brief  Gets the size of the list recorded since beginFrame().
+    @return Number of bytes.
+*/
+/**************************************************************************/
+uint16_t Adafruit_GFX_DisplayList::getLength(void)
+    {
+      return _length;
+    }
+
+/**************************************************************************/
+/*!
+    @brief  Recorded Adafruit_GFX calls. The parameters are as per Adafruit_GFX (drawXBitmapRop() as per Adafruit_GFX_Ext),
+	        nothing is drawn until endFrame().
+	@note   Bitmap and font pointers are recorded, not their content. print() copies the text. print() of a number records
+	        its value and prints it as Arduino Print does, e.g. print(3.14159) shows "3.14", print(3.14159, 4) "3.1416".
+*/
+/**************************************************************************/
+void Adafruit_GFX_DisplayList::fillScreen(uint16_t color)
+    {
+      record(OP_FILL_SCREEN, 1, color);
+    }
+
+void Adafruit_GFX_DisplayList::drawPixel(int16_t x, int16_t y, uint16_t color)
+    {
+      record(OP_DRAW_PIXEL, 3, x, y, color);
+    }
+
+void Adafruit_GFX_DisplayList::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+    {
+      record(OP_DRAW_LINE, 5, x0, y0, x1, y1, color);
+    }
+
+void Adafruit_GFX_DisplayList::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+    {
+      record(OP_DRAW_FAST_HLINE, 4, x, y, w, color);
+    }
+
+void Adafruit_GFX_DisplayList::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+    {
+      record(OP_DRAW_FAST_VLINE, 4, x, y, h, color);
+    }
+
+void Adafruit_GFX_DisplayList::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+    {
+      record(OP_DRAW_RECT, 5, x, y, w, h, color);
+    }
+
+void Adafruit_GFX_DisplayList::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+    {
+      record(OP_FILL_RECT, 5, x, y, w, h, color);
+    }
+
+void Adafruit_GFX_DisplayList::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color)
+    {
+      record(OP_DRAW_CIRCLE, 4, x0, y0, r, color);
+    }
+
+void Adafruit_GFX_DisplayList::fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color)
+    {
+      record(OP_FILL_CIRCLE, 4, x0, y0, r, color);
+    }
+
+void Adafruit_GFX_DisplayList::drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color)
+    {
+      record(OP_DRAW_ROUND_RECT, 6, x, y, w, h, r, color);
+    }
+
+void Adafruit_GFX_DisplayList::fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color)
+    {
+      record(OP_FILL_ROUND_RECT, 6, x, y, w, h, r, color);
+    }
+
+void Adafruit_GFX_DisplayList::drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color)
+    {
+      record(OP_DRAW_TRIANGLE, 7, x0, y0, x1, y1, x2, y2, color);
+    }
+
+void Adafruit_GFX_DisplayList::fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color)
+    {
+      record(OP_FILL_TRIANGLE, 7, x0, y0, x1, y1, x2, y2, color);
+    }
+
+void Adafruit_GFX_DisplayList::drawXBitmapRop(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint8_t rop)
+    {
+      if (record(OP_DRAW_XBITMAP_ROP, 5, x, y, w, h, rop)) {
+        recordData(&bitmap, sizeof(const uint8_t *));
+      }
+    }
+
+void Adafruit_GFX_DisplayList::setCursor(int16_t x, int16_t y)
+    {
+      record(OP_SET_CURSOR, 2, x, y);
+    }
+
+void Adafruit_GFX_DisplayList::setTextColor(uint16_t c)
+    {
+      record(OP_SET_TEXT_COLOR, 2, c, c);
+    }
+
+void Adafruit_GFX_DisplayList::setTextColor(uint16_t c, uint16_t bg)
+    {
+      record(OP_SET_TEXT_COLOR, 2, c, bg);
+    }
+
+void Adafruit_GFX_DisplayList::setTextSize(uint8_t s)
+    {
+      record(OP_SET_TEXT_SIZE, 1, s);
+    }
+
+void Adafruit_GFX_DisplayList::setTextWrap(bool w)
+    {
+      record(OP_SET_TEXT_WRAP, 1, w);
+    }
+
+void Adafruit_GFX_DisplayList::setFont(const GFXfont *f)
+    {
+      if (record(OP_SET_FONT, 0)) {
+        recordData(&f, sizeof(f));
+      }
+    }
+
+void Adafruit_GFX_DisplayList::print(const char *text)
+    {
+      uint16_t length = strlen(text);
+      while (length > 0) {
+        byte n = (length > 255) ? 255 : length; //a text entry holds up to 255 characters
+        if (!record(OP_PRINT_TEXT, 0) || !recordData(&n, 1) || !recordData(text, n)) {
+          return;
+        }
+        text += n;
+        length -= n;
+      }
+    }
+
+void Adafruit_GFX_DisplayList::print(char c)
+    {
+      byte n = 1;
+      if (record(OP_PRINT_TEXT, 0) && recordData(&n, 1)) {
+        recordData(&c, 1);
+      }
+    }
+
+void Adafruit_GFX_DisplayList::print(int n)
+    {
+      recordNumber(n, false);
+    }
+
+void Adafruit_GFX_DisplayList::print(unsigned int n)
+    {
+      recordNumber(n, true);
+    }
+
+void Adafruit_GFX_DisplayList::print(long n)
+    {
+      recordNumber(n, false);
+    }
+
+void Adafruit_GFX_DisplayList::print(unsigned long n)
+    {
+      recordNumber((long) n, true);
+    }
+
+void Adafruit_GFX_DisplayList::print(double n, int digits)
+    {
+      if (record(OP_PRINT_FLOAT, 1, digits)) {
+        recordData(&n, sizeof(n));
+      }
+    }
+
+//Appends a number entry, an unsigned long is stored in the bits of a long
+void Adafruit_GFX_DisplayList::recordNumber(long n, bool isUnsigned)
+    {
+      if (record(OP_PRINT_NUMBER, 1, isUnsigned)) {
+        recordData(&n, sizeof(n));
+      }
+    }
+
+//Appends an entry with numArgs arguments, sets the overflow (the frame is dropped) if it does not fit
+bool Adafruit_GFX_DisplayList::record(byte op, uint8_t numArgs, int16_t a0, int16_t a1, int16_t a2, int16_t a3, int16_t a4, int16_t a5, int16_t a6)
+    {
+      int16_t args[7] = {a0, a1, a2, a3, a4, a5, a6};
+      if (_isOverflow || _length + 1 + 2*numArgs > _capacity) {
+        _isOverflow = true;
+        return false;
+      }
+      _list[_length++] = op;
+      for (uint8_t k = 0; k < numArgs; k++) {
+        _list[_length++] = (uint16_t) args[k] & 0xFF;
+        _list[_length++] = (uint16_t) args[k] >> 8;
+      }
+      return true;
+    }
+
+//Appends bytes to the last entry
+bool Adafruit_GFX_DisplayList::recordData(const void *data, uint16_t length)
+    {
+      if (_isOverflow || _length + length > _capacity) {
+        _isOverflow = true;
+        return false;
+      }
+      memcpy(_list + _length, data, length);
+      _length += length;
+      return true;
+    }
+
+//Draws the current list into the imageBufferGFX[] from a clear image and the Adafruit_GFX defaults
+void Adafruit_GFX_DisplayList::replay(void)
+    {
+      Adafruit_GFX_Ext *g = _AGFXExt;
+      g->setCursor(0, 0);
+      g->setTextColor(1);
+      g->setTextSize(1);
+      g->setTextWrap(true);
+      g->setFont(NULL);
+      g->fillScreen(0);
+
+      uint16_t i = 0;
+      while (i < _length) {
+        const byte *e = _list + i;
+        byte op = e[0];
+        i += 1 + 2*numArgsOp[op];
+        switch (op) {
+          case OP_FILL_SCREEN:     g->fillScreen(arg(e, 0)); break;
+          case OP_DRAW_PIXEL:      g->drawPixel(arg(e, 0), arg(e, 1), arg(e, 2)); break;
+          case OP_DRAW_LINE:       g->drawLine(arg(e, 0), arg(e, 1), arg(e, 2), arg(e, 3), arg(e, 4)); break;
+          case OP_DRAW_FAST_HLINE: g->drawFastHLine(arg(e, 0), arg(e, 1), arg(e, 2), arg(e, 3)); break;
+          case OP_DRAW_FAST_VLINE: g->drawFastVLine(arg(e, 0), arg(e, 1), arg(e, 2), arg(e, 3)); break;
+          case OP_DRAW_RECT:       g->drawRect(arg(e, 0), arg(e, 1), arg(e, 2), arg(e, 3), arg(e, 4)); break;
+          case OP_FILL_RECT:       g->fillRect(arg(e, 0), arg(e, 1), arg(e, 2), arg(e, 3), arg(e, 4)); break;
+          case OP_DRAW_CIRCLE:     g->drawCircle(arg(e, 0), arg(e, 1), arg(e, 2), arg(e, 3)); break;
+          case OP_FILL_CIRCLE:     g->fillCircle(arg(e, 0), arg(e, 1), arg(e, 2), arg(e, 3)); break;
+          case OP_DRAW_ROUND_RECT: g->drawRoundRect(arg(e, 0), arg(e, 1), arg(e, 2), arg(e, 3), arg(e, 4), arg(e, 5)); break;
+          case OP_FILL_ROUND_RECT: g->fillRoundRect(arg(e, 0), arg(e, 1), arg(e, 2), arg(e, 3), arg(e, 4), arg(e, 5)); break;
+          case OP_DRAW_TRIANGLE:   g->drawTriangle(arg(e, 0), arg(e, 1), arg(e, 2), arg(e, 3), arg(e, 4), arg(e, 5), arg(e, 6)); break;
+          case OP_FILL_TRIANGLE:   g->fillTriangle(arg(e, 0), arg(e, 1), arg(e, 2), arg(e, 3), arg(e, 4), arg(e, 5), arg(e, 6)); break;
+          case OP_DRAW_XBITMAP_ROP: {
+            const uint8_t *bitmap;
+            memcpy(&bitmap, _list + i, sizeof(bitmap));
+            i += sizeof(bitmap);
+            g->drawXBitmapRop(arg(e, 0), arg(e, 1), bitmap, arg(e, 2), arg(e, 3), arg(e, 4));
+            break;
+          }
+          case OP_SET_CURSOR:      g->setCursor(arg(e, 0), arg(e, 1)); break;
+          case OP_SET_TEXT_COLOR:  g->setTextColor(arg(e, 0), arg(e, 1)); break;
+          case OP_SET_TEXT_SIZE:   g->setTextSize(arg(e, 0)); break;
+          case OP_SET_TEXT_WRAP:   g->setTextWrap(arg(e, 0)); break;
+          case OP_SET_FONT: {
+            const GFXfont *font;
+            memcpy(&font, _list + i, sizeof(font));
+            i += sizeof(font);
+            g->setFont(font);
+            break;
+          }
+          case OP_PRINT_TEXT: {
+            byte n = _list[i];
+            g->write(_list + i + 1, n);
+            i += 1 + n;
+            break;
+          }
+          case OP_PRINT_NUMBER: {
+            long n;
+            memcpy(&n, _list + i, sizeof(n));
+            i += sizeof(n);
+            if (arg(e, 0)) {
+              g->print((unsigned long) n);
+            }
+            else {
+              g->print(n);
+            }
+            break;
+          }
+          case OP_PRINT_FLOAT: {
+            double n;
+            memcpy(&n, _list + i, sizeof(n));
+            i += sizeof(n);
+            g->print(n, arg(e, 0));
+            break;
+          }
+          default:
+            return;
+        }
+      }
+    }
@@ -0,0 +1,92 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+#ifndef _Adafruit_GFX_DisplayList_H_
+#define _Adafruit_GFX_DisplayList_H_
+
+#include "Adafruit_GFX_Ext.h"
+
+/**************************************************************************/
+/*!
+    @brief  Class that records Adafruit_GFX drawing calls of a frame as a compact display list instead of drawing them.
+	        endFrame() compares the list with the list of the previous frame, the frame is rasterised into imageBufferGFX[],
+	        converted and uploaded only if the lists differ. A static screen costs the recording and a memcmp() per frame.
+*/
+/**************************************************************************/
+class Adafruit_GFX_DisplayList {
+
+public:
+//capacity - bytes of a list, two lists (this and the previous frame) are allocated
+Adafruit_GFX_DisplayList(Adafruit_GFX_Ext *AGFXExt, uint16_t capacity=256);
+~Adafruit_GFX_DisplayList(void);
+//Not copyable - the object owns its lists
+Adafruit_GFX_DisplayList(const Adafruit_GFX_DisplayList&) = delete;
+Adafruit_GFX_DisplayList& operator=(const Adafruit_GFX_DisplayList&) = delete;
+  //Start recording a frame. A frame starts with a clear image and the Adafruit_GFX defaults
+  //(cursor 0,0, text colour 1, no background, size 1, wrap on, classic font)
+  void beginFrame(void);
+  //Draw the frame if it differs from the previous one (or after invalidate()) and upload it with display() of the Adafruit_GFX_Ext object.
+  //Returns true if the frame has been uploaded. A frame which does not fit into the capacity is not drawn (false), see isOverflow()
+  bool endFrame(void);
+  //Draw and upload the next frame even if it does not change, e.g. after the key colour or brightness is changed
+  void invalidate(void);
+  //The last frame did not fit into the capacity
+  bool isOverflow(void);
+  //Bytes recorded in the current frame
+  uint16_t getLength(void);
+
+  //Recorded Adafruit_GFX calls, parameters as per Adafruit_GFX
+  void fillScreen(uint16_t color);
+  void drawPixel(int16_t x, int16_t y, uint16_t color);
+  void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+  void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
+  void fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
+  void drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color);
+  void fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color);
+  void drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
+  void fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
+  //XBM bitmap in PROGMEM as per Adafruit_GFX_Ext drawXBitmapRop(). The pointer is recorded, not the content
+  void drawXBitmapRop(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint8_t rop=NKKblit_Or);
+  void setCursor(int16_t x, int16_t y);
+  void setTextColor(uint16_t c);
+  void setTextColor(uint16_t c, uint16_t bg);
+  void setTextSize(uint8_t s);
+  void setTextWrap(bool w);
+  //The pointer is recorded, fonts shall stay valid
+  void setFont(const GFXfont *f);
+  //The text is copied into the list
+  void print(const char *text);
+  void print(char c);
+  //Numbers are printed as per Arduino Print, in base 10
+  void print(int n);
+  void print(unsigned int n);
+  void print(long n);
+  void print(unsigned long n);
+  void print(double n, int digits=2);
+
+private:
+Adafruit_GFX_Ext *_AGFXExt; //pointer to the Adafruit_GFX_Ext object to draw with
+byte *_list = NULL;       //current frame
+byte *_prevList = NULL;   //previous frame
+uint16_t _capacity = 0;
+uint16_t _length = 0;
+uint16_t _prevLength = 0;
+bool _isOverflow = false;
+bool _isPrevValid = false; //_prevList has been drawn and uploaded
+
+  bool record(byte op, uint8_t numArgs, int16_t a0=0, int16_t a1=0, int16_t a2=0, int16_t a3=0, int16_t a4=0, int16_t a5=0, int16_t a6=0);
+  bool recordData(const void *data, uint16_t length);
+  void recordNumber(long n, bool isUnsigned);
+  void replay(void);
+};
+#endif // _Adafruit_GFX_DisplayList_H_
@@ -22,6 +22,7 @@ All text above must be included in any redistribution
   Adafruit_GFX_Ext::Adafruit_GFX_Ext(int16_t w, int16_t h, NKK_SmartDisplayLCD *NKK_A): Adafruit_GFX(w, h)
     {
 	   _NKK = NKK_A; //pointer to the NKK_SmartDisplayLCD object object to communicate with the NKK device
+	   resetClipWindow();
     }
 	
 /**************************************************************************/
@@ -43,9 +44,27 @@ Adafruit_GFX_Ext::~Adafruit_GFX_Ext(void) {
 /**************************************************************************/
 void Adafruit_GFX_Ext::drawPixel( int16_t x, int16_t y, uint16_t color)
     {
+      if ((x < _clipX0) || (y < _clipY0) || (x >= _clipX1) || (y >= _clipY1)) {
+        return;
+      }
       _NKK->drawPixel((uint8_t) x, (uint8_t) y, (uint8_t) color);
     }
 
+/**************************************************************************/
+/*!
+    @brief  Sets rotation of Adafruit_GFX (width and height) and the NKK_SmartDisplayLCD object. 
+    @param  r   Rotation in 90 degree steps clockwise, 0-3
+	  @note   drawPixel() passes the coordinates as they are, the NKK_SmartDisplayLCD object rotates the whole image when it is 
+	          converted and uploaded to the NKK device, so rotated drawing costs nothing extra. The clip window is reset. 
+*/
+/**************************************************************************/
+void Adafruit_GFX_Ext::setRotation(uint8_t r)
+    {
+      Adafruit_GFX::setRotation(r);
+      _NKK->setRotation(r);
+      resetClipWindow();
+    }
+
 /**************************************************************************/
 /*! 
     @brief  Displays a picture in GFX format i.e. converts imageBufferGFX to NKK format, uploads the NKK device, sets colour and brightness as per the NKK_SmartDisplayLCD object variables.     
@@ -55,3 +74,358 @@ void Adafruit_GFX_Ext::display()
     {
 	   _NKK->display();
     }
+
+/**************************************************************************/
+/*! 
+    @brief  Displays a rectangle of a GFXcanvas1 i.e. converts the canvas buffer directly to NKK format into imageBufferNKK[] 
+	        in one pass and uploads it, sets colour and brightness as per the NKK_SmartDisplayLCD object variables. 
+    @param  canvas A reference (pointer) to GFXcanvas1 object, may be larger than the NKK device 
+    @param  x Left edge of the rectangle in the canvas buffer 
+    @param  y Top edge of the rectangle in the canvas buffer 
+	@return false if imageBufferNKK cannot be allocated (single buffer mode is switched off), true otherwise
+	@note   x and y are in the canvas buffer (rotation 0) coordinates, imageBufferGFX[] is not used or changed.
+*/
+/**************************************************************************/ 
+bool Adafruit_GFX_Ext::displayCanvas(GFXcanvas1 *canvas, int16_t x, int16_t y)
+    {
+	   //buffer size regardless of the canvas rotation 
+	   uint16_t canvasW = (canvas->getRotation() & 1) ? canvas->height() : canvas->width();
+	   uint16_t canvasH = (canvas->getRotation() & 1) ? canvas->width() : canvas->height();
+	   
+	   if (!_NKK->convertCanvas2NKK(canvas->getBuffer(), canvasW, canvasH, x, y)) {
+	     return false;
+	   }
+	   _NKK->display_NKK();
+	   return true;
+    }
+
+/**************************************************************************/
+/*! 
+    @brief  Scrolls the imageBufferGFX[] of the NKK_SmartDisplayLCD object, vacated pixels are cleared.
+    @param  dx Number of pixels to shift the image to the right, negative - to the left 
+    @param  dy Number of pixels to shift the image down, negative - up
+*/
+/**************************************************************************/ 
+void Adafruit_GFX_Ext::scroll(int16_t dx, int16_t dy)
+    {
+	   _NKK->scrollImageBufferGFX(dx, dy);
+    }
+
+/**************************************************************************/
+/*! 
+    @brief  Limits drawing to a rectangle, pixels outside of it are dropped by drawPixel().
+    @param  x   Top left corner x coordinate
+    @param  y   Top left corner y coordinate
+    @param  w   Width in pixels
+    @param  h   Height in pixels
+*/
+/**************************************************************************/ 
+void Adafruit_GFX_Ext::setClipWindow(int16_t x, int16_t y, int16_t w, int16_t h)
+    {
+	   _clipX0 = max(x, (int16_t) 0);
+	   _clipY0 = max(y, (int16_t) 0);
+	   _clipX1 = min((int16_t) (x + w), _width);
+	   _clipY1 = min((int16_t) (y + h), _height);
+    }
+
+/**************************************************************************/
+/*! 
+    @brief  Removes the clip window, drawing is limited by the display size only.
+*/
+/**************************************************************************/ 
+void Adafruit_GFX_Ext::resetClipWindow(void)
+    {
+	   _clipX0 = 0;
+	   _clipY0 = 0;
+	   _clipX1 = _width;
+	   _clipY1 = _height;
+    }
+
+/**************************************************************************/
+/*! 
+    @brief  Draws only the characters of a text which intersect a vertical strip, using the current font, size and colours. 
+            Used to render a thin strip of a scrolling text without re-rendering the whole text.
+    @param  text A text to draw, single line  
+    @param  x   x coordinate of the text start (as per setCursor())
+    @param  y   y coordinate of the text start (as per setCursor())
+    @param  stripX  x coordinate of the strip
+    @param  stripW  Width of the strip in pixels
+*/
+/**************************************************************************/ 
+void Adafruit_GFX_Ext::drawTextStrip(const char *text, int16_t x, int16_t y, int16_t stripX, int16_t stripW)
+    {
+	   int16_t cx = x, cy = y;
+	   int16_t stripX1 = stripX + stripW;
+	   bool wrapSaved = wrap;
+	   
+	   wrap = false; //the text runs beyond the display edge
+	   setClipWindow(stripX, 0, stripW, _height);
+	   for (const char *c = text; *c && cx < stripX1; c++) {
+	     int16_t x0 = cx;
+	     int16_t minx = 0x7FFF, miny = 0x7FFF, maxx = -1, maxy = -1;
+	     charBounds(*c, &cx, &cy, &minx, &miny, &maxx, &maxy); //advances cx, gets the glyph extent
+	     if (maxx >= stripX && minx < stripX1) {
+	       drawChar(x0, y, *c, textcolor, textbgcolor, textsize_x, textsize_y);
+	     }
+	   }
+	   resetClipWindow();
+	   wrap = wrapSaved;
+    }
+
+/**************************************************************************/
+/*! 
+    @brief  Gets width of a single line text using the current font and size, regardless of the display edge and text wrap setting.
+    @param  text A text to measure
+    @return Width in pixels from the text start (as per setCursor()) to the end of the last character
+*/
+/**************************************************************************/ 
+uint16_t Adafruit_GFX_Ext::getTextWidth(const char *text)
+    {
+	   int16_t cx = 0, cy = 0;
+	   int16_t minx = 0x7FFF, miny = 0x7FFF, maxx = -1, maxy = -1;
+	   bool wrapSaved = wrap;
+	   
+	   wrap = false;
+	   for (const char *c = text; *c; c++) {
+	     charBounds(*c, &cx, &cy, &minx, &miny, &maxx, &maxy);
+	   }
+	   wrap = wrapSaved;
+	   
+	   return max(cx, (int16_t) (maxx + 1));
+    }
+
+/**************************************************************************/
+/*! 
+    @brief  Draws a greyscale bitmap (PROGMEM) dithered to 1 bit, see drawBitmapDither().
+    @param  x   Top left corner x coordinate
+    @param  y   Top left corner y coordinate
+    @param  bitmap  Greyscale bitmap in PROGMEM, a byte per pixel, 0 - black, 255 - white
+    @param  w   Width of the bitmap in pixels
+    @param  h   Height of the bitmap in pixels
+    @param  method  NKKdither_Bayer or NKKdither_FloydSteinberg
+*/
+/**************************************************************************/ 
+void Adafruit_GFX_Ext::drawGrayscaleBitmapDither(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint8_t method)
+    {
+	   drawBitmapDither(x, y, bitmap, false, true, w, h, method);
+    }
+
+/**************************************************************************/
+/*! 
+    @brief  Draws a greyscale bitmap (RAM) dithered to 1 bit, see drawBitmapDither().
+    @param  x   Top left corner x coordinate
+    @param  y   Top left corner y coordinate
+    @param  bitmap  Greyscale bitmap in RAM, a byte per pixel, 0 - black, 255 - white
+    @param  w   Width of the bitmap in pixels
+    @param  h   Height of the bitmap in pixels
+    @param  method  NKKdither_Bayer or NKKdither_FloydSteinberg
+*/
+/**************************************************************************/ 
+void Adafruit_GFX_Ext::drawGrayscaleBitmapDither(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, uint8_t method)
+    {
+	   drawBitmapDither(x, y, bitmap, false, false, w, h, method);
+    }
+
+/**************************************************************************/
+/*! 
+    @brief  Draws an RGB565 bitmap (PROGMEM) dithered to 1 bit, see drawBitmapDither().
+    @param  x   Top left corner x coordinate
+    @param  y   Top left corner y coordinate
+    @param  bitmap  RGB565 bitmap in PROGMEM
+    @param  w   Width of the bitmap in pixels
+    @param  h   Height of the bitmap in pixels
+    @param  method  NKKdither_Bayer or NKKdither_FloydSteinberg
+*/
+/**************************************************************************/ 
+void Adafruit_GFX_Ext::drawRGBBitmapDither(int16_t x, int16_t y, const uint16_t bitmap[], int16_t w, int16_t h, uint8_t method)
+    {
+	   drawBitmapDither(x, y, bitmap, true, true, w, h, method);
+    }
+
+/**************************************************************************/
+/*! 
+    @brief  Draws an RGB565 bitmap (RAM) dithered to 1 bit, see drawBitmapDither().
+    @param  x   Top left corner x coordinate
+    @param  y   Top left corner y coordinate
+    @param  bitmap  RGB565 bitmap in RAM
+    @param  w   Width of the bitmap in pixels
+    @param  h   Height of the bitmap in pixels
+    @param  method  NKKdither_Bayer or NKKdither_FloydSteinberg
+*/
+/**************************************************************************/ 
+void Adafruit_GFX_Ext::drawRGBBitmapDither(int16_t x, int16_t y, uint16_t *bitmap, int16_t w, int16_t h, uint8_t method)
+    {
+	   drawBitmapDither(x, y, bitmap, true, false, w, h, method);
+    }
+
+/**************************************************************************/
+/*! 
+    @brief  Draws a bitmap dithered to 1 bit directly into the imageBufferGFX[] of the NKK_SmartDisplayLCD object. Every visible row 
+            (clipped to the display and the clip window) is converted to grey, thresholded as a whole and written as packed bytes, 
+            instead of a drawPixel() call per pixel. Dark pixels are set. 
+    @param  x   Top left corner x coordinate
+    @param  y   Top left corner y coordinate
+    @param  bitmap  Greyscale (a byte per pixel) or RGB565 bitmap
+    @param  isRGB   true - RGB565 bitmap, false - greyscale
+    @param  isPROGMEM   true - the bitmap is in PROGMEM
+    @param  w   Width of the bitmap in pixels
+    @param  h   Height of the bitmap in pixels
+    @param  method  NKKdither_Bayer or NKKdither_FloydSteinberg
+	  @note   Bayer pattern is fixed to the display coordinates. Floyd-Steinberg falls back to Bayer if its row buffers cannot be allocated.
+*/
+/**************************************************************************/ 
+void Adafruit_GFX_Ext::drawBitmapDither(int16_t x, int16_t y, const void *bitmap, bool isRGB, bool isPROGMEM, int16_t w, int16_t h, uint8_t method)
+    {
+	   int16_t x0 = max(x, _clipX0), x1 = min((int16_t) (x + w), _clipX1);
+	   int16_t y0 = max(y, _clipY0), y1 = min((int16_t) (y + h), _clipY1);
+	   if (x0 >= x1 || y0 >= y1 || _NKK->imageBufferGFX == NULL) {
+	     return;
+	   }
+	   uint16_t visibleW = x1 - x0;
+	   uint8_t rowBytes = _NKK->getWidth() / 8;
+	   
+	   //a RAM greyscale row is dithered in place, other sources are converted into a grey row first
+	   bool isDirect = (!isRGB && !isPROGMEM);
+	   uint16_t greyBytes = isDirect ? 0 : visibleW;
+	   uint16_t errBytes = (method == NKKdither_FloydSteinberg) ? (visibleW + 1) * sizeof(int16_t) : 0;
+	   byte *work = NULL;
+	   if (greyBytes + errBytes > 0) {
+	     work = (byte *) malloc(greyBytes + errBytes);
+	     if (work == NULL && errBytes > 0) {
+	       errBytes = 0; //no error rows, use Bayer
+	       method = NKKdither_Bayer;
+	       work = (byte *) malloc(greyBytes);
+	     }
+	     if (work == NULL && greyBytes > 0) {
+	       return;
+	     }
+	   }
+	   int16_t *err = (int16_t *) work; //error row first, so it stays aligned
+	   uint8_t *grey = work + errBytes;
+	   if (errBytes > 0) {
+	     memset(err, 0, errBytes);
+	   }
+	   
+	   for (int16_t row = y0; row < y1; row++) {
+	     uint32_t first = (uint32_t) (row - y) * w + (x0 - x); //first visible pixel of the bitmap row
+	     const uint8_t *source = grey;
+	     if (isDirect) {
+	       source = (const uint8_t *) bitmap + first;
+	     }
+	     else if (!isRGB) {
+	       for (uint16_t i = 0; i < visibleW; i++) {
+	         grey[i] = pgm_read_byte((const uint8_t *) bitmap + first + i);
+	       }
+	     }
+	     else if (!isPROGMEM) {
+	       nkkdither_rgb565ToGrey((const uint16_t *) bitmap + first, visibleW, grey);
+	     }
+	     else {
+	       for (uint16_t i = 0; i < visibleW; i++) {
+	         uint16_t colour = pgm_read_word((const uint16_t *) bitmap + first + i);
+	         nkkdither_rgb565ToGrey(&colour, 1, grey + i);
+	       }
+	     }
+	     byte *dst = _NKK->imageBufferGFX + row * rowBytes;
+	     if (method == NKKdither_FloydSteinberg) {
+	       nkkdither_floydSteinbergRow(source, visibleW, err, dst, x0, NKKdither_LSBFirst);
+	     }
+	     else {
+	       nkkdither_bayerRow(source, visibleW, dst, x0, row, NKKdither_LSBFirst);
+	     }
+	   }
+	   free(work);
+    }
+
+/**************************************************************************/
+/*! 
+    @brief  Combines a rectangle of a packed 1 bit surface with the imageBufferGFX[] of the NKK_SmartDisplayLCD object by a raster 
+            operation (nkkblit()). Rows are processed a word at a time with head and tail masks, instead of a drawPixel() call per pixel.
+    @param  x   Top left corner x coordinate in the image
+    @param  y   Top left corner y coordinate in the image
+    @param  src Source surface, LSB first rows (as XBM and imageBufferGFX[])
+    @param  sx  Top left corner x coordinate in the source
+    @param  sy  Top left corner y coordinate in the source
+    @param  w   Width in pixels
+    @param  h   Height in pixels
+    @param  rop NKKblit_Copy, NKKblit_Or, NKKblit_And, NKKblit_Xor or NKKblit_AndNot
+    @param  mask Mask surface in the source coordinates, only pixels set in the mask are changed. NULL - all pixels of the rectangle.
+    @return Number of image rows changed
+	  @note   The rectangle is clipped to the image and the clip window.
+*/
+/**************************************************************************/ 
+uint16_t Adafruit_GFX_Ext::blit(int16_t x, int16_t y, const NKKsurface *src, int16_t sx, int16_t sy, int16_t w, int16_t h, uint8_t rop, const NKKsurface *mask)
+    {
+	   if (x < _clipX0) {
+	     sx += _clipX0 - x;
+	     w -= _clipX0 - x;
+	     x = _clipX0;
+	   }
+	   if (y < _clipY0) {
+	     sy += _clipY0 - y;
+	     h -= _clipY0 - y;
+	     y = _clipY0;
+	   }
+	   if (x + w > _clipX1) {
+	     w = _clipX1 - x;
+	   }
+	   if (y + h > _clipY1) {
+	     h = _clipY1 - y;
+	   }
+	   if (w <= 0 || h <= 0 || _NKK->imageBufferGFX == NULL) {
+	     return 0;
+	   }
+	   NKKsurface image = {_NKK->imageBufferGFX, _NKK->getWidth(), _NKK->getHeigth(), (uint16_t) (_NKK->getWidth() / 8)};
+	   return nkkblit(&image, x, y, src, sx, sy, w, h, rop, mask);
+    }
+
+/**************************************************************************/ 
+/*!
+    @brief  Draws an XBM bitmap (PROGMEM) by a raster operation, see blit().
+    @param  x   Top left corner x coordinate
+    @param  y   Top left corner y coordinate
+    @param  bitmap  XBM bitmap in PROGMEM, LSB first rows of (w+7)/8 bytes
+    @param  w   Width of the bitmap in pixels
+    @param  h   Height of the bitmap in pixels
+    @param  rop NKKblit_Copy, NKKblit_Or, NKKblit_And, NKKblit_Xor or NKKblit_AndNot
+*/
+/**************************************************************************/ 
+void Adafruit_GFX_Ext::drawXBitmapRop(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint8_t rop)
+    {
+#ifdef __AVR__
+	   //PROGMEM is not in the data address space, rows are copied to RAM one by one
+	   uint16_t rowBytes = (w + 7) / 8;
+	   byte *row = (byte *) malloc(rowBytes);
+	   if (row == NULL) {
+	     return;
+	   }
+	   NKKsurface source = {row, (uint16_t) w, 1, rowBytes};
+	   for (int16_t r = 0; r < h; r++) {
+	     memcpy_P(row, bitmap + r * rowBytes, rowBytes);
+	     blit(x, y + r, &source, 0, 0, w, 1, rop);
+	   }
+	   free(row);
+#else
+	   drawXBitmapRop(x, y, (uint8_t *) bitmap, w, h, rop);
+#endif
+    }
+
+/**************************************************************************/ 
+/*!
+    @brief  Draws an XBM bitmap (RAM) by a raster operation, see blit().
+    @param  x   Top left corner x coordinate
+    @param  y   Top left corner y coordinate
+    @param  bitmap  XBM bitmap in RAM, LSB first rows of (w+7)/8 bytes
+    @param  w   Width of the bitmap in pixels
+    @param  h   Height of the bitmap in pixels
+    @param  rop NKKblit_Copy, NKKblit_Or, NKKblit_And, NKKblit_Xor or NKKblit_AndNot
+*/
+/**************************************************************************/ 
+void Adafruit_GFX_Ext::drawXBitmapRop(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, uint8_t rop)
+    {
+	   if (w <= 0 || h <= 0) {
+	     return;
+	   }
+	   NKKsurface source = {bitmap, (uint16_t) w, (uint16_t) h, (uint16_t) ((w + 7) / 8)};
+	   blit(x, y, &source, 0, 0, w, h, rop);
+    }
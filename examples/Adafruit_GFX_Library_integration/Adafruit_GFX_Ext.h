@@ -12,6 +12,8 @@ All text above must be included in any redistribution
 
 #include "src\Adafruit-GFX-Library\Adafruit_GFX.h"
 #include <NKKSmartDisplayLCD.h>
+#include <nkkdither.h>
+#include <nkkblit.h>
 
 /**************************************************************************/
 /*! 
@@ -25,10 +27,38 @@ Adafruit_GFX_Ext(int16_t w, int16_t h, NKK_SmartDisplayLCD *NKK_A);
 ~Adafruit_GFX_Ext(void);
   //Draw a pixel to the imageBufferGFX[] of the NKK_SmartDisplayLCD object
   void drawPixel(int16_t x, int16_t y, uint16_t color);
+  //Set rotation of Adafruit_GFX and the NKK_SmartDisplayLCD object, the image is rotated when it is uploaded to the NKK device
+  void setRotation(uint8_t r);
   //Upload an image to the NKK device from imageBufferGFX[], set background colour and brightness
   void display();
+  //Upload a rectangle of a GFXcanvas1 (at x,y of the canvas buffer) to the NKK device, converted directly to NKK format in one pass
+  bool displayCanvas(GFXcanvas1 *canvas, int16_t x=0, int16_t y=0);
+  //Scroll the imageBufferGFX[] of the NKK_SmartDisplayLCD object, vacated pixels are cleared
+  void scroll(int16_t dx, int16_t dy);
+  //Limit drawing to a rectangle, pixels outside of it are dropped
+  void setClipWindow(int16_t x, int16_t y, int16_t w, int16_t h);
+  void resetClipWindow(void);
+  //Draw only the characters of a text which intersect a vertical strip, clipped to the strip 
+  void drawTextStrip(const char *text, int16_t x, int16_t y, int16_t stripX, int16_t stripW);
+  //Get width of a single line text in pixels, regardless of the display edge and text wrap setting
+  uint16_t getTextWidth(const char *text);
+  //Draw a greyscale (0 - black, 255 - white) or RGB565 bitmap dithered to 1 bit (NKKdither_Bayer or NKKdither_FloydSteinberg), 
+  //whole rows are thresholded and written to the imageBufferGFX[] as packed bytes. const arrays are in PROGMEM as for Adafruit_GFX.
+  void drawGrayscaleBitmapDither(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint8_t method=NKKdither_Bayer);
+  void drawGrayscaleBitmapDither(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, uint8_t method=NKKdither_Bayer);
+  void drawRGBBitmapDither(int16_t x, int16_t y, const uint16_t bitmap[], int16_t w, int16_t h, uint8_t method=NKKdither_Bayer);
+  void drawRGBBitmapDither(int16_t x, int16_t y, uint16_t *bitmap, int16_t w, int16_t h, uint8_t method=NKKdither_Bayer);
+  //Combine a rectangle at sx,sy of a 1 bit surface (LSB first rows) with the imageBufferGFX[] at x,y by a raster operation, a word at a time. 
+  //mask (NULL - none) limits the pixels changed. Clipped to the clip window, returns the number of rows changed.
+  uint16_t blit(int16_t x, int16_t y, const NKKsurface *src, int16_t sx, int16_t sy, int16_t w, int16_t h, uint8_t rop=NKKblit_Copy, const NKKsurface *mask=NULL);
+  //Draw an XBM bitmap (LSB first rows) by a raster operation, NKKblit_Or is Adafruit_GFX drawXBitmap() with color 1. const arrays are in PROGMEM
+  void drawXBitmapRop(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint8_t rop=NKKblit_Or);
+  void drawXBitmapRop(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, uint8_t rop=NKKblit_Or);
 	
 private:
 NKK_SmartDisplayLCD *_NKK; //pointer to the NKK_SmartDisplayLCD object object to communicate with the NKK device
+int16_t _clipX0, _clipY0, _clipX1, _clipY1; //clip window, x1 and y1 are exclusive
+
+  void drawBitmapDither(int16_t x, int16_t y, const void *bitmap, bool isRGB, bool isPROGMEM, int16_t w, int16_t h, uint8_t method);
 };
 #endif // _Adafruit_GFX_Ext_H_
@@ -0,0 +1,68 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+
+  #include "Adafruit_GFX_Marquee.h"
+/**************************************************************************/
+/*!
+    @brief  Constructor for Adafruit_GFX_Marquee object.
+	  @param  A reference (pointer) to Adafruit_GFX_Ext object to draw with. 
+	  @return Adafruit_GFX_Marquee object.
+*/
+/**************************************************************************/
+  Adafruit_GFX_Marquee::Adafruit_GFX_Marquee(Adafruit_GFX_Ext *AGFXExt)
+    {
+	   _AGFXExt = AGFXExt;
+    }
+	
+/**************************************************************************/
+/*!
+    @brief  Destructor for Adafruit_GFX_Marquee object.
+*/
+/**************************************************************************/	
+Adafruit_GFX_Marquee::~Adafruit_GFX_Marquee(void) {
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts scrolling a text. The text enters from the right edge of the display.
+    @param  text A text to scroll, single line. The text is not copied and shall stay valid.
+    @param  y   y coordinate of the text (as per setCursor())
+	  @note   Font, size and colours are taken from the Adafruit_GFX_Ext object at every step.
+*/
+/**************************************************************************/
+void Adafruit_GFX_Marquee::setText(const char *text, int16_t y)
+    {
+      _text = text;
+      _y = y;
+      _textX = _AGFXExt->width();
+      _textW = _AGFXExt->getTextWidth(text);
+    }
+
+/**************************************************************************/
+/*!
+    @brief  Scrolls the text to the left: shifts the image and renders the newly exposed strip only. 
+            When the text has left the display it enters from the right edge again. 
+    @param  pixels Number of pixels to scroll
+*/
+/**************************************************************************/
+void Adafruit_GFX_Marquee::step(uint8_t pixels)
+    {
+      if (_text == NULL || pixels == 0) {
+        return;
+      }
+      int16_t w = _AGFXExt->width();
+      
+      _AGFXExt->scroll(-pixels, 0);
+      _textX -= pixels;
+      if (_textX + (int16_t) _textW <= 0) {
+        _textX += w + _textW; //the text has left the display, restart from the right edge behind the vacated strip
+      }
+      _AGFXExt->drawTextStrip(_text, _textX, _y, w - pixels, pixels);
+    }
@@ -0,0 +1,38 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+#ifndef _Adafruit_GFX_Marquee_H_
+#define _Adafruit_GFX_Marquee_H_
+
+#include "Adafruit_GFX_Ext.h"
+
+/**************************************************************************/
+/*! 
+    @brief  Class that scrolls a text across an NKK device from right to left. Each step shifts imageBufferGFX[] 
+	        and renders only the newly exposed column strip of the text.
+*/
+/**************************************************************************/
+class Adafruit_GFX_Marquee {
+
+public:
+Adafruit_GFX_Marquee(Adafruit_GFX_Ext *AGFXExt);   
+~Adafruit_GFX_Marquee(void);
+  //Start scrolling a text, the text is not copied and shall stay valid. Font, size and colours are taken from the Adafruit_GFX_Ext object
+  void setText(const char *text, int16_t y);
+  //Scroll the text by a number of pixels to the left, call display() of the Adafruit_GFX_Ext object to make it visible
+  void step(uint8_t pixels=1);
+	
+private:
+Adafruit_GFX_Ext *_AGFXExt; //pointer to the Adafruit_GFX_Ext object to draw with
+const char *_text = NULL;
+int16_t _y = 0;         //text y coordinate (as per setCursor())
+int16_t _textX = 0;     //current x coordinate of the text start
+uint16_t _textW = 0;    //text width in pixels
+};
+#endif // _Adafruit_GFX_Marquee_H_
@@ -0,0 +1,383 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+
+  #include "Adafruit_GFX_TextLayout.h"
+/**************************************************************************/
+/*!
+    @brief  Constructor for Adafruit_GFX_TextLayout object.
+	  @param  A reference (pointer) to Adafruit_GFX object to measure and draw with, e.g. Adafruit_GFX_Ext or Adafruit_GFX_Tiled.
+	  @return Adafruit_GFX_TextLayout object.
+	  @note   The classic font, text size 1 is the only candidate until setFonts() and setMaxTextSize() are called.
+*/
+/**************************************************************************/
+  Adafruit_GFX_TextLayout::Adafruit_GFX_TextLayout(Adafruit_GFX *AGFX)
+    {
+	   _AGFX = AGFX;
+	   _fonts[0] = NULL;
+	   _layout.numLines = 0;
+	   clearCache();
+    }
+
+/**************************************************************************/
+/*!
+    @brief  Destructor for Adafruit_GFX_TextLayout object.
+*/
+/**************************************************************************/
+Adafruit_GFX_TextLayout::~Adafruit_GFX_TextLayout(void) {
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets candidate fonts.
+    @param  fonts  An array of pointers to fonts, NULL is the classic font. The fonts are not copied and shall stay valid.
+    @param  numFonts  Number of fonts, 1 to Adafruit_GFX_TextLayout_MaxFonts
+	  @note   Clears the cache.
+*/
+/**************************************************************************/
+void Adafruit_GFX_TextLayout::setFonts(const GFXfont *fonts[], uint8_t numFonts)
+    {
+      if (numFonts == 0) {
+        return;
+      }
+      if (numFonts > Adafruit_GFX_TextLayout_MaxFonts) {
+        numFonts = Adafruit_GFX_TextLayout_MaxFonts;
+      }
+      for (uint8_t i = 0; i < numFonts; i++) {
+        _fonts[i] = fonts[i];
+      }
+      _numFonts = numFonts;
+      clearCache();
+    }
+
+/**************************************************************************/
+/*!
+    @brief  Sets the largest text size tried for every font.
+    @param  maxTextSize  Text sizes 1 to maxTextSize are tried
+	  @note   Clears the layout cache.
+*/
+/**************************************************************************/
+void Adafruit_GFX_TextLayout::setMaxTextSize(uint8_t maxTextSize)
+    {
+      _maxTextSize = (maxTextSize > 0) ? maxTextSize : 1;
+      for (uint8_t i = 0; i < Adafruit_GFX_TextLayout_LayoutCacheSize; i++) {
+        _layoutCache[i].hash = 0;
+      }
+    }
+
+/**************************************************************************/
+/*!
+    @brief  Finds the largest font and text size which fit the text into a box.
+            The largest is the one with the tallest block of lines, for the same height the first font in the setFonts() list.
+    @param  text  A text, '\n' starts a new line
+    @param  w  Box width in pixels
+    @param  h  Box height in pixels
+    @param  options  Adafruit_GFX_TextLayout_Left/Center/Right, Adafruit_GFX_TextLayout_Top/Middle/Bottom, Adafruit_GFX_TextLayout_Wrap
+    @return true if the text fits
+	  @note   The same text, box size and options are looked up in the layout cache, no measurement is done.
+	          A text longer than Adafruit_GFX_TextLayout_MaxCachedLength is not cached.
+	          The text wrap of the Adafruit_GFX object is turned off, the font and text size are changed.
+*/
+/**************************************************************************/
+bool Adafruit_GFX_TextLayout::fit(const char *text, uint16_t w, uint16_t h, uint8_t options)
+    {
+      _layout.numLines = 0;
+      if (text == NULL) {
+        return false;
+      }
+      size_t length = strlen(text);
+      bool isCached = (length <= Adafruit_GFX_TextLayout_MaxCachedLength);
+      uint32_t textHash = isCached ? hash(text, length) : 0;
+
+      for (uint8_t i = 0; isCached && i < Adafruit_GFX_TextLayout_LayoutCacheSize; i++) {
+        CachedLayout *cached = &_layoutCache[i];
+        if (cached->hash == textHash && cached->length == length && cached->w == w && cached->h == h && cached->options == options
+            && memcmp(cached->text, text, length) == 0) {
+          _layout = cached->layout;
+          return _layout.numLines > 0;
+        }
+      }
+
+      _AGFX->setTextWrap(false);
+      Layout candidate;
+      uint16_t bestH = 0;
+      for (uint8_t font = 0; font < _numFonts; font++) {
+        //a bigger text size is a taller block, so the first size which fits is the largest for this font
+        for (uint8_t size = _maxTextSize; size > 0; size--) {
+          uint16_t blockW, blockH;
+          if (layoutLines(text, font, size, w, h, options, &candidate, &blockW, &blockH)) {
+            if (blockH > bestH) {
+              bestH = blockH;
+              _layout = candidate;
+            }
+            break;
+          }
+        }
+      }
+
+      //a text which does not fit is cached as well, as a layout with no lines
+      if (isCached) {
+        CachedLayout *entry = &_layoutCache[_nextLayout];
+        entry->hash = textHash;
+        entry->length = length;
+        entry->w = w;
+        entry->h = h;
+        entry->options = options;
+        memcpy(entry->text, text, length);
+        entry->layout = _layout;
+        _nextLayout = (_nextLayout + 1) % Adafruit_GFX_TextLayout_LayoutCacheSize;
+      }
+      return _layout.numLines > 0;
+    }
+
+/**************************************************************************/
+/*!
+    @brief  Fits the text into a box and draws it with the current text colour.
+    @param  text  A text, '\n' starts a new line
+    @param  x  Box top left corner x coordinate
+    @param  y  Box top left corner y coordinate
+    @param  w  Box width in pixels
+    @param  h  Box height in pixels
+    @param  options  Adafruit_GFX_TextLayout_Left/Center/Right, Adafruit_GFX_TextLayout_Top/Middle/Bottom, Adafruit_GFX_TextLayout_Wrap
+    @return true if the text fits, false - nothing is drawn
+	  @note   The chosen font and text size stay set in the Adafruit_GFX object.
+*/
+/**************************************************************************/
+bool Adafruit_GFX_TextLayout::print(const char *text, int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t options)
+    {
+      if (!fit(text, w, h, options)) {
+        return false;
+      }
+      _AGFX->setTextWrap(false);
+      selectFont(_layout.font, _layout.size);
+      for (uint8_t i = 0; i < _layout.numLines; i++) {
+        Line *line = &_layout.lines[i];
+        _AGFX->setCursor(x + line->x, y + line->y);
+        _AGFX->write((const uint8_t *) text + line->start, line->length);
+      }
+      return true;
+    }
+
+/**************************************************************************/
+/*!
+    @brief  Gets the font chosen by the last fit() or print()
+    @return Font index in the setFonts() list
+*/
+/**************************************************************************/
+uint8_t Adafruit_GFX_TextLayout::getFontIndex(void)
+    {
+      return _layout.font;
+    }
+
+/**************************************************************************/
+/*!
+    @brief  Gets the text size chosen by the last fit() or print()
+    @return Text size
+*/
+/**************************************************************************/
+uint8_t Adafruit_GFX_TextLayout::getTextSize(void)
+    {
+      return _layout.size;
+    }
+
+/**************************************************************************/
+/*!
+    @brief  Gets the number of lines of the last fit() or print()
+    @return Number of lines, 0 if the text did not fit
+*/
+/**************************************************************************/
+uint8_t Adafruit_GFX_TextLayout::getNumLines(void)
+    {
+      return _layout.numLines;
+    }
+
+/**************************************************************************/
+/*!
+    @brief  Clears the measurement and layout caches.
+	  @note   Call it if a font used in setFonts() list has been changed.
+*/
+/**************************************************************************/
+void Adafruit_GFX_TextLayout::clearCache(void)
+    {
+      for (uint8_t i = 0; i < Adafruit_GFX_TextLayout_MeasureCacheSize; i++) {
+        _measureCache[i].hash = 0;
+      }
+      for (uint8_t i = 0; i < Adafruit_GFX_TextLayout_LayoutCacheSize; i++) {
+        _layoutCache[i].hash = 0;
+      }
+    }
+
+// Splits the text into lines for a font and size, and places them in a w*h box. Returns false if the text does not fit
+bool Adafruit_GFX_TextLayout::layoutLines(const char *text, uint8_t font, uint8_t size, uint16_t w, uint16_t h, uint8_t options, Layout *layout, uint16_t *blockW, uint16_t *blockH)
+    {
+      int16_t x1[Adafruit_GFX_TextLayout_MaxLines], y1[Adafruit_GFX_TextLayout_MaxLines];
+      uint16_t lineW[Adafruit_GFX_TextLayout_MaxLines], lineH[Adafruit_GFX_TextLayout_MaxLines];
+      uint8_t numLines = 0;
+      uint16_t pos = 0;
+
+      while (true) {
+        if (numLines == Adafruit_GFX_TextLayout_MaxLines) {
+          return false;
+        }
+        uint16_t start = pos;
+        uint16_t end = pos;   //end of the line found so far
+        while (text[end] != '\0' && text[end] != '\n') {
+          end++;
+        }
+        if ((options & Adafruit_GFX_TextLayout_Wrap) && end > start) {
+          //greedy: add words while the line fits the box width
+          uint16_t fitEnd = start;
+          uint16_t wordEnd = start;
+          while (wordEnd < end) {
+            while (wordEnd < end && text[wordEnd] == ' ') {
+              wordEnd++;
+            }
+            while (wordEnd < end && text[wordEnd] != ' ') {
+              wordEnd++;
+            }
+            int16_t bx, by;
+            uint16_t bw, bh;
+            if (!measure(text + start, wordEnd - start, font, size, &bx, &by, &bw, &bh) || bw > w) {
+              break;
+            }
+            fitEnd = wordEnd;
+            x1[numLines] = bx; y1[numLines] = by; lineW[numLines] = bw; lineH[numLines] = bh;
+          }
+          if (fitEnd == start) {
+            return false; //a word is wider than the box
+          }
+          pos = fitEnd;
+          while (text[pos] == ' ') {
+            pos++; //spaces at the break are dropped
+          }
+          end = fitEnd;
+        }
+        else {
+          if (!measure(text + start, end - start, font, size, &x1[numLines], &y1[numLines], &lineW[numLines], &lineH[numLines]) || lineW[numLines] > w) {
+            return false;
+          }
+          pos = end;
+        }
+        layout->lines[numLines].start = start;
+        layout->lines[numLines].length = end - start;
+        numLines++;
+
+        if (text[pos] == '\n') {
+          pos++;
+        }
+        else if (text[pos] == '\0') {
+          break;
+        }
+      }
+
+      //block of lines: lines are yAdvance apart, the block is from the top of the first glyphs to the bottom of the last ones
+      int16_t pitch = (_fonts[font] == NULL) ? 8 * size : (uint8_t) pgm_read_byte(&_fonts[font]->yAdvance) * size;
+      int16_t top = 0x7FFF, bottom = -0x7FFF;
+      uint16_t maxW = 0;
+      for (uint8_t i = 0; i < numLines; i++) {
+        if (lineH[i] == 0) {
+          continue; //empty line
+        }
+        int16_t lineTop = i * pitch + y1[i];
+        if (lineTop < top) {
+          top = lineTop;
+        }
+        if (lineTop + (int16_t) lineH[i] > bottom) {
+          bottom = lineTop + lineH[i];
+        }
+        if (lineW[i] > maxW) {
+          maxW = lineW[i];
+        }
+      }
+      if (top > bottom) {
+        return false; //nothing to draw
+      }
+      if (bottom - top > (int16_t) h) {
+        return false;
+      }
+      *blockW = maxW;
+      *blockH = bottom - top;
+
+      int16_t dy = -top;
+      if (options & Adafruit_GFX_TextLayout_Middle) {
+        dy += (h - *blockH) / 2;
+      }
+      else if (options & Adafruit_GFX_TextLayout_Bottom) {
+        dy += h - *blockH;
+      }
+      for (uint8_t i = 0; i < numLines; i++) {
+        int16_t dx = -x1[i];
+        if (options & Adafruit_GFX_TextLayout_Center) {
+          dx += (w - lineW[i]) / 2;
+        }
+        else if (options & Adafruit_GFX_TextLayout_Right) {
+          dx += w - lineW[i];
+        }
+        layout->lines[i].x = dx;
+        layout->lines[i].y = i * pitch + dy;
+      }
+      layout->font = font;
+      layout->size = size;
+      layout->numLines = numLines;
+      return true;
+    }
+
+// Bounds of a part of the text at the cursor 0,0, from the measurement cache or getTextBounds(). Returns false if the part is too long
+bool Adafruit_GFX_TextLayout::measure(const char *text, uint16_t length, uint8_t font, uint8_t size, int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h)
+    {
+      if (length > Adafruit_GFX_TextLayout_MaxLineLength) {
+        return false;
+      }
+      if (length == 0) {
+        *x1 = 0; *y1 = 0; *w = 0; *h = 0;
+        return true;
+      }
+      uint32_t textHash = hash(text, length);
+      for (uint8_t i = 0; i < Adafruit_GFX_TextLayout_MeasureCacheSize; i++) {
+        Measure *cached = &_measureCache[i];
+        if (cached->hash == textHash && cached->length == length && cached->font == _fonts[font] && cached->size == size
+            && memcmp(cached->text, text, length) == 0) {
+          *x1 = cached->x1; *y1 = cached->y1; *w = cached->w; *h = cached->h;
+          return true;
+        }
+      }
+
+      char line[Adafruit_GFX_TextLayout_MaxLineLength + 1];
+      memcpy(line, text, length);
+      line[length] = '\0';
+      selectFont(font, size);
+      _AGFX->getTextBounds(line, 0, 0, x1, y1, w, h);
+
+      Measure *entry = &_measureCache[_nextMeasure];
+      entry->hash = textHash;
+      entry->length = length;
+      memcpy(entry->text, text, length);
+      entry->font = _fonts[font];
+      entry->size = size;
+      entry->x1 = *x1; entry->y1 = *y1; entry->w = *w; entry->h = *h;
+      _nextMeasure = (_nextMeasure + 1) % Adafruit_GFX_TextLayout_MeasureCacheSize;
+      return true;
+    }
+
+// Sets a font from setFonts() list and a text size to the Adafruit_GFX object
+void Adafruit_GFX_TextLayout::selectFont(uint8_t font, uint8_t size)
+    {
+      _AGFX->setFont(_fonts[font]);
+      _AGFX->setTextSize(size);
+    }
+
+// FNV-1a hash of a text, never 0 (0 marks an unused cache entry)
+uint32_t Adafruit_GFX_TextLayout::hash(const char *text, uint16_t length)
+    {
+      uint32_t h = 2166136261UL;
+      for (uint16_t i = 0; i < length; i++) {
+        h = (h ^ (uint8_t) text[i]) * 16777619UL;
+      }
+      return (h != 0) ? h : 1;
+    }
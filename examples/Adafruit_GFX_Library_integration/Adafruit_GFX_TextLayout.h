@@ -0,0 +1,112 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+#ifndef _Adafruit_GFX_TextLayout_H_
+#define _Adafruit_GFX_TextLayout_H_
+
+#include "src\Adafruit-GFX-Library\Adafruit_GFX.h"
+
+#define Adafruit_GFX_TextLayout_MaxFonts 4
+#define Adafruit_GFX_TextLayout_MaxLines 4
+#define Adafruit_GFX_TextLayout_MaxLineLength 32  //characters per line, longer lines do not fit
+#define Adafruit_GFX_TextLayout_MeasureCacheSize 8
+#define Adafruit_GFX_TextLayout_LayoutCacheSize 4
+#define Adafruit_GFX_TextLayout_MaxCachedLength 48 //characters, a longer text is laid out on every fit()
+
+//Layout options, one horizontal and one vertical alignment can be combined with Wrap
+#define Adafruit_GFX_TextLayout_Left 0x00
+#define Adafruit_GFX_TextLayout_Center 0x01
+#define Adafruit_GFX_TextLayout_Right 0x02
+#define Adafruit_GFX_TextLayout_Top 0x00
+#define Adafruit_GFX_TextLayout_Middle 0x04
+#define Adafruit_GFX_TextLayout_Bottom 0x08
+#define Adafruit_GFX_TextLayout_Wrap 0x10   //break lines between words to fit the box width, '\n' always breaks a line
+
+/**************************************************************************/
+/*!
+    @brief  Class that fits a text into a box - picks the largest of the candidate fonts and text sizes which fits,
+	        wraps and aligns the lines. Measurements (per text, font and size) and layouts (per text, box size and options)
+	        are cached, so a layout of the same text is a cache lookup. A cache entry keeps a copy of its text,
+	        a hit compares the whole text, not only its hash.
+*/
+/**************************************************************************/
+class Adafruit_GFX_TextLayout {
+
+public:
+Adafruit_GFX_TextLayout(Adafruit_GFX *AGFX);
+~Adafruit_GFX_TextLayout(void);
+  //Candidate fonts, NULL is the classic font. Fonts are not copied and shall stay valid
+  void setFonts(const GFXfont *fonts[], uint8_t numFonts);
+  //Text sizes tried for every font, 1 to maxTextSize
+  void setMaxTextSize(uint8_t maxTextSize);
+  //Find the largest font and size which fits the text into a w*h box, returns false if nothing fits
+  bool fit(const char *text, uint16_t w, uint16_t h, uint8_t options);
+  //Fit and draw the text into the box at x,y with the current text colour, returns false (nothing drawn) if nothing fits
+  bool print(const char *text, int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t options);
+  //Font and text size chosen by the last fit(), a font index in setFonts() list
+  uint8_t getFontIndex(void);
+  uint8_t getTextSize(void);
+  uint8_t getNumLines(void);
+  //Forget all measurements and layouts e.g. after the fonts are changed
+  void clearCache(void);
+
+private:
+Adafruit_GFX *_AGFX; //pointer to the Adafruit_GFX object to measure and draw with
+const GFXfont *_fonts[Adafruit_GFX_TextLayout_MaxFonts];
+uint8_t _numFonts = 1;
+uint8_t _maxTextSize = 1;
+
+struct Line {
+  uint16_t start; // first character in the text
+  uint8_t length; // number of characters
+  int16_t x;      // cursor position relative to the box
+  int16_t y;
+};
+
+struct Layout {
+  uint8_t font;     // font index
+  uint8_t size;     // text size
+  uint8_t numLines;
+  Line lines[Adafruit_GFX_TextLayout_MaxLines];
+};
+
+struct CachedLayout {
+  uint32_t hash;    // text hash, 0 - unused entry
+  uint8_t length;   // text length
+  uint16_t w;       // box size
+  uint16_t h;
+  uint8_t options;
+  char text[Adafruit_GFX_TextLayout_MaxCachedLength]; // copy of the text, not terminated
+  Layout layout;
+};
+
+struct Measure {
+  uint32_t hash;    // text hash, 0 - unused entry
+  const GFXfont *font; // font, NULL - the classic font
+  uint8_t size;     // text size
+  uint8_t length;   // text length
+  char text[Adafruit_GFX_TextLayout_MaxLineLength]; // copy of the text, not terminated
+  int16_t x1;       // bounds relative to the cursor at 0,0
+  int16_t y1;
+  uint16_t w;
+  uint16_t h;
+};
+
+Layout _layout; //result of the last fit()
+CachedLayout _layoutCache[Adafruit_GFX_TextLayout_LayoutCacheSize];
+uint8_t _nextLayout = 0;
+Measure _measureCache[Adafruit_GFX_TextLayout_MeasureCacheSize];
+uint8_t _nextMeasure = 0;
+
+  bool layoutLines(const char *text, uint8_t font, uint8_t size, uint16_t w, uint16_t h, uint8_t options, Layout *layout, uint16_t *blockW, uint16_t *blockH);
+  bool measure(const char *text, uint16_t length, uint8_t font, uint8_t size, int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h);
+  void selectFont(uint8_t font, uint8_t size);
+  uint32_t hash(const char *text, uint16_t length);
+};
+#endif // _Adafruit_GFX_TextLayout_H_
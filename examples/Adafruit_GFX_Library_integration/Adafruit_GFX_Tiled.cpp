@@ -0,0 +1,248 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+
+  #include "Adafruit_GFX_Tiled.h"
+/**************************************************************************/
+/*!
+    @brief  Constructor for Adafruit_GFX_Tiled object - a virtual canvas which spans a grid of NKK LCD 64x32 SmartDisplay devices.
+    @param  cols Number of tile columns.
+	  @param  rows Number of tile rows. cols*rows is up to Adafruit_GFX_Tiled_MaxTiles.
+	  @param  tileW Tile width in pixels (as seen on the canvas).
+	  @param  tileH Tile height in pixels (as seen on the canvas).
+	  @param  gapX Horizontal gap between tiles in pixels, e.g. the space between keys on a panel.
+	  @param  gapY Vertical gap between tiles in pixels.
+	  @return Adafruit_GFX_Tiled object.
+    @note   Extension of  Adafruit_GFX class. Attach NKK_SmartDisplayLCD objects with setTile(). 
+	          The grid is clamped before the canvas is sized: cols to 1..Adafruit_GFX_Tiled_MaxTiles, 
+	          rows to 1..Adafruit_GFX_Tiled_MaxTiles/cols.
+*/
+/**************************************************************************/
+  Adafruit_GFX_Tiled::Adafruit_GFX_Tiled(uint8_t cols, uint8_t rows, uint8_t tileW, uint8_t tileH, uint8_t gapX, uint8_t gapY)
+    : Adafruit_GFX(clampCols(cols)*tileW + (clampCols(cols)-1)*gapX, clampRows(cols, rows)*tileH + (clampRows(cols, rows)-1)*gapY)
+    {
+     _cols = clampCols(cols);
+     _rows = clampRows(cols, rows);
+     _tileW = tileW;
+     _tileH = tileH;
+     _gapX = gapX;
+     _gapY = gapY;
+
+     for (uint8_t t = 0; t < Adafruit_GFX_Tiled_MaxTiles; t++) {
+       _tiles[t].NKK = NULL;
+       _tiles[t].changed = true;
+     }
+    }
+
+/**************************************************************************/
+/*!
+    @brief  Destructor for Adafruit_GFX_Tiled object.
+*/
+/**************************************************************************/
+Adafruit_GFX_Tiled::~Adafruit_GFX_Tiled(void) {
+}
+
+/**************************************************************************/
+/*!
+    @brief  Attach an NKK_SmartDisplayLCD object to a tile.
+    @param  col Tile column, starts with 0 (left)
+    @param  row Tile row, starts with 0 (top)
+    @param  NKK_A A reference (pointer) to NKK_SmartDisplayLCD object.
+    @param  rotation Rotation of the tile content on the key, 0-3 in 90 degree steps clockwise (as Adafruit_GFX setRotation())
+	  @return true if the tile is attached, false if the position is out of the grid or the key size does not fit the tile
+	  @note   For rotation 1 and 3 the key width and height are swapped i.e. a 64x32 key fits a 32x64 tile. 
+	          The rotation is set on the key with setRotation(), so it is applied on upload and not per pixel.
+*/
+/**************************************************************************/
+bool Adafruit_GFX_Tiled::setTile(uint8_t col, uint8_t row, NKK_SmartDisplayLCD *NKK_A, uint8_t rotation)
+    {
+      if (col >= _cols || row >= _rows || NKK_A == NULL) {
+        return false;
+      }
+      rotation = rotation & 3;
+      uint8_t w = (rotation & 1) ? NKK_A->getHeigth() : NKK_A->getWidth();
+      uint8_t h = (rotation & 1) ? NKK_A->getWidth() : NKK_A->getHeigth();
+      if (NKK_A->getRotation() & 1) { //size as configured in the constructor 
+        uint8_t t = w;
+        w = h;
+        h = t;
+      }
+      if (w != _tileW || h != _tileH) {
+        return false;
+      }
+      NKK_A->setRotation(rotation);
+      Tile *tile = &_tiles[row*_cols + col];
+      tile->NKK = NKK_A;
+      tile->changed = true;
+      return true;
+    }
+
+/**************************************************************************/
+/*!
+    @brief  Draw a pixel to the imageBufferGFX[] of the NKK_SmartDisplayLCD object under the pixel
+    @param  x   x coordinate on the canvas, starts with 0
+    @param  y   y coordinate on the canvas, starts with 0
+    @param  color
+	  @note   Pixels in the gaps between tiles and on tiles without an NKK_SmartDisplayLCD object are dropped.
+	          A tile is marked changed only if the pixel flips, so redrawing the same content uploads nothing.
+*/
+/**************************************************************************/
+void Adafruit_GFX_Tiled::drawPixel( int16_t x, int16_t y, uint16_t color)
+    {
+      if ((x < 0) || (y < 0) || (x >= _width) || (y >= _height)) {
+        return;
+      }
+
+      //canvas rotation, same as GFXcanvas1
+      int16_t t;
+      switch (rotation) {
+      case 1:
+        t = x;
+        x = WIDTH - 1 - y;
+        y = t;
+        break;
+      case 2:
+        x = WIDTH - 1 - x;
+        y = HEIGHT - 1 - y;
+        break;
+      case 3:
+        t = x;
+        x = y;
+        y = HEIGHT - 1 - t;
+        break;
+      }
+
+      //tile and position in the tile
+      uint8_t col = x / (_tileW + _gapX);
+      uint8_t row = y / (_tileH + _gapY);
+      uint8_t lx = x - col * (_tileW + _gapX);
+      uint8_t ly = y - row * (_tileH + _gapY);
+      if (lx >= _tileW || ly >= _tileH || col >= _cols || row >= _rows) {
+        return; //gap
+      }
+      Tile *tile = &_tiles[row*_cols + col];
+      if (tile->NKK == NULL || tile->NKK->imageBufferGFX == NULL) {
+        return;
+      }
+
+      //tile rotation is applied by the key on upload, the GFX buffer of the key is row by row with bit 0 first 
+      uint16_t n = ly * tile->NKK->getWidth() + lx;
+      bool isSet = (tile->NKK->imageBufferGFX[n / 8] >> (n % 8)) & 1;
+      if (isSet != (color != 0)) {
+        tile->NKK->drawPixel(lx, ly, (uint8_t) color);
+        tile->changed = true;
+      }
+    }
+
+/**************************************************************************/
+/*!
+    @brief  Fill imageBufferGFX[] of all tiles
+    @param  color 0 - clear, any other value - set all pixels
+*/
+/**************************************************************************/
+void Adafruit_GFX_Tiled::fillScreen(uint16_t color)
+    {
+      for (uint8_t t = 0; t < _cols*_rows; t++) {
+        NKK_SmartDisplayLCD *key = _tiles[t].NKK;
+        if (key == NULL || key->imageBufferGFX == NULL) {
+          continue;
+        }
+        byte fill = color ? 0xFF : 0x00;
+        for (uint16_t i = 0; i < key->getImageBufferLength(); i++) {
+          if (key->imageBufferGFX[i] != fill) {
+            memset(key->imageBufferGFX, fill, key->getImageBufferLength());
+            _tiles[t].changed = true;
+            break;
+          }
+        }
+      }
+    }
+
+/**************************************************************************/
+/*!
+    @brief  Uploads tiles whose image, colour or brightness changed since the last upload.
+	@return Number of tiles uploaded
+	@note   A tile is changed when a pixel drawn through this object flips (drawPixel(), fillScreen()), unchanged tiles cost no SPI traffic. 
+	        Call invalidate() after imageBufferGFX[] of a key is written directly.
+*/
+/**************************************************************************/
+uint8_t Adafruit_GFX_Tiled::display()
+    {
+      uint8_t count = 0;
+      for (uint8_t t = 0; t < _cols*_rows; t++) {
+        Tile *tile = &_tiles[t];
+        if (tile->NKK == NULL || tile->NKK->imageBufferGFX == NULL) {
+          continue;
+        }
+        if (!tile->changed && tile->colour == tile->NKK->bkgColour && tile->brightness == tile->NKK->bkgBrightnes) {
+          continue;
+        }
+        displayTile(tile);
+        count++;
+      }
+      return count;
+    }
+
+/**************************************************************************/
+/*!
+    @brief  Uploads all tiles regardless of changes.
+*/
+/**************************************************************************/
+void Adafruit_GFX_Tiled::displayAll()
+    {
+      for (uint8_t t = 0; t < _cols*_rows; t++) {
+        Tile *tile = &_tiles[t];
+        if (tile->NKK == NULL || tile->NKK->imageBufferGFX == NULL) {
+          continue;
+        }
+        displayTile(tile);
+      }
+    }
+
+/**************************************************************************/
+/*!
+    @brief  Marks all tiles changed, the next display() uploads them.
+	@note   Call it after imageBufferGFX[] of a key is written other than through this object e.g. directly or with drawPixel() of the key.
+*/
+/**************************************************************************/
+void Adafruit_GFX_Tiled::invalidate()
+    {
+      for (uint8_t t = 0; t < Adafruit_GFX_Tiled_MaxTiles; t++) {
+        _tiles[t].changed = true;
+      }
+    }
+
+//Uploads a tile and saves its state
+void Adafruit_GFX_Tiled::displayTile(Tile *tile)
+    {
+      tile->NKK->display();
+      tile->changed = false;
+      tile->colour = tile->NKK->bkgColour;
+      tile->brightness = tile->NKK->bkgBrightnes;
+    }
+
+
+//Number of tile columns, 1 to Adafruit_GFX_Tiled_MaxTiles
+uint8_t Adafruit_GFX_Tiled::clampCols(uint8_t cols)
+    {
+      if (cols == 0) {
+        return 1;
+      }
+      return (cols > Adafruit_GFX_Tiled_MaxTiles) ? Adafruit_GFX_Tiled_MaxTiles : cols;
+    }
+
+//Number of tile rows, 1 to Adafruit_GFX_Tiled_MaxTiles/columns
+uint8_t Adafruit_GFX_Tiled::clampRows(uint8_t cols, uint8_t rows)
+    {
+      uint8_t maxRows = Adafruit_GFX_Tiled_MaxTiles / clampCols(cols);
+      if (rows == 0) {
+        return 1;
+      }
+      return (rows > maxRows) ? maxRows : rows;
+    }
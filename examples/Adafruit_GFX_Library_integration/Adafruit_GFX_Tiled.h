@@ -0,0 +1,63 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+#ifndef _Adafruit_GFX_Tiled_H_
+#define _Adafruit_GFX_Tiled_H_
+
+#include "src\Adafruit-GFX-Library\Adafruit_GFX.h"
+#include <NKKSmartDisplayLCD.h>
+
+#define Adafruit_GFX_Tiled_MaxTiles 16
+
+/**************************************************************************/
+/*!
+    @brief  Class that extends Adafruit_GFX with a virtual canvas spanning a grid of NKK_SmartDisplayLCD objects.
+	        Canvas is (cols*tileW + (cols-1)*gapX) x (rows*tileH + (rows-1)*gapY) pixels, pixels in the gaps are not stored.
+	        A grid of more than Adafruit_GFX_Tiled_MaxTiles tiles is clamped (rows first) before the canvas is sized.
+*/
+/**************************************************************************/
+class Adafruit_GFX_Tiled : public Adafruit_GFX {
+
+public:
+Adafruit_GFX_Tiled(uint8_t cols, uint8_t rows, uint8_t tileW=64, uint8_t tileH=32, uint8_t gapX=0, uint8_t gapY=0);
+~Adafruit_GFX_Tiled(void);
+  //Attach an NKK_SmartDisplayLCD object to a tile, rotation 0-3 is the tile content rotation on the key in 90 degree steps clockwise (sets the key rotation)
+  bool setTile(uint8_t col, uint8_t row, NKK_SmartDisplayLCD *NKK_A, uint8_t rotation=0);
+  //Draw a pixel to the imageBufferGFX[] of the NKK_SmartDisplayLCD object under the pixel
+  void drawPixel(int16_t x, int16_t y, uint16_t color);
+  //Fill imageBufferGFX[] of all tiles
+  void fillScreen(uint16_t color);
+  //Upload tiles whose image, colour or brightness changed since the last upload, returns number of tiles uploaded
+  uint8_t display();
+  //Upload all tiles
+  void displayAll();
+  //Mark all tiles changed, call it after imageBufferGFX[] of a key is written other than through this object
+  void invalidate();
+
+private:
+uint8_t _cols;
+uint8_t _rows;
+uint8_t _tileW;
+uint8_t _tileH;
+uint8_t _gapX;
+uint8_t _gapY;
+
+struct Tile {
+  NKK_SmartDisplayLCD *NKK; //pointer to the NKK_SmartDisplayLCD object object to communicate with the NKK device
+  bool changed;   // imageBufferGFX[] changed since the last upload (a pixel flipped, fillScreen(), setTile(), invalidate())
+  byte colour;    // bkgColour of the last upload
+  byte brightness;  // bkgBrightnes of the last upload
+};
+Tile _tiles[Adafruit_GFX_Tiled_MaxTiles];
+
+  void displayTile(Tile *tile);
+  static uint8_t clampCols(uint8_t cols);
+  static uint8_t clampRows(uint8_t cols, uint8_t rows);
+};
+#endif // _Adafruit_GFX_Tiled_H_
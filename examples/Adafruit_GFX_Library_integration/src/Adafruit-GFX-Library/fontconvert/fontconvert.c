@@ -8,6 +8,22 @@ fonts to be used with the Adafruit_GFX Arduino library.
 For UNIX-like systems.  Outputs to stdout; redirect to header file, e.g.:
   ./fontconvert ~/Library/Fonts/FreeSans.ttf 18 > FreeSans18pt7b.h
 
+NKK mode: -l (Landscape) or -p (Portrait) as the first argument outputs a font in
+NKK native format (NKKfont, see nkkfont.h in the NKK SmartDisplay library root)
+which is drawn directly into imageBufferNKK[], e.g.:
+  ./fontconvert -l ~/Library/Fonts/FreeSans.ttf 9 > FreeSans9pt7bNKKL.h
+
+Flash saving options (before the font file name):
+  -s chars  subset: only glyphs of the characters in chars get a bitmap
+  -f file   subset: only glyphs of the characters found in file (e.g. a list
+            of label strings) get a bitmap
+  -c        glyph bitmaps compressed per row (NKK mode only): repeats of the
+            previous row (column in Portrait) are stored as a count, decoded
+            by the NKK renderer while a glyph is drawn
+Characters out of the subset are empty glyphs, first and last are narrowed
+to the subset, e.g.:
+  ./fontconvert -l -c -f labels.txt ~/Library/Fonts/FreeSans.ttf 24 > FreeSans24pt7bNKKL.h
+
 REQUIRES FREETYPE LIBRARY.  www.freetype.org
 
 Currently this only extracts the printable 7-bit ASCII chars of a font.
@@ -29,6 +45,58 @@ See notes at end for glyph nomenclature & other tidbits.
 
 #define DPI 141 // Approximate res. of Adafruit 2.8" TFT
 
+// Output formats
+#define MODE_GFX 0           // Adafruit_GFX font, bit-packed MSB first rows
+#define MODE_NKK_LANDSCAPE 1 // NKKfont, byte aligned LSB first rows
+#define MODE_NKK_PORTRAIT 2  // NKKfont, byte aligned MSB first columns
+
+void enbit(uint8_t value);
+
+// Write a byte for output, MSB first
+void enbyte(uint8_t value) {
+  uint8_t bit;
+  for (bit = 0x80; bit; bit >>= 1)
+    enbit(value & bit);
+}
+
+// Number of lines from line i which are equal to line i-1, up to 128
+int repeatedLines(const uint8_t *src, int lineBytes, int numLines, int i) {
+  int run = 0;
+  if (i == 0)
+    return 0;
+  while ((i + run < numLines) && (run < 128) &&
+         !memcmp(&src[(i + run) * lineBytes], &src[(i - 1) * lineBytes],
+                 lineBytes))
+    run++;
+  return run;
+}
+
+// Per row RLE of numLines lines of lineBytes bytes (glyph rows in Landscape,
+// columns in Portrait) of src into dst (n + numLines / 128 + 1 bytes max),
+// returns compressed length. Header h: 0..127 - h+1 literal lines follow,
+// 128..255 - the previous line is repeated h-127 times. Stems and bars repeat
+// a line, a repeat costs a header. Repeats shorter than 3 bytes are kept in
+// literal blocks, so output never grows by more than a header per 128 lines.
+int rowRLE(const uint8_t *src, int lineBytes, int numLines, uint8_t *dst) {
+  int i = 0, o = 0, run, start;
+  while (i < numLines) {
+    run = repeatedLines(src, lineBytes, numLines, i);
+    if (run * lineBytes >= 3) { // Repeats of the previous line
+      dst[o++] = (uint8_t)(127 + run);
+      i += run;
+    } else { // Literal block, up to the next worthwhile repeat
+      start = i++;
+      while ((i < numLines) && (i - start < 128) &&
+             (repeatedLines(src, lineBytes, numLines, i) * lineBytes < 3))
+        i++;
+      dst[o++] = (uint8_t)(i - start - 1);
+      memcpy(&dst[o], &src[start * lineBytes], (i - start) * lineBytes);
+      o += (i - start) * lineBytes;
+    }
+  }
+  return o;
+}
+
 // Accumulate bits for output, with periodic hexadecimal byte write
 void enbit(uint8_t value) {
   static uint8_t row = 0, sum = 0, bit = 0x80, firstCall = 1;
@@ -59,7 +127,11 @@ int main(int argc, char *argv[]) {
   FT_Bitmap *bitmap;
   FT_BitmapGlyphRec *g;
   GFXglyph *table;
-  uint8_t bit;
+  uint8_t bit, *glyphBytes, *packed;
+  int mode = MODE_GFX, compress = 0, isSubset = 0, glyphLength, ch;
+  char *progName = argv[0];
+  static uint8_t subset[256]; // Characters of the subset
+  FILE *fp;
 
   // Parse command line.  Valid syntaxes are:
   //   fontconvert [filename] [size]
@@ -67,9 +139,63 @@ int main(int argc, char *argv[]) {
   //   fontconvert [filename] [size] [first char] [last char]
   // Unless overridden, default first and last chars are
   // ' ' (space) and '~', respectively
+  // Any of them may start with options:
+  //   -l or -p for NKK Landscape or Portrait mode
+  //   -s [chars] or -f [file] for a subset, -c for compressed NKK glyphs
+
+  while ((argc > 1) && (argv[1][0] == '-') && argv[1][1] && !argv[1][2]) {
+    switch (argv[1][1]) {
+    case 'l':
+      mode = MODE_NKK_LANDSCAPE;
+      break;
+    case 'p':
+      mode = MODE_NKK_PORTRAIT;
+      break;
+    case 'c':
+      compress = 1;
+      break;
+    case 's':
+    case 'f':
+      if (argc < 3) {
+        argc = 0; // Usage
+        break;
+      }
+      if (argv[1][1] == 's') {
+        for (ptr = argv[2]; *ptr; ptr++)
+          subset[(uint8_t)*ptr] = 1;
+      } else {
+        if (!(fp = fopen(argv[2], "rb"))) {
+          fprintf(stderr, "Can't open %s\n", argv[2]);
+          return 1;
+        }
+        while ((ch = fgetc(fp)) != EOF)
+          subset[ch] = 1;
+        fclose(fp);
+      }
+      isSubset = 1;
+      argv++;
+      argc--;
+      break;
+    default:
+      argc = 0; // Usage
+      break;
+    }
+    if (argc < 2)
+      break;
+    argv++;
+    argc--;
+  }
 
   if (argc < 3) {
-    fprintf(stderr, "Usage: %s fontfile size [first] [last]\n", argv[0]);
+    fprintf(stderr,
+            "Usage: %s [-l|-p] [-c] [-s chars|-f file] fontfile size [first] "
+            "[last]\n",
+            progName);
+    return 1;
+  }
+
+  if (compress && (mode == MODE_GFX)) {
+    fprintf(stderr, "Compression (-c) requires NKK mode (-l or -p)\n");
     return 1;
   }
 
@@ -88,6 +214,17 @@ int main(int argc, char *argv[]) {
     last = i;
   }
 
+  if (isSubset) { // Narrow first and last to the subset
+    while ((first < last) && !subset[first])
+      first++;
+    while ((last > first) && !subset[last])
+      last--;
+    if (!subset[first]) {
+      fprintf(stderr, "No characters of the subset in the font range\n");
+      return 1;
+    }
+  }
+
   ptr = strrchr(argv[1], '/'); // Find last slash in filename
   if (ptr)
     ptr++; // First character of filename (path stripped)
@@ -109,7 +246,10 @@ int main(int argc, char *argv[]) {
     ptr = &fontName[strlen(fontName)]; // If none, append
   // Insert font size and 7/8 bit.  fontName was alloc'd w/extra
   // space to allow this, we're not sprintfing into Forbidden Zone.
-  sprintf(ptr, "%dpt%db", size, (last > 127) ? 8 : 7);
+  sprintf(ptr, "%dpt%db%s", size, (last > 127) ? 8 : 7,
+          (mode == MODE_NKK_LANDSCAPE)  ? "NKKL"
+          : (mode == MODE_NKK_PORTRAIT) ? "NKKP"
+                                        : "");
   // Space and punctuation chars in name replaced w/ underscores.
   for (i = 0; (c = fontName[i]); i++) {
     if (isspace(c) || ispunct(c))
@@ -184,22 +324,64 @@ int main(int argc, char *argv[]) {
     table[j].xOffset = g->left;
     table[j].yOffset = 1 - g->top;
 
-    for (y = 0; y < bitmap->rows; y++) {
-      for (x = 0; x < bitmap->width; x++) {
-        byte = x / 8;
-        bit = 0x80 >> (x & 7);
-        enbit(bitmap->buffer[y * bitmap->pitch + byte] & bit);
+    if (isSubset && !subset[i]) { // Out of the subset - empty glyph
+      table[j].width = 0;
+      table[j].height = 0;
+    } else if ((mode == MODE_NKK_LANDSCAPE) || (mode == MODE_NKK_PORTRAIT)) {
+      // NKK glyph is collected in glyphBytes and written as is or compressed
+      int lineBytes = (mode == MODE_NKK_LANDSCAPE) ? (bitmap->width + 7) / 8
+                                                   : (bitmap->rows + 7) / 8;
+      int numLines =
+          (mode == MODE_NKK_LANDSCAPE) ? bitmap->rows : bitmap->width;
+      glyphLength = lineBytes * numLines;
+      glyphBytes = (uint8_t *)calloc(glyphLength + 1, 1); // +1 - empty glyph
+      packed = (uint8_t *)malloc(glyphLength + glyphLength / 128 + 2);
+      if (!glyphBytes || !packed) {
+        fprintf(stderr, "Malloc error\n");
+        return 1;
       }
-    }
 
-    // Pad end of char bitmap to next byte boundary if needed
-    int n = (bitmap->width * bitmap->rows) & 7;
-    if (n) {     // Pixel count not an even multiple of 8?
-      n = 8 - n; // # bits to next multiple
-      while (n--)
-        enbit(0);
+      for (y = 0; y < bitmap->rows; y++) {
+        for (x = 0; x < bitmap->width; x++) {
+          if (!(bitmap->buffer[y * bitmap->pitch + x / 8] & (0x80 >> (x & 7))))
+            continue;
+          if (mode == MODE_NKK_LANDSCAPE) {
+            // Rows padded to whole bytes, pixel x is bit x & 7 (LSB first)
+            glyphBytes[y * lineBytes + x / 8] |= 1 << (x & 7);
+          } else {
+            // Columns padded to whole bytes, pixel y is bit 7 - (y & 7) (MSB
+            // first)
+            glyphBytes[x * lineBytes + y / 8] |= 0x80 >> (y & 7);
+          }
+        }
+      }
+
+      if (compress) {
+        glyphLength = rowRLE(glyphBytes, lineBytes, numLines, packed);
+      }
+      for (x = 0; x < glyphLength; x++)
+        enbyte(compress ? packed[x] : glyphBytes[x]);
+      bitmapOffset += glyphLength;
+      free(glyphBytes);
+      free(packed);
+    } else {
+      for (y = 0; y < bitmap->rows; y++) {
+        for (x = 0; x < bitmap->width; x++) {
+          byte = x / 8;
+          bit = 0x80 >> (x & 7);
+          enbit(bitmap->buffer[y * bitmap->pitch + byte] & bit);
+        }
+      }
+
+      // Pad end of char bitmap to next byte boundary if needed
+      int n = (bitmap->width * bitmap->rows) & 7;
+      if (n) {     // Pixel count not an even multiple of 8?
+        n = 8 - n; // # bits to next multiple
+        while (n--)
+          enbit(0);
+      }
+      bitmapOffset += (bitmap->width * bitmap->rows + 7) / 8;
     }
-    bitmapOffset += (bitmap->width * bitmap->rows + 7) / 8;
 
     FT_Done_Glyph(glyph);
   }
@@ -207,7 +389,8 @@ int main(int argc, char *argv[]) {
   printf(" };\n\n"); // End bitmap array
 
   // Output glyph attributes table (one per character)
-  printf("const GFXglyph %sGlyphs[] PROGMEM = {\n", fontName);
+  printf("const %s %sGlyphs[] PROGMEM = {\n",
+         (mode == MODE_GFX) ? "GFXglyph" : "NKKglyph", fontName);
   for (i = first, j = 0; i <= last; i++, j++) {
     printf("  { %5d, %3d, %3d, %3d, %4d, %4d }", table[j].bitmapOffset,
            table[j].width, table[j].height, table[j].xAdvance, table[j].xOffset,
@@ -226,16 +409,26 @@ int main(int argc, char *argv[]) {
   printf("\n\n");
 
   // Output font structure
-  printf("const GFXfont %s PROGMEM = {\n", fontName);
+  printf("const %s %s PROGMEM = {\n",
+         (mode == MODE_GFX) ? "GFXfont" : "NKKfont", fontName);
   printf("  (uint8_t  *)%sBitmaps,\n", fontName);
-  printf("  (GFXglyph *)%sGlyphs,\n", fontName);
+  printf("  (%s *)%sGlyphs,\n", (mode == MODE_GFX) ? "GFXglyph" : "NKKglyph",
+         fontName);
   if (face->size->metrics.height == 0) {
     // No face height info, assume fixed width and get from a glyph.
-    printf("  0x%02X, 0x%02X, %d };\n\n", first, last, table[0].height);
+    printf("  0x%02X, 0x%02X, %d", first, last, table[0].height);
   } else {
-    printf("  0x%02X, 0x%02X, %ld };\n\n", first, last,
+    printf("  0x%02X, 0x%02X, %ld", first, last,
            face->size->metrics.height >> 6);
   }
+  if (mode == MODE_GFX) {
+    printf(" };\n\n");
+  } else {
+    printf(", %s, %s };\n\n",
+           (mode == MODE_NKK_LANDSCAPE) ? "NKKfont_Landscape"
+                                        : "NKKfont_Portrait",
+           compress ? "NKKfont_RowRLE" : "NKKfont_Raw");
+  }
   printf("// Approx. %d bytes\n", bitmapOffset + (last - first + 1) * 7 + 7);
   // Size estimate is based on AVR struct and pointer sizes;
   // actual size may vary.
@@ -0,0 +1,122 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*
+NKK Smart Display LCD 64*32 test code using library  NKK_SmartDisplayLCD
+
+ example 06- keys on two SPI buses uploaded concurrently (NKK_MultiBus),
+ using Maple Mini hardware and Arduino STM32 core (https://github.com/rogerclarkmelbourne/Arduino_STM32)
+
+ Uploads different images to 4 NKK devices, 2 on SPI1 and 2 on SPI2:
+   1) one after another (display_NKK() per key)
+   2) both buses at once with NKK_MultiBus
+ and prints aggregate frames per second and the load of each bus to Serial.
+
+
+// hardware setup for Maple Mini
+    // SPI1: Maple Mini SCK  PA5 D6 <--> SCK of NKK devices 1,2
+    //       Maple Mini MOSI PA7 D4 <--> SDI of NKK devices 1,2
+    // SPI2: Maple Mini SCK  PB13 D30 <--> SCK of NKK devices 3,4
+    //       Maple Mini MOSI PB15 D28 <--> SDI of NKK devices 3,4
+    // Maple Mini D3, D2, D31, D26 <--> SS of NKK devices 1..4 (Signal is managed by NKK library)
+
+    //Please note that STM32F103CBT6 is 3.3v and NKK LCD 64x32 SmartDisplay is 5v.  While direct connection without a level shifter works with that example,
+    //such hardware setup is at your own risk.
+*/
+
+#include <SPI.h>
+#include <NKKSmartDisplayLCD.h>
+#include <NKKMultiBus.h>
+
+#define NUM_KEYS 4
+#define NUM_FRAMES 20  //frames per key for each test
+
+SPIClass SPI_1(1);
+SPIClass SPI_2(2);
+
+// Initialise NKK devices, NKK devices take up to 8 MHz
+	NKK_SmartDisplayLCD NKK1(64,32,0,3,8000000,&SPI_1);
+	NKK_SmartDisplayLCD NKK2(64,32,0,2,8000000,&SPI_1);
+	NKK_SmartDisplayLCD NKK3(64,32,0,31,8000000,&SPI_2);
+	NKK_SmartDisplayLCD NKK4(64,32,0,26,8000000,&SPI_2);
+	NKK_SmartDisplayLCD *keys[NUM_KEYS] = {&NKK1, &NKK2, &NKK3, &NKK4};
+
+// Initialise multi-bus dispatch, buses are found from the SPI objects of the keys
+	NKK_MultiBus multiBus(keys, NUM_KEYS);
+
+void setup() {
+
+  //==============================
+   Serial.begin(115200);
+   //The program will wait for serial to be ready up to 10 sec then it will contunue anyway
+     for (int i=1; i<=10; i++){
+          delay(1000);
+     if (Serial){
+         break;
+       }
+     }
+    Serial.println("Setup() started ");
+  //===============================
+
+//start SPI interfaces
+  SPI_1.begin();
+  SPI_2.begin();
+
+// start NKK devices
+  for (uint8_t k=0; k<NUM_KEYS; k++) {
+    keys[k]->begin();
+  }
+  multiBus.begin();
+
+  for (uint8_t b=0; b<multiBus.getNumBuses(); b++) {
+    Serial.print("Bus "); Serial.print(b); Serial.print(": "); Serial.print(multiBus.getBusLoad(b)); Serial.println(" us per frame");
+  }
+
+// different image per key - vertical stripes with a key specific pattern
+  for (uint8_t k=0; k<NUM_KEYS; k++) {
+    for(uint16_t i=0; i<keys[k]->getImageBufferLength(); i++) {
+      keys[k]->imageBufferNKK[i] = 0x11 << k;
+    }
+  }
+}
+
+
+void loop() {
+
+  uint32_t startTime;
+  uint32_t sequentialTime;
+  uint32_t multiBusTime;
+
+//one key after another
+  startTime = micros();
+  for (uint8_t f=0; f<NUM_FRAMES; f++) {
+    for (uint8_t k=0; k<NUM_KEYS; k++) {
+      keys[k]->display_NKK();
+    }
+  }
+  sequentialTime = micros() - startTime;
+
+//all buses at once
+  startTime = micros();
+  for (uint8_t f=0; f<NUM_FRAMES; f++) {
+    multiBus.display_NKK();
+  }
+  multiBusTime = micros() - startTime;
+
+//results, aggregate frames per second i.e. frames uploaded to all keys
+  Serial.print("Sequential: "); Serial.print(sequentialTime / (NUM_FRAMES * NUM_KEYS)); Serial.print(" us per frame, ");
+  Serial.print((float) NUM_FRAMES * NUM_KEYS * 1000000.0 / sequentialTime); Serial.println(" frames/s");
+
+  Serial.print("Multi-bus x"); Serial.print(multiBus.getNumBuses()); Serial.print(multiBus.isInterleaved() ? " (interleaved): " : " (sequential): ");
+  Serial.print(multiBusTime / (NUM_FRAMES * NUM_KEYS)); Serial.print(" us per frame, ");
+  Serial.print((float) NUM_FRAMES * NUM_KEYS * 1000000.0 / multiBusTime); Serial.println(" frames/s");
+
+  delay (5000);
+
+}// End of the Loop
@@ -0,0 +1,149 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*
+NKK Smart Display LCD 64*32 test code using library  NKK_SmartDisplayLCD 
+    
+ example 04- bit-sliced parallel software SPI (NKK_ParallelSPI) vs sequential hardware SPI benchmark
+ Status: the transport and the Slave Select port store are checked on the host (extras/hoststub, make check), not yet measured on a board
+
+ Uploads different images to 4 NKK devices:
+   1) one after another with hardware SPI (display_NKK() per key) 
+   2) at once with NKK_ParallelSPI (4 data pins, shared clock)
+ and prints aggregate frames per second for both transports to Serial. 
+ Then measures the Slave Select overhead of a transaction - setBrightness() (a 2 byte command) with the Slave Select pin 
+ driven by a port register store and by digitalWrite() (setFastCS(false)). display() sends the image, colour and brightness in 
+ one transaction, so the saving per display() is estimated as the difference per command, not measured on display() itself.
+ RAM: the keys are constructed in the single buffer mode (last argument true), 4 * 256 bytes of heap for imageBufferGFX[] fit the 2 KB of a Pro Mini.
+ Images are converted to NKK format while they are sent. begin() of a key returns false if its buffer could not be allocated.
+
+
+// hardware setup for Arduino Pro Mini  
+    // Hardware SPI (sequential):
+    // Arduino SCK  (CLK)  <-->  13  -> SCK of all NKK devices 
+    // Arduino MOSI (SDO)  <-->  11  -> SDI of all NKK devices 
+    // Parallel software SPI: 
+    // Arduino A4 (PORTC4) <-->  SCK of all NKK devices (shared clock)
+    // Arduino A0..A3 (PORTC0..PORTC3) <--> SDI of NKK devices 1..4 (data pins shall be on the same port for the fast path)
+    // Both transports:
+    // Arduino 4,5,6,7     <-->  SS of NKK devices 1..4 (Signal is managed by NKK library)
+    //
+    // Only one transport can be wired at a time, the timing results do not depend on the wiring.
+*/ 
+	
+#include <SPI.h>
+#include <NKKSmartDisplayLCD.h>
+#include <NKKParallelSPI.h>
+
+#define NUM_KEYS 4
+#define NUM_FRAMES 20  //frames per key for each test
+#define NUM_COMMANDS 1000  //commands for the Slave Select test
+
+// Initialise NKK devices
+	NKK_SmartDisplayLCD NKK1(64,32,0,4,8000000,&SPI,true); 
+	NKK_SmartDisplayLCD NKK2(64,32,0,5,8000000,&SPI,true); 
+	NKK_SmartDisplayLCD NKK3(64,32,0,6,8000000,&SPI,true); 
+	NKK_SmartDisplayLCD NKK4(64,32,0,7,8000000,&SPI,true); 
+	NKK_SmartDisplayLCD *keys[NUM_KEYS] = {&NKK1, &NKK2, &NKK3, &NKK4};
+
+// Initialise parallel software SPI
+	const uint8_t dataPins[NUM_KEYS] = {A0, A1, A2, A3};
+	NKK_ParallelSPI parallelSPI(A4, dataPins, NUM_KEYS);
+    
+void setup() {
+
+  //==============================
+   Serial.begin(115200);
+   //The program will wait for serial to be ready up to 10 sec then it will contunue anyway  
+     for (int i=1; i<=10; i++){
+          delay(1000);
+     if (Serial){
+         break;
+       }
+     }
+    Serial.println("Setup() started ");
+  //===============================
+
+//start SPI interface
+  SPI.begin();
+	  
+// start NKK devices
+  for (uint8_t k=0; k<NUM_KEYS; k++) {
+    if (!keys[k]->begin()) {
+      Serial.print("No RAM for the image of key "); Serial.println(k);
+      while (true);
+    }
+  }
+  parallelSPI.begin();
+  
+// different image per key - vertical stripes with a key specific pattern, single buffer mode i.e. converted while it is sent
+  for (uint8_t k=0; k<NUM_KEYS; k++) {
+    for(uint16_t i=0; i<keys[k]->getImageBufferLength(); i++) {
+      keys[k]->imageBufferGFX[i] = 0x11 << k;
+    }
+  }
+}
+
+
+void loop() {
+
+  uint32_t startTime;
+  uint32_t sequentialTime;
+  uint32_t parallelTime;
+  uint32_t fastCSTime;
+  uint32_t digitalWriteCSTime;
+
+//sequential hardware SPI 
+  startTime = micros();
+  for (uint8_t f=0; f<NUM_FRAMES; f++) {
+    for (uint8_t k=0; k<NUM_KEYS; k++) {
+      keys[k]->display_NKK();
+    }
+  }
+  sequentialTime = micros() - startTime;
+
+//parallel software SPI 
+  startTime = micros();
+  for (uint8_t f=0; f<NUM_FRAMES; f++) {
+    parallelSPI.display_NKK(keys);
+  }
+  parallelTime = micros() - startTime;
+
+//Slave Select overhead, port register store vs digitalWrite()
+  startTime = micros();
+  for (uint16_t i=0; i<NUM_COMMANDS; i++) {
+    NKK1.setBrightness(NKK1.bkgBrightnes);
+  }
+  fastCSTime = micros() - startTime;
+
+  NKK1.setFastCS(false);
+  startTime = micros();
+  for (uint16_t i=0; i<NUM_COMMANDS; i++) {
+    NKK1.setBrightness(NKK1.bkgBrightnes);
+  }
+  digitalWriteCSTime = micros() - startTime;
+  NKK1.setFastCS(true);
+
+//results, aggregate frames per second i.e. frames uploaded to all keys 
+  Serial.print("Hardware SPI, sequential: "); Serial.print(sequentialTime / (NUM_FRAMES * NUM_KEYS)); Serial.print(" us per frame, ");
+  Serial.print((float) NUM_FRAMES * NUM_KEYS * 1000000.0 / sequentialTime); Serial.println(" frames/s");
+
+  Serial.print("Software SPI, parallel x"); Serial.print(NUM_KEYS); Serial.print(parallelSPI.isFastIO() ? " (port registers): " : " (digitalWrite): ");
+  Serial.print(parallelTime / (NUM_FRAMES * NUM_KEYS)); Serial.print(" us per frame, ");
+  Serial.print((float) NUM_FRAMES * NUM_KEYS * 1000000.0 / parallelTime); Serial.println(" frames/s");
+
+  Serial.print("Command with Slave Select by digitalWrite(): "); Serial.print((float) digitalWriteCSTime / NUM_COMMANDS); Serial.println(" us");
+  Serial.print("Command with Slave Select by port register"); Serial.print(NKK1.isFastCS() ? ": " : " (not available, digitalWrite() used): ");
+  Serial.print((float) fastCSTime / NUM_COMMANDS); Serial.println(" us");
+  Serial.print("Estimated saving per display() (1 transaction): "); 
+  Serial.print(((float) digitalWriteCSTime - (float) fastCSTime) / NUM_COMMANDS); Serial.println(" us");
+  
+  delay (5000);
+  
+}// End of the Loop
@@ -0,0 +1,81 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*
+NKK Smart Display LCD 64*32 test code using library  NKK_SmartDisplayLCD 
+    
+ example 05- frames streamed from a PC over Serial (NKK_StreamReceiver)
+ Status: checked on the host (extras/nkkstream, make check - the receiver fed by nkksend over a pty), not yet run on a board
+
+ Receives images, colours and brightness for 2 NKK devices (4 on a board with more RAM) from the host sender 
+ (extras/nkkstream/nkksend), e.g. 
+     nkksend -b 115200 -k 1 -c 0xC3 /dev/ttyUSB0 frame1.bin frame2.bin
+ A frame is received while the previous one is uploaded, no frame is copied.
+
+ RAM: a key constructed in the single buffer mode (last argument true) needs 256 bytes for imageBufferGFX, the receiver 256 bytes 
+ per key plus a spare frame, which replace imageBufferNKK of the keys. 
+ 2 keys need 1280 bytes, which leaves room for Serial and the stack in the 2 KB of a Pro Mini (ATmega328P). 
+ 4 keys need 2304 bytes, more than the Pro Mini has - use a board with more RAM e.g. Mega 2560 or an STM32.
+
+
+// hardware setup for Arduino Pro Mini  
+    // Arduino SCK  (CLK)  <-->  13  -> SCK of all NKK devices 
+    // Arduino MOSI (SDO)  <-->  11  -> SDI of all NKK devices 
+    // Arduino 4,5         <-->  SS of NKK devices 1,2 (Signal is managed by NKK library)
+    // Arduino 6,7         <-->  SS of NKK devices 3,4 on a board with more RAM
+    // Arduino RX/TX       <-->  USB serial adapter of the PC
+*/ 
+	
+#include <SPI.h>
+#include <NKKSmartDisplayLCD.h>
+#include <NKKStreamReceiver.h>
+
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
+  #define NUM_KEYS 2 // 2 KB of RAM or less
+#else
+  #define NUM_KEYS 4
+#endif
+
+// Initialise NKK devices
+	NKK_SmartDisplayLCD NKK1(64,32,0,4,8000000,&SPI,true); 
+	NKK_SmartDisplayLCD NKK2(64,32,0,5,8000000,&SPI,true); 
+#if NUM_KEYS == 4
+	NKK_SmartDisplayLCD NKK3(64,32,0,6,8000000,&SPI,true); 
+	NKK_SmartDisplayLCD NKK4(64,32,0,7,8000000,&SPI,true); 
+	NKK_SmartDisplayLCD *keys[NUM_KEYS] = {&NKK1, &NKK2, &NKK3, &NKK4};
+#else
+	NKK_SmartDisplayLCD *keys[NUM_KEYS] = {&NKK1, &NKK2};
+#endif
+
+// Initialise the receiver, key ids are the indices in keys[] (0 is NKK1)
+	NKK_StreamReceiver receiver(&Serial, keys, NUM_KEYS);
+    
+void setup() {
+
+   Serial.begin(115200);
+
+//start SPI interface
+  SPI.begin();
+	  
+// start NKK devices
+  for (uint8_t k=0; k<NUM_KEYS; k++) {
+    if (!keys[k]->begin()) {
+      Serial.println("Not enough memory for the keys");
+    }
+  }
+  
+// attach the keys to the receiver frames, one spare frame is allocated
+  if (!receiver.begin()) {
+    Serial.println("Not enough memory for the frames");
+  }
+}
+
+void loop() {
+  receiver.poll(); //keep it short - the serial receive buffer shall not overflow
+}
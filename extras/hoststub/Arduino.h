@@ -0,0 +1,139 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*********************************************************************
+Host stand-in of the Arduino core for the tests in this folder
+
+Just enough of the Arduino API to build the library with a desktop compiler:
+ - GPIO: 64 pins in 8 ports of 8 pins, pin p is bit p%8 of port p/8 as on AVR.
+   digitalWrite() logs every write in hoststub_pinLog with the number of SPI bytes sent so far.
+ - Port registers: with HOSTSTUB_PORTS defined the port register macros are defined as well,
+   so the library takes its port register paths (Slave Select, NKK_ParallelSPI) and stores to
+   hoststub_port[] directly. digitalWrite() and digitalRead() use the same registers.
+ - millis() and micros() run on hoststub_now (us), delay() moves it on.
+ - HostSerial is a Stream on a file descriptor, e.g. a pty for the frame streaming tests.
+*********************************************************************/
+#ifndef _HostStub_Arduino_H_
+#define _HostStub_Arduino_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <vector>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define MSBFIRST 1
+#define LSBFIRST 0
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define memcpy_P memcpy
+
+#ifndef min
+#define min(a,b) ((a)<(b)?(a):(b))
+#endif
+#ifndef max
+#define max(a,b) ((a)>(b)?(a):(b))
+#endif
+
+#define HOSTSTUB_NumPins 64
+#define HOSTSTUB_NumPorts (HOSTSTUB_NumPins/8)
+
+//Pins as on a Pro Mini, A0..A5 are port C
+#define SS 10
+#define A0 16
+#define A1 17
+#define A2 18
+#define A3 19
+#define A4 20
+#define A5 21
+
+extern volatile uint32_t hoststub_port[HOSTSTUB_NumPorts];
+
+#if defined(HOSTSTUB_PORTS)
+  #define digitalPinToPort(p) ((p)/8)
+  #define digitalPinToBitMask(p) (1u << ((p)%8))
+  #define portOutputRegister(port) (&hoststub_port[port])
+#endif
+
+struct HostStub_PinEvent {
+  uint8_t pin;
+  uint8_t level;
+  size_t spiCount;  //bytes sent by all SPI objects before the write
+};
+extern std::vector<HostStub_PinEvent> hoststub_pinLog;
+extern size_t hoststub_spiCount;
+extern uint32_t hoststub_now;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t value);
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+
+//Levels of all pins as a bit mask, pin p is bit p
+uint64_t hoststub_pins(void);
+
+class Print {
+public:
+  virtual ~Print(void) {}
+  virtual size_t write(uint8_t c) = 0;
+  size_t write(const uint8_t *buffer, size_t size) { size_t n = 0; while (size--) n += write(*buffer++); return n; }
+  size_t print(const char *s) { return write((const uint8_t *) s, strlen(s)); }
+  size_t print(long v) { char b[24]; snprintf(b, sizeof(b), "%ld", v); return print(b); }
+  size_t print(unsigned long v) { char b[24]; snprintf(b, sizeof(b), "%lu", v); return print(b); }
+  size_t print(int v) { return print((long) v); }
+  size_t print(unsigned int v) { return print((unsigned long) v); }
+  size_t print(double v, int digits = 2) { char b[40]; snprintf(b, sizeof(b), "%.*f", digits, v); return print(b); }
+  size_t println(void) { return print("\r\n"); }
+  template <class T> size_t println(T v) { size_t n = print(v); return n + println(); }
+};
+
+class Stream : public Print {
+public:
+  virtual int available(void) = 0;
+  virtual int read(void) = 0;
+  virtual int peek(void) = 0;
+};
+
+//Stream on a file descriptor (stdin, a pty, a pipe), non-blocking reads
+class HostSerial : public Stream {
+public:
+  HostSerial(int fd = -1) : _fd(fd) {}
+  void begin(unsigned long baud) { (void) baud; }
+  void setFd(int fd) { _fd = fd; _count = _pos = 0; }
+  operator bool(void) { return true; }
+  int available(void);
+  int read(void);
+  int peek(void);
+  size_t write(uint8_t c);
+  using Print::write;
+private:
+  void fill(void);
+  int _fd;
+  uint8_t _buffer[256];
+  size_t _count = 0, _pos = 0;
+};
+extern HostSerial Serial;
+
+#endif // _HostStub_Arduino_H_
@@ -0,0 +1,62 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*********************************************************************
+Host stand-in of the Arduino SPI library for the tests in this folder
+
+Every byte sent is recorded with the levels of all pins at the time it is sent, so a test can
+check which Slave Select lines were low during each byte. Transactions are counted.
+*********************************************************************/
+#ifndef _HostStub_SPI_H_
+#define _HostStub_SPI_H_
+
+#include <Arduino.h>
+
+#define SPI_MODE0 0
+#define SPI_MODE1 1
+#define SPI_MODE2 2
+#define SPI_MODE3 3
+
+class SPISettings {
+public:
+  SPISettings(uint32_t clock = 4000000, uint8_t bitOrder = MSBFIRST, uint8_t dataMode = SPI_MODE0)
+    : clock(clock), bitOrder(bitOrder), dataMode(dataMode) {}
+  uint32_t clock;
+  uint8_t bitOrder;
+  uint8_t dataMode;
+};
+
+struct HostStub_SPIByte {
+  uint8_t data;
+  uint64_t pins;    //hoststub_pins() when the byte was sent
+  bool inTransaction;
+};
+
+class SPIClass {
+public:
+  void begin(void) {}
+  void end(void) {}
+  void beginTransaction(SPISettings settings) { current = settings; inTransaction++; numTransactions++; }
+  void endTransaction(void) { if (inTransaction > 0) inTransaction--; }
+  uint8_t transfer(uint8_t data) {
+    out.push_back({data, hoststub_pins(), inTransaction > 0});
+    hoststub_spiCount++;
+    return 0;
+  }
+  void clear(void) { out.clear(); numTransactions = 0; }
+
+  std::vector<HostStub_SPIByte> out;
+  SPISettings current;
+  int inTransaction = 0;
+  int numTransactions = 0;
+};
+extern SPIClass SPI;
+
+#endif // _HostStub_SPI_H_
@@ -0,0 +1,112 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <unistd.h>
+#include <poll.h>
+
+volatile uint32_t hoststub_port[HOSTSTUB_NumPorts];
+std::vector<HostStub_PinEvent> hoststub_pinLog;
+size_t hoststub_spiCount = 0;
+uint32_t hoststub_now = 0;
+
+HostSerial Serial(0);
+SPIClass SPI;
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void) pin;
+  (void) mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+  if (pin >= HOSTSTUB_NumPins) {
+    abort(); //not a pin
+  }
+  if (level == LOW) {
+    hoststub_port[pin/8] &= ~(1u << (pin%8));
+  }
+  else {
+    hoststub_port[pin/8] |= 1u << (pin%8);
+  }
+  hoststub_pinLog.push_back({pin, (uint8_t) (level != LOW), hoststub_spiCount});
+}
+
+int digitalRead(uint8_t pin) {
+  return (hoststub_port[pin/8] >> (pin%8)) & 1;
+}
+
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t value) {
+  for (uint8_t i = 0; i < 8; i++) {
+    digitalWrite(dataPin, (bitOrder == MSBFIRST) ? (value >> (7 - i)) & 1 : (value >> i) & 1);
+    digitalWrite(clockPin, HIGH);
+    digitalWrite(clockPin, LOW);
+  }
+}
+
+uint64_t hoststub_pins(void) {
+  uint64_t pins = 0;
+  for (uint8_t p = 0; p < HOSTSTUB_NumPorts; p++) {
+    pins |= (uint64_t) (hoststub_port[p] & 0xFF) << (8*p);
+  }
+  return pins;
+}
+
+unsigned long millis(void) {
+  return hoststub_now / 1000;
+}
+
+unsigned long micros(void) {
+  return hoststub_now;
+}
+
+void delay(unsigned long ms) {
+  hoststub_now += ms * 1000;
+}
+
+void delayMicroseconds(unsigned int us) {
+  hoststub_now += us;
+}
+
+void yield(void) {
+}
+
+//Reads what the descriptor has without waiting
+void HostSerial::fill(void) {
+  if (_pos < _count || _fd < 0) {
+    return;
+  }
+  struct pollfd p = {_fd, POLLIN, 0};
+  _count = _pos = 0;
+  if (poll(&p, 1, 0) > 0 && (p.revents & POLLIN)) {
+    ssize_t n = ::read(_fd, _buffer, sizeof(_buffer));
+    _count = (n > 0) ? (size_t) n : 0;
+  }
+}
+
+int HostSerial::available(void) {
+  fill();
+  return (int) (_count - _pos);
+}
+
+int HostSerial::read(void) {
+  fill();
+  return (_pos < _count) ? _buffer[_pos++] : -1;
+}
+
+int HostSerial::peek(void) {
+  fill();
+  return (_pos < _count) ? _buffer[_pos] : -1;
+}
+
+size_t HostSerial::write(uint8_t c) {
+  return (_fd >= 0 && ::write(_fd == 0 ? 1 : _fd, &c, 1) == 1) ? 1 : 0;
+}
@@ -0,0 +1,70 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*********************************************************************
+Host test of the image buffers of NKK_SmartDisplayLCD
+
+Both buffers are allocated by the constructor, the single buffer mode is opt-in (constructor
+flag or setSingleBuffer(true)). The copy initialisation form of the examples builds with
+-std=gnu++11 (move constructor) and the buffers move with the object, as they do with the move
+assignment. Attaching the current buffer again keeps it.
+*********************************************************************/
+
+#include <NKKSmartDisplayLCD.h>
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { printf("%s:%d: %s failed\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+int main(void) {
+  //the form used by existing sketches - imageBufferNKK[] is written directly and uploaded
+  NKK_SmartDisplayLCD NKK = NKK_SmartDisplayLCD(64,32,0,4,1000000);
+  CHECK(NKK.begin());
+  CHECK(NKK.imageBufferGFX != NULL && NKK.imageBufferNKK != NULL && !NKK.isSingleBuffer());
+  for (uint16_t i = 0; i < NKK.getImageBufferLength(); i++) {
+    NKK.imageBufferNKK[i] = i;
+  }
+  SPI.clear();
+  NKK.display_NKK();
+  CHECK(SPI.out.size() == (size_t) NKK.getImageBufferLength() + 5);
+  CHECK(SPI.out.size() > 2 && SPI.out[1].data == 0 && SPI.out[2].data == 1);
+
+  //single buffer mode on request only
+  NKK_SmartDisplayLCD single(64,32,0,5,1000000,&SPI,true);
+  CHECK(single.begin());
+  CHECK(single.imageBufferGFX != NULL && single.imageBufferNKK == NULL && single.isSingleBuffer());
+  CHECK(NKK.setSingleBuffer(true) && NKK.isSingleBuffer());
+  CHECK(NKK.begin());
+  CHECK(NKK.setSingleBuffer(false) && NKK.imageBufferNKK != NULL);
+
+  //move construction and assignment take the buffers over, the moved from object keeps none
+  byte *gfx = NKK.imageBufferGFX, *nkk = NKK.imageBufferNKK;
+  NKK.bkgColour = 0x33;
+  NKK_SmartDisplayLCD moved(static_cast<NKK_SmartDisplayLCD &&>(NKK));
+  CHECK(moved.imageBufferGFX == gfx && moved.imageBufferNKK == nkk && moved.bkgColour == 0x33);
+  CHECK(NKK.imageBufferGFX == NULL && NKK.imageBufferNKK == NULL);
+  single = static_cast<NKK_SmartDisplayLCD &&>(moved);
+  CHECK(single.imageBufferGFX == gfx && single.imageBufferNKK == nkk && single.getImageBufferLength() == 256);
+  CHECK(moved.imageBufferGFX == NULL && moved.imageBufferNKK == NULL);
+  SPI.clear();
+  single.display_NKK();
+  CHECK(SPI.out.size() == 256 + 5 && ((SPI.out[0].pins >> 4) & 1) == 0);
+
+  //attaching the current buffer again keeps it, the own buffer is not freed
+  gfx = single.imageBufferGFX;
+  nkk = single.imageBufferNKK;
+  single.imageBufferNKK[1] = 0x5A;
+  CHECK(single.attachImageBufferGFX(single.imageBufferGFX, 256) && single.imageBufferGFX == gfx);
+  CHECK(single.attachImageBufferNKK(single.imageBufferNKK, 256) && single.imageBufferNKK == nkk);
+  CHECK(single.imageBufferNKK[1] == 0x5A);
+  single.clearImageBufferNKK();
+
+  printf("test_buffers: %s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
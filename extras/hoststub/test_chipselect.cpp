@@ -0,0 +1,216 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*********************************************************************
+Host test of NKK_ChipSelectMCP23S17 on the SPI bus of the keys
+
+Replays the SPI bytes through a model of two MCP23S17 expanders (transfers framed by their CS
+pin) and splits the bytes every key receives into sessions, from its line going low to going
+high. A session shall start with the NKK command of the key, with no expander byte before it,
+and expander bytes may follow the command only at the end (the bytes which deselect the key).
+Checked for display(), broadcasts over keys of several ports and rotations, and sendCommands(),
+and the order of the writes of one update() which deselects a line and selects another one.
+*********************************************************************/
+
+#include <NKKSmartDisplayLCD.h>
+#include <NKKChipSelect.h>
+
+#define NUM_KEYS 32
+#define EXPANDER_CS 9
+#define NUM_CHIPS 2
+#define EXPANDER_BYTE 0x100 //marks a byte of an expander transfer in a session
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { printf("%s:%d: %s failed\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+static size_t spiBase = 0; //hoststub_spiCount when SPI.out was cleared
+
+static void clearLog(void) {
+  SPI.clear();
+  hoststub_pinLog.clear();
+  spiBase = hoststub_spiCount;
+}
+
+//Sessions of every key since clearLog(), NKK bytes and EXPANDER_BYTE markers
+static void replay(std::vector<std::vector<uint16_t> > sessions[]) {
+  byte latches[NUM_CHIPS][2] = {{0xFF, 0xFF}, {0xFF, 0xFF}};
+  std::vector<bool> isStart(SPI.out.size() + 1, false);
+  uint8_t position = 0, chip = 0, reg = 0;
+
+  //bytes which start an expander transfer, from the falling edges of its CS pin
+  for (const HostStub_PinEvent &e : hoststub_pinLog) {
+    if (e.pin == EXPANDER_CS && e.level == LOW && e.spiCount - spiBase < isStart.size()) {
+      isStart[e.spiCount - spiBase] = true;
+    }
+  }
+  for (size_t n = 0; n < SPI.out.size(); n++) {
+    bool isExpander = ((SPI.out[n].pins >> EXPANDER_CS) & 1) == 0;
+    bool wasSelected[NUM_KEYS];
+    for (uint8_t k = 0; k < NUM_KEYS; k++) {
+      wasSelected[k] = ((latches[k/16][(k/8) % 2] >> (k % 8)) & 1) == 0;
+      if (wasSelected[k]) {
+        sessions[k].back().push_back(isExpander ? EXPANDER_BYTE : SPI.out[n].data);
+      }
+    }
+    if (!isExpander) {
+      continue;
+    }
+    if (isStart[n]) {
+      position = 0;
+    }
+    byte data = SPI.out[n].data;
+    if (position == 0) {
+      chip = ((data >> 1) & 0x07) - 1;
+    }
+    else if (position == 1) {
+      reg = data;
+    }
+    else {
+      if (chip < NUM_CHIPS && (reg == 0x14 || reg == 0x15)) {
+        latches[chip][reg - 0x14] = data;
+      }
+      reg++;
+    }
+    position++;
+    for (uint8_t k = 0; k < NUM_KEYS; k++) {
+      bool isSelected = ((latches[k/16][(k/8) % 2] >> (k % 8)) & 1) == 0;
+      if (isSelected && !wasSelected[k]) {
+        sessions[k].push_back(std::vector<uint16_t>());
+      }
+    }
+  }
+}
+
+//Every session of a key starts with an NKK byte and has no NKK byte after an expander byte. Returns the number of sessions
+static size_t checkSessions(const std::vector<std::vector<uint16_t> > &sessions, byte firstByte) {
+  for (const std::vector<uint16_t> &s : sessions) {
+    CHECK(!s.empty() && s[0] == firstByte);
+    bool isExpanderSeen = false;
+    for (uint16_t b : s) {
+      CHECK(!(isExpanderSeen && b != EXPANDER_BYTE));
+      isExpanderSeen = isExpanderSeen || b == EXPANDER_BYTE;
+    }
+  }
+  return sessions.size();
+}
+
+//Number of NKK bytes in a session
+static size_t nkkLength(const std::vector<uint16_t> &session) {
+  size_t n = 0;
+  while (n < session.size() && session[n] != EXPANDER_BYTE) {
+    n++;
+  }
+  return n;
+}
+
+int main(void) {
+  NKK_ChipSelectMCP23S17 expanders(EXPANDER_CS, NUM_CHIPS);
+  NKK_SmartDisplayLCD *keys[NUM_KEYS];
+  std::vector<std::vector<uint16_t> > sessions[NUM_KEYS];
+
+  expanders.begin();
+  for (uint8_t k = 0; k < NUM_KEYS; k++) {
+    keys[k] = new NKK_SmartDisplayLCD(64, 32, k % 3 == 0);
+    keys[k]->setChipSelect(&expanders, k);
+    CHECK(keys[k]->begin());
+  }
+  CHECK(expanders.getGroup(7) == 0 && expanders.getGroup(8) == 1 && expanders.getGroup(31) == 3);
+
+  //one key after another - one session per key, the whole frame before any expander byte
+  clearLog();
+  for (uint8_t k = 0; k < NUM_KEYS; k += 5) {
+    keys[k]->display();
+  }
+  replay(sessions);
+  for (uint8_t k = 0; k < NUM_KEYS; k++) {
+    CHECK(checkSessions(sessions[k], NKK_SmartDisplayLCD_Img_Upload) == (k % 5 == 0 ? 1u : 0u));
+    if (k % 5 == 0) {
+      CHECK(nkkLength(sessions[k][0]) == (size_t) keys[k]->getImageBufferLength() + 5);
+    }
+    sessions[k].clear();
+  }
+
+  //a broadcast to keys on all four ports - a transfer per port
+  NKK_SmartDisplayLCD *group[] = {keys[0], keys[3], keys[7], keys[8], keys[12], keys[17], keys[23], keys[24], keys[31]};
+  uint8_t numGroup = sizeof(group) / sizeof(group[0]);
+  clearLog();
+  CHECK(keys[0]->broadcastColourNKK(group, numGroup, 0xC0) == numGroup);
+  replay(sessions);
+  size_t numCommands = 0;
+  for (const HostStub_SPIByte &b : SPI.out) {
+    numCommands += (((b.pins >> EXPANDER_CS) & 1) != 0 && b.data == NKK_SmartDisplayLCD_Set_RGB);
+  }
+  CHECK(numCommands == 4);
+  for (uint8_t i = 0; i < numGroup; i++) {
+    NKK_SmartDisplayLCD *key = group[i];
+    uint8_t k = 0;
+    while (keys[k] != key) {
+      k++;
+    }
+    CHECK(checkSessions(sessions[k], NKK_SmartDisplayLCD_Set_RGB) == 1);
+    CHECK(nkkLength(sessions[k][0]) == 2);
+    CHECK(key->bkgColour == (0xC0 | 0x03));
+  }
+  for (uint8_t k = 0; k < NUM_KEYS; k++) {
+    sessions[k].clear();
+  }
+
+  //an image broadcast - a transfer per port and rotation setting
+  clearLog();
+  CHECK(keys[1]->broadcast(group, numGroup) == numGroup);
+  replay(sessions);
+  for (uint8_t i = 0; i < numGroup; i++) {
+    uint8_t k = 0;
+    while (keys[k] != group[i]) {
+      k++;
+    }
+    CHECK(checkSessions(sessions[k], NKK_SmartDisplayLCD_Img_Upload) == 1);
+    CHECK(nkkLength(sessions[k][0]) == (size_t) keys[k]->getImageBufferLength() + 5);
+  }
+  for (uint8_t k = 0; k < NUM_KEYS; k++) {
+    sessions[k].clear();
+  }
+
+  //Slave Select moves from key to key inside one transaction
+  NKK_Command commands[] = {{keys[2], NKK_SmartDisplayLCD_Set_RGB, 0x30}, {keys[18], NKK_SmartDisplayLCD_Set_RGB, 0x0C},
+                            {keys[9], NKK_SmartDisplayLCD_Set_RGB, 0xC0}, {keys[10], NKK_SmartDisplayLCD_Set_RGB, 0x3C}};
+  clearLog();
+  CHECK(keys[2]->sendCommands(commands, 4) == 4);
+  replay(sessions);
+  for (uint8_t i = 0; i < 4; i++) {
+    uint8_t k = 0;
+    while (keys[k] != commands[i].key) {
+      k++;
+    }
+    CHECK(checkSessions(sessions[k], NKK_SmartDisplayLCD_Set_RGB) == 1);
+    CHECK(nkkLength(sessions[k][0]) == 2 && sessions[k][0][1] == (commands[i].data | 0x03));
+  }
+
+  //one update which moves the selection from chip 2 to chip 1 - the line going high is written first
+  expanders.write(18, LOW);
+  expanders.update();
+  clearLog();
+  expanders.write(18, HIGH);
+  expanders.write(9, LOW);
+  expanders.update();
+  CHECK(SPI.out.size() == 6);
+  if (SPI.out.size() == 6) {
+    CHECK(SPI.out[0].data == 0x44 && SPI.out[1].data == 0x14 && SPI.out[2].data == 0xFF);
+    CHECK(SPI.out[3].data == 0x42 && SPI.out[4].data == 0x15 && SPI.out[5].data == (byte) ~0x02);
+  }
+  expanders.write(9, HIGH);
+  expanders.update();
+
+  for (uint8_t k = 0; k < NUM_KEYS; k++) {
+    delete keys[k];
+  }
+  printf("test_chipselect: %s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,148 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*********************************************************************
+Host test of Slave Select cycled between the commands of an upload (setCSPerCommand())
+
+By default an upload is one Slave Select session. With setCSPerCommand(true) Slave Select shall
+go high and low again right before Set RGB and Set Brightness, for display() of the key, for a
+broadcast to a group the key is in, for sendCommands() and for NKK_ParallelSPI. The bytes are the
+same either way.
+*********************************************************************/
+
+#include <NKKParallelSPI.h>
+
+#define NUM_KEYS 2
+#define CLK_PIN 8
+#define IMAGE_LENGTH 256
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { printf("%s:%d: %s failed\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+static const uint8_t csPins[NUM_KEYS] = {4, 5};
+static const uint8_t dataPins[NUM_KEYS] = {10, 11};
+
+//Writes of a Slave Select pin since the log was cleared, as byte count (hardware SPI bytes or bit-sliced clock edges / 8)
+//and level, 2 numbers per write
+static std::vector<size_t> sessions(uint8_t pin, size_t base, bool isParallel) {
+  std::vector<size_t> writes;
+  size_t edges = 0;
+  uint8_t clk = HIGH;
+  for (const HostStub_PinEvent &e : hoststub_pinLog) {
+    if (e.pin == CLK_PIN) {
+      edges += (clk == HIGH && e.level == LOW);
+      clk = e.level;
+    }
+    if (e.pin == pin) {
+      writes.push_back(isParallel ? edges / 8 : e.spiCount - base);
+      writes.push_back(e.level);
+    }
+  }
+  return writes;
+}
+
+//Slave Select of an upload - one session, or a session for the image, Set RGB and Set Brightness
+static std::vector<size_t> expected(bool isPerCommand) {
+  if (isPerCommand) {
+    return {0, LOW, IMAGE_LENGTH + 1, HIGH, IMAGE_LENGTH + 1, LOW, IMAGE_LENGTH + 3, HIGH, IMAGE_LENGTH + 3, LOW, IMAGE_LENGTH + 5, HIGH};
+  }
+  return {0, LOW, IMAGE_LENGTH + 5, HIGH};
+}
+
+static std::vector<uint8_t> sent(void) {
+  std::vector<uint8_t> bytes;
+  for (const HostStub_SPIByte &b : SPI.out) {
+    bytes.push_back(b.data);
+  }
+  return bytes;
+}
+
+//display() of key 0 and a broadcast to both keys over hardware SPI, key 1 asks for a session per command
+static void testHardwareSPI(NKK_SmartDisplayLCD *keys[]) {
+  std::vector<uint8_t> bytes[2];
+
+  for (uint8_t perCommand = 0; perCommand <= 1; perCommand++) {
+    keys[0]->setCSPerCommand(perCommand);
+    keys[1]->setCSPerCommand(false);
+    SPI.clear();
+    hoststub_pinLog.clear();
+    size_t base = hoststub_spiCount;
+    keys[0]->display();
+    CHECK(sessions(csPins[0], base, false) == expected(perCommand));
+    CHECK(sessions(csPins[1], base, false).empty());
+    if (perCommand) {
+      CHECK(sent() == bytes[0]);
+    }
+    bytes[0] = sent();
+
+    //the group is cycled if any key of it asks for it
+    keys[0]->setCSPerCommand(false);
+    keys[1]->setCSPerCommand(perCommand);
+    SPI.clear();
+    hoststub_pinLog.clear();
+    base = hoststub_spiCount;
+    CHECK(keys[0]->broadcast(keys, NUM_KEYS) == NUM_KEYS);
+    CHECK(sessions(csPins[0], base, false) == expected(perCommand));
+    CHECK(sessions(csPins[1], base, false) == expected(perCommand));
+    if (perCommand) {
+      CHECK(sent() == bytes[1]);
+    }
+    bytes[1] = sent();
+  }
+
+  //two commands for key 1 - one session, or a session each
+  NKK_Command commands[] = {{keys[1], NKK_SmartDisplayLCD_Set_RGB, 0x30}, {keys[1], NKK_SmartDisplayLCD_Set_Bright, 0x40}};
+  SPI.clear();
+  hoststub_pinLog.clear();
+  size_t base = hoststub_spiCount;
+  CHECK(keys[0]->sendCommands(commands, 2) == 2);
+  CHECK(sessions(csPins[1], base, false) == std::vector<size_t>({0, LOW, 2, HIGH, 2, LOW, 4, HIGH}));
+  keys[1]->setCSPerCommand(false);
+  hoststub_pinLog.clear();
+  base = hoststub_spiCount;
+  CHECK(keys[0]->sendCommands(commands, 2) == 2);
+  CHECK(sessions(csPins[1], base, false) == std::vector<size_t>({0, LOW, 4, HIGH}));
+}
+
+//display_NKK() of NKK_ParallelSPI, key 1 asks for a session per command, all keys are cycled
+static void testParallelSPI(NKK_SmartDisplayLCD *keys[]) {
+  NKK_ParallelSPI parallelSPI(CLK_PIN, dataPins, NUM_KEYS);
+  parallelSPI.begin();
+
+  for (uint8_t perCommand = 0; perCommand <= 1; perCommand++) {
+    keys[0]->setCSPerCommand(false);
+    keys[1]->setCSPerCommand(perCommand);
+    hoststub_pinLog.clear();
+    CHECK(parallelSPI.display_NKK(keys));
+    CHECK(sessions(csPins[0], 0, true) == expected(perCommand));
+    CHECK(sessions(csPins[1], 0, true) == expected(perCommand));
+  }
+}
+
+int main(void) {
+  NKK_SmartDisplayLCD NKK1(64,32,0,csPins[0]), NKK2(64,32,0,csPins[1]);
+  NKK_SmartDisplayLCD *keys[NUM_KEYS] = {&NKK1, &NKK2};
+
+  for (uint8_t k = 0; k < NUM_KEYS; k++) {
+    CHECK(keys[k]->begin());
+    CHECK(!keys[k]->isCSPerCommand());
+    keys[k]->setFastCS(false); //the GPIO log sees digitalWrite() only
+    for (uint16_t i = 0; i < keys[k]->getImageBufferLength(); i++) {
+      keys[k]->imageBufferGFX[i] = rand();
+    }
+  }
+  CHECK(NKK1.getImageBufferLength() == IMAGE_LENGTH);
+
+  testHardwareSPI(keys);
+  testParallelSPI(keys);
+
+  printf("test_cspercommand: %s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,135 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*********************************************************************
+Host test of the Slave Select pin driven by port register stores (setFastCS())
+
+Built with HOSTSTUB_PORTS the Slave Select of the keys shall be toggled by stores to the port
+register, which the GPIO log does not see, and shall be low on every SPI byte of display(), a
+broadcast and sendCommands() and high after them. The other pins of the port keep their levels
+and the bytes are the same as with digitalWrite() (setFastCS(false)), which the log does see.
+Built without it isFastCS() shall be false and digitalWrite() is used.
+*********************************************************************/
+
+#include <NKKSmartDisplayLCD.h>
+
+#define NUM_KEYS 2
+#define OTHER_HIGH 3 //pins of the Slave Select port not used by the keys
+#define OTHER_LOW 6
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { printf("%s:%d: %s failed\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+static const uint8_t csPins[NUM_KEYS] = {4, 5};
+
+//Writes of a pin in the GPIO log
+static size_t numWrites(uint8_t pin) {
+  size_t n = 0;
+  for (const HostStub_PinEvent &e : hoststub_pinLog) {
+    n += (e.pin == pin);
+  }
+  return n;
+}
+
+//Bytes since SPI.clear(), Slave Select of the selected keys low on every byte, all of them high at the end
+static std::vector<uint8_t> check(const bool isSelected[], bool isFast) {
+  std::vector<uint8_t> bytes;
+  bool isLevels = true;
+  for (const HostStub_SPIByte &b : SPI.out) {
+    for (uint8_t k = 0; k < NUM_KEYS; k++) {
+      isLevels = isLevels && (((b.pins >> csPins[k]) & 1) == 0) == isSelected[k];
+    }
+    isLevels = isLevels && ((b.pins >> OTHER_HIGH) & 1) == 1 && ((b.pins >> OTHER_LOW) & 1) == 0;
+    bytes.push_back(b.data);
+  }
+  CHECK(!SPI.out.empty());
+  CHECK(isLevels);
+  for (uint8_t k = 0; k < NUM_KEYS; k++) {
+    CHECK(digitalRead(csPins[k]) == HIGH);
+    CHECK((numWrites(csPins[k]) == 0) == (isFast || !isSelected[k]));
+  }
+  CHECK(digitalRead(OTHER_HIGH) == HIGH && digitalRead(OTHER_LOW) == LOW);
+  return bytes;
+}
+
+//display() of key 0, a broadcast to both keys and sendCommands() to both keys
+static void run(NKK_SmartDisplayLCD *keys[], bool isFast, std::vector<uint8_t> bytes[]) {
+  const bool first[NUM_KEYS] = {true, false};
+  const bool both[NUM_KEYS] = {true, true};
+  NKK_Command commands[] = {{keys[0], NKK_SmartDisplayLCD_Set_RGB, 0x30}, {keys[1], NKK_SmartDisplayLCD_Set_Bright, 0x40}};
+
+  //the same colour and brightness on every run, display() sends them
+  for (uint8_t k = 0; k < NUM_KEYS; k++) {
+    keys[k]->bkgColour = 0x0F;
+    keys[k]->bkgBrightnes = 0x7F;
+  }
+  SPI.clear();
+  hoststub_pinLog.clear();
+  keys[0]->display();
+  bytes[0] = check(first, isFast);
+
+  SPI.clear();
+  hoststub_pinLog.clear();
+  CHECK(keys[0]->broadcastColourNKK(keys, NUM_KEYS, 0xC0) == NUM_KEYS);
+  bytes[1] = check(both, isFast);
+
+  //Slave Select moves from key to key, each command goes to its key only
+  SPI.clear();
+  hoststub_pinLog.clear();
+  CHECK(keys[0]->sendCommands(commands, 2) == 2);
+  bool isMoved = SPI.out.size() == 4;
+  for (size_t n = 0; isMoved && n < SPI.out.size(); n++) {
+    uint8_t k = n / 2;
+    isMoved = ((SPI.out[n].pins >> csPins[k]) & 1) == 0 && ((SPI.out[n].pins >> csPins[1 - k]) & 1) == 1;
+    bytes[2].push_back(SPI.out[n].data);
+  }
+  CHECK(isMoved);
+  CHECK(digitalRead(csPins[0]) == HIGH && digitalRead(csPins[1]) == HIGH);
+}
+
+int main(void) {
+  NKK_SmartDisplayLCD NKK1(64,32,0,csPins[0]), NKK2(64,32,1,csPins[1]);
+  NKK_SmartDisplayLCD *keys[NUM_KEYS] = {&NKK1, &NKK2};
+  std::vector<uint8_t> fast[3], slow[3];
+
+  digitalWrite(OTHER_HIGH, HIGH);
+  digitalWrite(OTHER_LOW, LOW);
+  CHECK(!NKK1.isFastCS()); //resolved in begin()
+  for (uint8_t k = 0; k < NUM_KEYS; k++) {
+    CHECK(keys[k]->begin());
+    for (uint16_t i = 0; i < keys[k]->getImageBufferLength(); i++) {
+      keys[k]->imageBufferGFX[i] = rand();
+    }
+  }
+
+#if defined(HOSTSTUB_PORTS)
+  CHECK(NKK1.setFastCS(true));
+  CHECK(NKK1.isFastCS() && NKK2.isFastCS());
+  run(keys, true, fast);
+#else
+  CHECK(!NKK1.setFastCS(true));
+  CHECK(!NKK1.isFastCS() && !NKK2.isFastCS());
+#endif
+
+  //digitalWrite() path, the same bytes
+  for (uint8_t k = 0; k < NUM_KEYS; k++) {
+    keys[k]->setFastCS(false);
+    CHECK(!keys[k]->isFastCS());
+  }
+  run(keys, false, slow);
+#if defined(HOSTSTUB_PORTS)
+  for (uint8_t i = 0; i < 3; i++) {
+    CHECK(fast[i] == slow[i]);
+  }
+#endif
+
+  printf("test_fastcs: %s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
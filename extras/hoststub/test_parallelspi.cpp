@@ -0,0 +1,143 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*********************************************************************
+Host test of NKK_ParallelSPI (bit-sliced software SPI)
+
+Decodes the data pins of every key on the falling edges of the shared clock from the GPIO log
+and compares the bytes with what display() of the key sends over hardware SPI. Slave Select of
+every key shall be low on every edge and high at the end.
+Built with HOSTSTUB_PORTS the data pins are stored by port registers when they share a port,
+which the log does not see; the test then checks the port path is taken and that the other pins
+of the data and clock ports keep their levels, and decodes the keys with data pins on two ports.
+Keys of different image sizes shall be refused with nothing sent.
+*********************************************************************/
+
+#include <NKKSmartDisplayLCD.h>
+#include <NKKParallelSPI.h>
+
+#define NUM_KEYS 4
+#define CLK_PIN A4
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { printf("%s:%d: %s failed\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+//Bytes of each key clocked out since the log was cleared, bit 7 first
+static void decode(const uint8_t dataPins[], const uint8_t csPins[], std::vector<uint8_t> bytes[]) {
+  uint8_t level[HOSTSTUB_NumPins];
+  uint8_t shift[NUM_KEYS] = {0};
+  uint8_t numBits = 0;
+  bool isSelected = true;
+
+  for (uint8_t p = 0; p < HOSTSTUB_NumPins; p++) {
+    level[p] = HIGH; //clock and Slave Select idle high, data pins are set before the first edge
+  }
+  for (const HostStub_PinEvent &e : hoststub_pinLog) {
+    bool isFalling = (e.pin == CLK_PIN && level[e.pin] == HIGH && e.level == LOW);
+    level[e.pin] = e.level;
+    if (!isFalling) {
+      continue;
+    }
+    for (uint8_t k = 0; k < NUM_KEYS; k++) {
+      shift[k] = (shift[k] << 1) | level[dataPins[k]];
+      isSelected = isSelected && level[csPins[k]] == LOW;
+    }
+    if (++numBits == 8) {
+      for (uint8_t k = 0; k < NUM_KEYS; k++) {
+        bytes[k].push_back(shift[k]);
+      }
+      numBits = 0;
+    }
+  }
+  CHECK(numBits == 0);
+  CHECK(isSelected || hoststub_pinLog.empty());
+}
+
+//What display() of the key sends over hardware SPI
+static std::vector<uint8_t> reference(NKK_SmartDisplayLCD *key) {
+  std::vector<uint8_t> bytes;
+  SPI.clear();
+  key->display();
+  for (const HostStub_SPIByte &b : SPI.out) {
+    bytes.push_back(b.data);
+  }
+  return bytes;
+}
+
+static void testKeys(const uint8_t dataPins[], bool isFastIOExpected) {
+  NKK_SmartDisplayLCD NKK1(64,32,0,4), NKK2(64,32,1,5), NKK3(64,32,0,6), NKK4(32,64,0,7);
+  NKK_SmartDisplayLCD *keys[NUM_KEYS] = {&NKK1, &NKK2, &NKK3, &NKK4};
+  NKK_ParallelSPI parallelSPI(CLK_PIN, dataPins, NUM_KEYS);
+  const uint8_t csPins[NUM_KEYS] = {4, 5, 6, 7};
+
+  for (uint8_t k = 0; k < NUM_KEYS; k++) {
+    CHECK(keys[k]->begin());
+    keys[k]->setFastCS(false); //Slave Select by digitalWrite() so the log has it
+    for (uint16_t i = 0; i < keys[k]->getImageBufferLength(); i++) {
+      keys[k]->imageBufferGFX[i] = rand();
+    }
+    keys[k]->bkgColour = rand();
+    keys[k]->bkgBrightnes = rand();
+  }
+  for (uint8_t k = 0; k < NUM_KEYS; k++) {
+    CHECK(keys[k]->setSingleBuffer(keys[k] != &NKK2)); //one key from imageBufferNKK, the others converted on the fly
+  }
+  parallelSPI.begin();
+  CHECK(parallelSPI.isFastIO() == isFastIOExpected);
+
+  //a pin of the clock port which is not used by the transport keeps its level
+  digitalWrite(A5, HIGH);
+  hoststub_pinLog.clear();
+  CHECK(parallelSPI.display(keys));
+  CHECK(digitalRead(A5) == HIGH);
+  CHECK(digitalRead(CLK_PIN) == HIGH);
+  for (uint8_t k = 0; k < NUM_KEYS; k++) {
+    CHECK(digitalRead(csPins[k]) == HIGH);
+  }
+  if (isFastIOExpected) {
+    return;
+  }
+
+  std::vector<uint8_t> bytes[NUM_KEYS];
+  decode(dataPins, csPins, bytes);
+  for (uint8_t k = 0; k < NUM_KEYS; k++) {
+    CHECK(bytes[k] == reference(keys[k]));
+  }
+}
+
+//Keys of different image sizes are refused, nothing is sent
+static void testSizes(const uint8_t dataPins[]) {
+  NKK_SmartDisplayLCD NKK1(64,32,0,4), NKK2(32,32,0,5);
+  NKK_SmartDisplayLCD *keys[2] = {&NKK1, &NKK2};
+  NKK_ParallelSPI parallelSPI(CLK_PIN, dataPins, 2);
+
+  CHECK(NKK1.begin() && NKK2.begin());
+  parallelSPI.begin();
+  hoststub_pinLog.clear();
+  CHECK(!parallelSPI.display(keys));
+  CHECK(!parallelSPI.display_NKK(keys));
+  CHECK(hoststub_pinLog.empty());
+}
+
+int main(void) {
+  const uint8_t samePort[NUM_KEYS] = {A0, A1, A2, A3};
+  const uint8_t twoPorts[NUM_KEYS] = {A0, A1, 8, 9};
+
+#if defined(HOSTSTUB_PORTS)
+  testKeys(samePort, true);
+#else
+  testKeys(samePort, false);
+#endif
+  testKeys(twoPorts, false);
+  testSizes(twoPorts);
+
+  printf("test_parallelspi: %s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
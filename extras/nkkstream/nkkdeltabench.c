@@ -0,0 +1,170 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*********************************************************************
+Delta encoding benchmark for the frame streaming protocol (nkkstream.h)
+
+Renders typical 64x32 key traces in NKK native format (Landscape) and reports per trace:
+ - the average link bytes per frame with deltas (nkksend -x) and the ratio to full images,
+ - encode (host) and decode (in place, including the base frame check) time per frame.
+
+  nkkdeltabench [frames]
+
+Traces:
+  counter   a label and a 4 digit counter incremented every frame
+  labels    a label cycling through ON, OFF, AUTO and MANUAL
+  progress  a progress bar growing one pixel per frame and its percentage
+  random    random images, the worst case (sent as full images)
+Decode times are measured on the host, scale them by the clock of the board.
+*********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "nkkstream.h"
+
+#define W 64
+#define H 32
+#define FRAME_LENGTH (W * H / 8)
+#define FULL_PACKET (NKKstream_HeaderLength + FRAME_LENGTH + NKKstream_CRCLength)
+
+//5x7 glyphs, a byte per column, bit 0 is the top row (as the classic Adafruit_GFX font)
+static const char glyphChars[] = "0123456789%ONFAUTMLRP";
+static const uint8_t glyphs[][5] = {
+  {0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00}, {0x72,0x49,0x49,0x49,0x46}, {0x21,0x41,0x49,0x4D,0x33},
+  {0x18,0x14,0x12,0x7F,0x10}, {0x27,0x45,0x45,0x45,0x39}, {0x3C,0x4A,0x49,0x49,0x31}, {0x41,0x21,0x11,0x09,0x07},
+  {0x36,0x49,0x49,0x49,0x36}, {0x46,0x49,0x49,0x29,0x1E}, {0x23,0x13,0x08,0x64,0x62}, {0x3E,0x41,0x41,0x41,0x3E},
+  {0x7F,0x04,0x08,0x10,0x7F}, {0x7F,0x09,0x09,0x09,0x01}, {0x7C,0x12,0x11,0x12,0x7C}, {0x3F,0x40,0x40,0x40,0x3F},
+  {0x03,0x01,0x7F,0x01,0x03}, {0x7F,0x02,0x1C,0x02,0x7F}, {0x7F,0x40,0x40,0x40,0x40}, {0x7F,0x09,0x19,0x29,0x46},
+  {0x7F,0x09,0x09,0x09,0x06}
+};
+
+//Landscape NKK native format - a row is a big endian number, pixel x is bit x%8 of byte W/8-1-x/8
+static void setPixel(uint8_t *frame, int x, int y) {
+  if (x >= 0 && x < W && y >= 0 && y < H) {
+    frame[y * (W / 8) + (W / 8 - 1 - x / 8)] |= (uint8_t) (1 << (x % 8));
+  }
+}
+
+static void drawText(uint8_t *frame, int x, int y, const char *text, int size) {
+  for (; *text; text++, x += 6 * size) {
+    const char *c = strchr(glyphChars, *text);
+    if (c == NULL) {
+      continue;
+    }
+    const uint8_t *g = glyphs[c - glyphChars];
+    for (int col = 0; col < 5; col++) {
+      for (int row = 0; row < 7; row++) {
+        if (g[col] & (1 << row)) {
+          for (int i = 0; i < size * size; i++) {
+            setPixel(frame, x + col * size + i % size, y + row * size + i / size);
+          }
+        }
+      }
+    }
+  }
+}
+
+static void drawFrame(uint8_t *frame) {
+  for (int x = 0; x < W; x++) {setPixel(frame, x, 0); setPixel(frame, x, H - 1);}
+  for (int y = 0; y < H; y++) {setPixel(frame, 0, y); setPixel(frame, W - 1, y);}
+}
+
+static void renderCounter(uint8_t *frame, long n) {
+  char text[8];
+  memset(frame, 0, FRAME_LENGTH);
+  drawFrame(frame);
+  drawText(frame, 3, 3, "RPM", 1);
+  snprintf(text, sizeof(text), "%04ld", n % 10000);
+  drawText(frame, 9, 14, text, 2);
+}
+
+static void renderLabels(uint8_t *frame, long n) {
+  static const char *labels[] = {"ON", "OFF", "AUTO", "MANUAL"};
+  const char *label = labels[n % 4];
+  int size = (strlen(label) > 4) ? 1 : 2;
+  int w = (int) strlen(label) * 6 * size - size;
+  memset(frame, 0, FRAME_LENGTH);
+  drawFrame(frame);
+  drawText(frame, (W - w) / 2, (H - 7 * size) / 2, label, size);
+}
+
+static void renderProgress(uint8_t *frame, long n) {
+  char text[8];
+  int p = (int) (n % 61);
+  memset(frame, 0, FRAME_LENGTH);
+  for (int x = 2; x < 2 + p; x++) {
+    for (int y = 20; y < 28; y++) {setPixel(frame, x, y);}
+  }
+  for (int x = 1; x < 63; x++) {setPixel(frame, x, 19); setPixel(frame, x, 28);}
+  snprintf(text, sizeof(text), "%d%%", p * 100 / 60);
+  drawText(frame, 4, 4, text, 1);
+}
+
+static void renderRandom(uint8_t *frame, long n) {
+  (void) n;
+  for (int i = 0; i < FRAME_LENGTH; i++) {frame[i] = (uint8_t) rand();}
+}
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench(const char *name, void (*render)(uint8_t *, long), long numFrames) {
+  static uint8_t prev[FRAME_LENGTH], next[FRAME_LENGTH], device[FRAME_LENGTH], delta[FRAME_LENGTH];
+  long bytes = 0, numDeltas = 0, i;
+  double encodeNs = 0, decodeNs = 0;
+
+  render(prev, 0);
+  memcpy(device, prev, FRAME_LENGTH);
+  for (i = 1; i <= numFrames; i++) {
+    render(next, i);
+    double t0 = now();
+    uint16_t n = nkkstream_deltaEncode(prev, next, FRAME_LENGTH, delta, FRAME_LENGTH - 1);
+    double t1 = now();
+    encodeNs += t1 - t0;
+    if (n == NKKstream_DeltaTooLong) {
+      bytes += FULL_PACKET;
+      memcpy(device, next, FRAME_LENGTH);
+    }
+    else {
+      bytes += NKKstream_HeaderLength + n + NKKstream_CRCLength;
+      numDeltas++;
+      t0 = now();
+      uint8_t ok = nkkstream_deltaDecode(device, FRAME_LENGTH, delta, n);
+      decodeNs += now() - t0;
+      if (!ok || memcmp(device, next, FRAME_LENGTH) != 0) {
+        fprintf(stderr, "nkkdeltabench: %s frame %ld decoded wrong\n", name, i);
+        exit(1);
+      }
+    }
+    memcpy(prev, next, FRAME_LENGTH);
+  }
+  printf("%-9s %9.1f %9d %8.1f%% %10.0f %12.0f %8.0f%%\n", name, (double) bytes / numFrames, FULL_PACKET,
+         100.0 * bytes / ((double) FULL_PACKET * numFrames), encodeNs / numFrames,
+         numDeltas ? decodeNs / numDeltas : 0.0, 100.0 * numDeltas / numFrames);
+}
+
+int main(int argc, char *argv[]) {
+  long numFrames = (argc > 1) ? strtol(argv[1], NULL, 0) : 10000;
+  if (numFrames <= 0) {
+    fprintf(stderr, "usage: nkkdeltabench [frames]\n");
+    return 1;
+  }
+  printf("%-9s %9s %9s %9s %10s %12s %9s\n", "trace", "bytes", "full", "ratio", "encode ns", "decode ns", "deltas");
+  bench("counter", renderCounter, numFrames);
+  bench("labels", renderLabels, numFrames);
+  bench("progress", renderProgress, numFrames);
+  bench("random", renderRandom, numFrames);
+  return 0;
+}
@@ -0,0 +1,202 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*********************************************************************
+Host sender for the frame streaming protocol (nkkstream.h)
+
+Sends images in NKK native format (raw files, getImageBufferLength() bytes each, e.g. saved
+from the NKK Bitmap builder) to a board running NKK_StreamReceiver.
+
+  nkksend [-b baud] [-k key] [-c colour] [-l brightness] [-d ms] [-r repeats] [-x] [-f n] device image...
+
+  -b  baud rate of a serial device, default 115200
+  -k  key id, default 0
+  -c  colour in NKK format (RRGGBBxx), e.g. 0xC3
+  -l  brightness in NKK format (BBBxxxxx)
+  -d  delay between images in milliseconds, default 0
+  -r  number of times the image list is sent, default 1
+  -x  send deltas from the previous image (the first image is sent in full), a delta which
+      is not shorter than the image is sent as the full image
+  -f  with -x, send every n-th image in full (resynchronises a receiver which lost a packet)
+
+device is a serial port (/dev/ttyUSB0), a pseudo terminal or a file ("-" - stdout), so a
+stream can be recorded or fed to a receiver running on the host through a pty pair, e.g.
+  socat -d -d pty,raw,echo=0 pty,raw,echo=0
+With no image only the colour and brightness are sent.
+*********************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "nkkstream.h"
+
+#define MAX_IMAGE_LENGTH 8192
+
+static speed_t baudToSpeed(long baud) {
+  switch (baud) {
+    case 9600:    return B9600;
+    case 19200:   return B19200;
+    case 38400:   return B38400;
+    case 57600:   return B57600;
+    case 115200:  return B115200;
+    case 230400:  return B230400;
+#ifdef B460800
+    case 460800:  return B460800;
+#endif
+#ifdef B921600
+    case 921600:  return B921600;
+#endif
+    default:      return 0;
+  }
+}
+
+//Opens the device, a tty is switched to the raw mode at the baud rate
+static int openDevice(const char *path, long baud) {
+  if (strcmp(path, "-") == 0) {
+    return STDOUT_FILENO;
+  }
+  int fd = open(path, O_WRONLY | O_NOCTTY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    fprintf(stderr, "nkksend: cannot open %s: %s\n", path, strerror(errno));
+    return -1;
+  }
+  if (isatty(fd)) {
+    struct termios tio;
+    speed_t speed = baudToSpeed(baud);
+    if (speed == 0) {
+      fprintf(stderr, "nkksend: unsupported baud rate %ld\n", baud);
+      close(fd);
+      return -1;
+    }
+    if (tcgetattr(fd, &tio) == 0) {
+      cfmakeraw(&tio);
+      cfsetispeed(&tio, speed);
+      cfsetospeed(&tio, speed);
+      tcsetattr(fd, TCSANOW, &tio);
+    }
+  }
+  return fd;
+}
+
+static int writeAll(int fd, const uint8_t *data, size_t length) {
+  while (length > 0) {
+    ssize_t n = write(fd, data, length);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+    data += n;
+    length -= n;
+  }
+  return 0;
+}
+
+//Reads a whole image file, returns its length or -1
+static long readImage(const char *path, uint8_t *image) {
+  FILE *f = fopen(path, "rb");
+  if (f == NULL) {
+    fprintf(stderr, "nkksend: cannot open %s: %s\n", path, strerror(errno));
+    return -1;
+  }
+  long length = (long) fread(image, 1, MAX_IMAGE_LENGTH + 1, f);
+  fclose(f);
+  if (length == 0 || length > MAX_IMAGE_LENGTH) {
+    fprintf(stderr, "nkksend: %s: image shall be 1 to %d bytes\n", path, MAX_IMAGE_LENGTH);
+    return -1;
+  }
+  return length;
+}
+
+static void sleepMs(long ms) {
+  struct timespec ts;
+  ts.tv_sec = ms / 1000;
+  ts.tv_nsec = (ms % 1000) * 1000000L;
+  nanosleep(&ts, NULL);
+}
+
+static void usage(void) {
+  fprintf(stderr, "usage: nkksend [-b baud] [-k key] [-c colour] [-l brightness] [-d ms] [-r repeats] [-x] [-f n] device image...\n");
+}
+
+int main(int argc, char *argv[]) {
+  long baud = 115200, delayMs = 0, repeats = 1, fullEvery = 0, numSent = 0, prevLength = 0;
+  int key = 0, flags = 0, colour = 0, brightness = 0, isDelta = 0, opt;
+  static uint8_t image[MAX_IMAGE_LENGTH + 1];
+  static uint8_t prev[MAX_IMAGE_LENGTH];
+  static uint8_t delta[MAX_IMAGE_LENGTH];
+  static uint8_t packet[NKKstream_HeaderLength + MAX_IMAGE_LENGTH + NKKstream_CRCLength];
+
+  while ((opt = getopt(argc, argv, "b:k:c:l:d:r:xf:")) != -1) {
+    switch (opt) {
+      case 'b': baud = strtol(optarg, NULL, 0); break;
+      case 'k': key = (int) strtol(optarg, NULL, 0); break;
+      case 'c': colour = (int) strtol(optarg, NULL, 0); flags |= NKKstream_Colour; break;
+      case 'l': brightness = (int) strtol(optarg, NULL, 0); flags |= NKKstream_Brightness; break;
+      case 'd': delayMs = strtol(optarg, NULL, 0); break;
+      case 'r': repeats = strtol(optarg, NULL, 0); break;
+      case 'x': isDelta = 1; break;
+      case 'f': fullEvery = strtol(optarg, NULL, 0); break;
+      default: usage(); return 1;
+    }
+  }
+  if (optind >= argc || key < 0 || key > 255) {
+    usage();
+    return 1;
+  }
+  int fd = openDevice(argv[optind], baud);
+  if (fd < 0) {
+    return 1;
+  }
+  int numImages = argc - optind - 1;
+
+  if (numImages == 0) {
+    uint16_t n = nkkstream_packet(packet, (uint8_t) key, (uint8_t) (flags | NKKstream_None), (uint8_t) colour, (uint8_t) brightness, NULL, 0);
+    return (writeAll(fd, packet, n) == 0) ? 0 : 1;
+  }
+  for (long r = 0; r < repeats; r++) {
+    for (int i = 0; i < numImages; i++) {
+      long length = readImage(argv[optind + 1 + i], image);
+      if (length < 0) {
+        return 1;
+      }
+      uint16_t deltaLength = NKKstream_DeltaTooLong;
+      if (isDelta && prevLength == length && (fullEvery <= 0 || numSent % fullEvery != 0)) {
+        deltaLength = nkkstream_deltaEncode(prev, image, (uint16_t) length, delta, (uint16_t) (length - 1));
+      }
+      uint16_t n;
+      if (deltaLength != NKKstream_DeltaTooLong) {
+        n = nkkstream_packet(packet, (uint8_t) key, (uint8_t) (flags | NKKstream_Delta), (uint8_t) colour, (uint8_t) brightness,
+                             delta, deltaLength);
+      }
+      else {
+        n = nkkstream_packet(packet, (uint8_t) key, (uint8_t) (flags | NKKstream_Image), (uint8_t) colour, (uint8_t) brightness,
+                             image, (uint16_t) length);
+      }
+      memcpy(prev, image, length);
+      prevLength = length;
+      numSent++;
+      if (writeAll(fd, packet, n) != 0) {
+        fprintf(stderr, "nkksend: write failed: %s\n", strerror(errno));
+        return 1;
+      }
+      if (delayMs > 0) {
+        sleepMs(delayMs);
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,187 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*********************************************************************
+Host test of NKK_StreamReceiver with the host sender over a pseudo terminal
+
+  test_receiver ./nkksend
+
+The receiver runs on the stand-ins of the Arduino core and SPI library (../hoststub), its
+Serial reads the master side of a pty. nkksend writes streams of images (full and -x deltas,
+with colour and brightness) to the slave side, after a packet with a wrong key id. Every
+committed packet shall leave the sent image in imageBufferNKK[] of the key and upload it with
+the Slave Select of that key low only.
+*********************************************************************/
+
+#include <NKKSmartDisplayLCD.h>
+#include <NKKStreamReceiver.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define NUM_KEYS 2
+#define NUM_IMAGES 6
+#define FRAME_LENGTH 256
+#define TIMEOUT_MS 10000
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { printf("%s:%d: %s failed\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+static const uint8_t csPins[NUM_KEYS] = {4, 5};
+static uint8_t images[NUM_IMAGES][FRAME_LENGTH];
+static char imagePaths[NUM_IMAGES][64];
+
+//Images which differ in a few bytes, so -x sends deltas
+static bool writeImages(const char *dir) {
+  for (uint8_t i = 0; i < NUM_IMAGES; i++) {
+    for (uint16_t n = 0; n < FRAME_LENGTH; n++) {
+      images[i][n] = (i == 0) ? rand() : images[i - 1][n];
+    }
+    for (uint8_t n = 0; n < 4*i; n++) {
+      images[i][rand() % FRAME_LENGTH] = rand();
+    }
+    snprintf(imagePaths[i], sizeof(imagePaths[i]), "%s/image%u.bin", dir, i);
+    FILE *f = fopen(imagePaths[i], "wb");
+    if (f == NULL || fwrite(images[i], 1, FRAME_LENGTH, f) != FRAME_LENGTH) {
+      return false;
+    }
+    fclose(f);
+  }
+  return true;
+}
+
+//Runs nkksend in the background with options and all images
+static pid_t startSender(const char *sender, const char *device, const char *options[]) {
+  const char *argv[32];
+  int argc = 0;
+  argv[argc++] = sender;
+  while (*options != NULL) {
+    argv[argc++] = *options++;
+  }
+  argv[argc++] = device;
+  for (uint8_t i = 0; i < NUM_IMAGES; i++) {
+    argv[argc++] = imagePaths[i];
+  }
+  argv[argc] = NULL;
+  pid_t pid = fork();
+  if (pid == 0) {
+    execv(sender, (char * const *) argv);
+    _exit(127);
+  }
+  return pid;
+}
+
+//The upload of the last committed packet - Image Upload command and the image, Slave Select of the key only
+static void checkUpload(uint8_t key, const uint8_t image[]) {
+  CHECK(SPI.out.size() > FRAME_LENGTH);
+  if (SPI.out.size() <= FRAME_LENGTH) {
+    return;
+  }
+  CHECK(SPI.out[0].data == NKK_SmartDisplayLCD_Img_Upload);
+  bool isImage = true, isSelected = true;
+  for (uint16_t n = 0; n < SPI.out.size(); n++) {
+    if (n >= 1 && n <= FRAME_LENGTH) {
+      isImage = isImage && SPI.out[n].data == image[n - 1];
+    }
+    for (uint8_t k = 0; k < NUM_KEYS; k++) {
+      bool isLow = ((SPI.out[n].pins >> csPins[k]) & 1) == 0;
+      isSelected = isSelected && isLow == (k == key);
+    }
+  }
+  CHECK(isImage);
+  CHECK(isSelected);
+}
+
+//Polls the receiver until numPackets packets are committed, checks every one of them
+static void receive(NKK_StreamReceiver *receiver, NKK_SmartDisplayLCD *keys[], uint8_t key, uint8_t numPackets) {
+  uint8_t numReceived = 0;
+  uint32_t waited = 0;
+  SPI.clear();
+  while (numReceived < numPackets && waited < TIMEOUT_MS) {
+    int data = Serial.read();
+    if (data < 0) {
+      usleep(1000);
+      waited++;
+      continue;
+    }
+    if (receiver->receiveByte((byte) data)) {
+      CHECK(memcmp(keys[key]->imageBufferNKK, images[numReceived % NUM_IMAGES], FRAME_LENGTH) == 0);
+      checkUpload(key, images[numReceived % NUM_IMAGES]);
+      SPI.clear();
+      numReceived++;
+    }
+  }
+  CHECK(numReceived == numPackets);
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: test_receiver nkksend\n");
+    return 2;
+  }
+  char dir[] = "/tmp/nkkstreamXXXXXX";
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (mkdtemp(dir) == NULL || !writeImages(dir) || master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+    fprintf(stderr, "test_receiver: cannot set up the pty or the images\n");
+    return 2;
+  }
+  const char *device = ptsname(master);
+  //keeps the slave side open between the senders, raw so that no byte is translated
+  int slave = open(device, O_RDWR | O_NOCTTY);
+  struct termios tio;
+  if (slave < 0 || tcgetattr(slave, &tio) != 0) {
+    fprintf(stderr, "test_receiver: cannot open %s\n", device);
+    return 2;
+  }
+  cfmakeraw(&tio);
+  tcsetattr(slave, TCSANOW, &tio);
+  Serial.setFd(master);
+
+  NKK_SmartDisplayLCD NKK1(64,32,0,csPins[0]), NKK2(64,32,0,csPins[1]);
+  NKK_SmartDisplayLCD *keys[NUM_KEYS] = {&NKK1, &NKK2};
+  NKK_StreamReceiver receiver(&Serial, keys, NUM_KEYS);
+  for (uint8_t k = 0; k < NUM_KEYS; k++) {
+    CHECK(keys[k]->begin());
+  }
+  CHECK(receiver.begin());
+
+  //a packet for a key which does not exist is dropped, the parser finds the next packet
+  uint8_t packet[NKKstream_HeaderLength + NKKstream_CRCLength];
+  uint16_t length = nkkstream_packet(packet, NUM_KEYS, NKKstream_Colour, 0xC3, 0, NULL, 0);
+  CHECK(write(slave, packet, length) == length);
+
+  //full images to key 0, twice
+  const char *full[] = {"-k", "0", "-r", "2", NULL};
+  pid_t pid = startSender(argv[1], device, full);
+  receive(&receiver, keys, 0, 2*NUM_IMAGES);
+  waitpid(pid, NULL, 0);
+  CHECK(receiver.getNumErrors() == 1);
+
+  //deltas, every third image in full, with colour and brightness to key 1
+  const char *delta[] = {"-k", "1", "-x", "-f", "3", "-c", "0xC3", "-l", "0x5F", NULL};
+  pid = startSender(argv[1], device, delta);
+  receive(&receiver, keys, 1, NUM_IMAGES);
+  waitpid(pid, NULL, 0);
+  CHECK(NKK2.bkgColour == 0xC3);
+  CHECK(NKK2.bkgBrightnes == 0x5F);
+  CHECK(memcmp(NKK1.imageBufferNKK, images[NUM_IMAGES - 1], FRAME_LENGTH) == 0);
+  CHECK(receiver.getNumPackets() == 3*NUM_IMAGES);
+  CHECK(receiver.getNumErrors() == 1);
+
+  for (uint8_t i = 0; i < NUM_IMAGES; i++) {
+    unlink(imagePaths[i]);
+  }
+  rmdir(dir);
+  close(slave);
+  close(master);
+  printf("test_receiver: %s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
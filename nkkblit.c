@@ -0,0 +1,150 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+
+#include "nkkblit.h"
+#include <string.h>
+
+//Word - the unit of a row processed at once, DWord holds a word and the byte after it for unaligned sources
+#if defined(__AVR__) || !defined(__BYTE_ORDER__) || (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__)
+  typedef uint8_t Word;
+  typedef uint16_t DWord;
+#else
+  typedef uint32_t Word;
+  typedef uint64_t DWord;
+#endif
+#define WORD_BYTES ((int16_t) sizeof(Word))
+#define WORD_BITS (8 * WORD_BYTES)
+#define WORD_ONES ((Word) ~(Word) 0)
+
+//Bits pos..pos+WORD_BITS-1 of a source row, pixel pos is bit 0. Bytes out of first..last are not read (0),
+//so the reads stay in the rectangle of the row
+static Word fetchBits(const uint8_t *row, int32_t pos, int32_t first, int32_t last) {
+  int32_t index = (pos >= 0) ? pos / 8 : -((-pos + 7) / 8); //rounded down
+  uint8_t shift = pos - 8 * index;
+  Word bits;
+
+  if (index >= first && index + WORD_BYTES <= last) {
+    memcpy(&bits, row + index, WORD_BYTES); //little endian - pixel x is bit x of the word
+    if (shift) {
+      bits = (Word) ((bits >> shift) | ((Word) row[index + WORD_BYTES] << (WORD_BITS - shift)));
+    }
+    return bits;
+  }
+  DWord acc = 0;
+  int16_t b;
+  for (b = 0; b <= WORD_BYTES; b++) {
+    if (index + b >= first && index + b <= last) {
+      acc |= (DWord) row[index + b] << (8 * b);
+    }
+  }
+  return (Word) (acc >> shift);
+}
+
+//Word k of a destination row, bytes from limit on are not part of the row
+static Word loadWord(const uint8_t *row, int16_t k, int16_t limit) {
+  Word bits = 0;
+  if ((k + 1) * WORD_BYTES <= limit) {
+    memcpy(&bits, row + k * WORD_BYTES, WORD_BYTES);
+    return bits;
+  }
+  int16_t b;
+  for (b = 0; b < WORD_BYTES && k * WORD_BYTES + b < limit; b++) {
+    bits |= (Word) row[k * WORD_BYTES + b] << (8 * b);
+  }
+  return bits;
+}
+
+static void storeWord(uint8_t *row, int16_t k, int16_t limit, Word bits) {
+  if ((k + 1) * WORD_BYTES <= limit) {
+    memcpy(row + k * WORD_BYTES, &bits, WORD_BYTES);
+    return;
+  }
+  int16_t b;
+  for (b = 0; b < WORD_BYTES && k * WORD_BYTES + b < limit; b++) {
+    row[k * WORD_BYTES + b] = (uint8_t) (bits >> (8 * b));
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Combines a rectangle of a source surface with a rectangle of a destination surface by a raster operation,
+	        a word of a destination row at a time. Head and tail words of a row are merged with masks, unaligned source
+	        rows are shifted. The rectangles are clipped to the surfaces (and the mask).
+    @param  dst Destination surface.
+    @param  dx, dy Top left corner of the destination rectangle.
+    @param  src Source surface.
+    @param  sx, sy Top left corner of the source rectangle.
+    @param  w, h Size of the rectangle in pixels.
+    @param  rop NKKblit_Copy, NKKblit_Or, NKKblit_And, NKKblit_Xor or NKKblit_AndNot.
+    @param  mask Mask surface in the source coordinates, only pixels set in the mask are changed. NULL - all pixels of the rectangle.
+    @return Number of destination rows changed, 0 if the rectangle is clipped out.
+	@note   Source and destination rectangles shall not overlap in the same buffer.
+*/
+/**************************************************************************/
+uint16_t nkkblit(const NKKsurface *dst, int16_t dx, int16_t dy, const NKKsurface *src, int16_t sx, int16_t sy,
+                 int16_t w, int16_t h, uint8_t rop, const NKKsurface *mask) {
+  int32_t pos;
+  int16_t row;
+  //clip to the source (and the mask), then to the destination
+  if (sx < 0) {w += sx; dx -= sx; sx = 0;}
+  if (sy < 0) {h += sy; dy -= sy; sy = 0;}
+  if (dx < 0) {w += dx; sx -= dx; dx = 0;}
+  if (dy < 0) {h += dy; sy -= dy; dy = 0;}
+  if ((int32_t) sx + w > src->w) {w = src->w - sx;}
+  if ((int32_t) sy + h > src->h) {h = src->h - sy;}
+  if (mask != NULL) {
+    if ((int32_t) sx + w > mask->w) {w = mask->w - sx;}
+    if ((int32_t) sy + h > mask->h) {h = mask->h - sy;}
+  }
+  if ((int32_t) dx + w > dst->w) {w = dst->w - dx;}
+  if ((int32_t) dy + h > dst->h) {h = dst->h - dy;}
+  if (w <= 0 || h <= 0) {
+    return 0;
+  }
+
+  int16_t firstWord = dx / WORD_BITS;
+  int16_t lastWord = (dx + w - 1) / WORD_BITS;
+  Word headMask = (Word) (WORD_ONES << (dx % WORD_BITS));
+  Word tailMask = (Word) (WORD_ONES >> (WORD_BITS - 1 - (dx + w - 1) % WORD_BITS));
+  int16_t dstLimit = (dst->w + 7) / 8;            //bytes of a destination row
+  int32_t srcFirst = sx / 8;                      //bytes of a source (and mask) row in the rectangle
+  int32_t srcLast = (sx + w - 1) / 8;
+  int32_t shift = (int32_t) sx - dx;              //source pixel of destination pixel 0
+
+  for (row = 0; row < h; row++) {
+    uint8_t *dRow = dst->buffer + (uint32_t) (dy + row) * dst->stride;
+    const uint8_t *sRow = src->buffer + (uint32_t) (sy + row) * src->stride;
+    const uint8_t *mRow = (mask != NULL) ? mask->buffer + (uint32_t) (sy + row) * mask->stride : NULL;
+    int16_t k;
+
+    for (k = firstWord; k <= lastWord; k++) {
+      Word m = WORD_ONES;
+      if (k == firstWord) {m &= headMask;}
+      if (k == lastWord) {m &= tailMask;}
+      pos = (int32_t) k * WORD_BITS + shift;
+      Word s = fetchBits(sRow, pos, srcFirst, srcLast);
+      if (mRow != NULL) {
+        m &= fetchBits(mRow, pos, srcFirst, srcLast);
+      }
+      Word d = loadWord(dRow, k, dstLimit);
+      Word r;
+      switch (rop) {
+        case NKKblit_Or:     r = d | s;  break;
+        case NKKblit_And:    r = d & s;  break;
+        case NKKblit_Xor:    r = d ^ s;  break;
+        case NKKblit_AndNot: r = d & ~s; break;
+        default:             r = s;      break;
+      }
+      storeWord(dRow, k, dstLimit, (Word) ((d & ~m) | (r & m)));
+    }
+  }
+  return h;
+}
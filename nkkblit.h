@@ -0,0 +1,59 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*********************************************************************
+Raster-op blitter for packed 1 bit surfaces.
+
+imageBufferGFX[] and XBM bitmaps are LSB first rows (pixel x is bit x%8 of byte x/8), so a
+rectangle of a bitmap is copied or combined into the image a word at a time instead of a
+pixel at a time:
+ - Destination rows are processed in words, partial words at the ends of a row are merged
+   with head and tail masks, unaligned source rows are shifted into place.
+ - Raster operations: copy, OR (set), AND, XOR (invert) and AND NOT (clear).
+ - An optional mask surface (the same coordinates as the source) limits the pixels changed,
+   e.g. for sprites with transparent pixels.
+ - Source and destination rectangles are clipped to their surfaces.
+
+Words are 32 bit on little endian 32 bit cores and bytes on AVR (8 bit core) and big endian hosts.
+Plain C with no Arduino dependency, it can be used by host tools as well.
+*********************************************************************/
+#ifndef _NKKBLIT_H_
+#define _NKKBLIT_H_
+
+#include <stdint.h>
+
+#define NKKblit_Copy 0   // d = s
+#define NKKblit_Or 1     // d = d | s, set the source pixels
+#define NKKblit_And 2    // d = d & s
+#define NKKblit_Xor 3    // d = d ^ s, invert the source pixels
+#define NKKblit_AndNot 4 // d = d & ~s, clear the source pixels
+
+/// Packed 1 bit surface, LSB first rows
+typedef struct {
+  uint8_t *buffer; ///< First row
+  uint16_t w;      ///< Width in pixels
+  uint16_t h;      ///< Height in pixels
+  uint16_t stride; ///< Distance between rows in bytes, at least (w+7)/8
+} NKKsurface;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//Combines a w*h rectangle at sx,sy of src with the rectangle at dx,dy of dst by a raster operation. mask (NULL - none) has
+//the coordinates of src, only pixels set in the mask are changed. Returns the number of rows changed, 0 if clipped out.
+uint16_t nkkblit(const NKKsurface *dst, int16_t dx, int16_t dy, const NKKsurface *src, int16_t sx, int16_t sy,
+                 int16_t w, int16_t h, uint8_t rop, const NKKsurface *mask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _NKKBLIT_H_
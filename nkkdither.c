@@ -0,0 +1,148 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+
+#include "nkkdither.h"
+
+#ifdef __AVR__
+  #include <avr/pgmspace.h>
+#endif
+
+#ifndef PROGMEM
+  #define PROGMEM
+#endif
+#ifndef pgm_read_byte
+  #define pgm_read_byte(addr) (*(const unsigned char *)(addr))
+#endif
+
+//8x8 Bayer matrix scaled to grey thresholds, (m + 0.5) * 4
+static const uint8_t bayerThreshold[64] PROGMEM = {
+    2, 130,  34, 162,  10, 138,  42, 170,
+  194,  66, 226,  98, 202,  74, 234, 106,
+   50, 178,  18, 146,  58, 186,  26, 154,
+  242, 114, 210,  82, 250, 122, 218,  90,
+   14, 142,  46, 174,   6, 134,  38, 166,
+  206,  78, 238, 110, 198,  70, 230, 102,
+   62, 190,  30, 158,  54, 182,  22, 150,
+  254, 126, 222,  94, 246, 118, 214,  86
+};
+
+//Packed row writer - bits are collected for a destination byte and the byte is written once,
+//partial bytes at the ends of the row keep their other pixels
+typedef struct {
+  uint8_t *dst;
+  uint16_t pos;
+  uint8_t bitOrder;
+  uint8_t bits;
+  uint8_t mask;
+} RowWriter;
+
+static void rowwriter_put(RowWriter *writer, uint8_t isSet) {
+  uint8_t b = (writer->bitOrder == NKKdither_MSBFirst) ? 0x80 >> (writer->pos & 7) : 1 << (writer->pos & 7);
+  writer->mask |= b;
+  if (isSet) {
+    writer->bits |= b;
+  }
+  writer->pos++;
+  if ((writer->pos & 7) == 0) {
+    uint8_t *target = writer->dst + ((writer->pos - 1) >> 3);
+    *target = (*target & ~writer->mask) | writer->bits;
+    writer->bits = 0;
+    writer->mask = 0;
+  }
+}
+
+static void rowwriter_flush(RowWriter *writer) {
+  if (writer->mask != 0) {
+    uint8_t *target = writer->dst + ((writer->pos - 1) >> 3);
+    *target = (*target & ~writer->mask) | writer->bits;
+    writer->bits = 0;
+    writer->mask = 0;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Ordered dithering of a row with an 8x8 Bayer matrix. A pixel is set where grey is below the matrix threshold.
+    @param  grey[] Source row, 0 - black, 255 - white.
+    @param  w Number of pixels.
+    @param  dst[] Destination row, 1 bit per pixel.
+    @param  x First destination pixel.
+    @param  y Destination row number, selects the row of the matrix.
+    @param  bitOrder NKKdither_LSBFirst or NKKdither_MSBFirst.
+*/
+/**************************************************************************/
+void nkkdither_bayerRow(const uint8_t grey[], uint16_t w, uint8_t dst[], uint16_t x, uint16_t y, uint8_t bitOrder) {
+  RowWriter writer = {dst, x, bitOrder, 0, 0};
+  const uint8_t *threshold = bayerThreshold + 8*(y & 7);
+  uint16_t i;
+  for (i = 0; i < w; i++) {
+    rowwriter_put(&writer, grey[i] < pgm_read_byte(&threshold[(x + i) & 7]));
+  }
+  rowwriter_flush(&writer);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Floyd-Steinberg error diffusion of a row, left to right. The quantisation error of a pixel goes 7/16 to the right,
+	        3/16 below left, 5/16 below and 1/16 below right, rounding leftovers go to the right so the error is not lost.
+    @param  grey[] Source row, 0 - black, 255 - white.
+    @param  w Number of pixels.
+    @param  err[] w+1 error values, the error of the previous row in, the error for the next row out. Set to 0 before the first row.
+    @param  dst[] Destination row, 1 bit per pixel.
+    @param  x First destination pixel.
+    @param  bitOrder NKKdither_LSBFirst or NKKdither_MSBFirst.
+*/
+/**************************************************************************/
+void nkkdither_floydSteinbergRow(const uint8_t grey[], uint16_t w, int16_t err[], uint8_t dst[], uint16_t x, uint8_t bitOrder) {
+  RowWriter writer = {dst, x, bitOrder, 0, 0};
+  int16_t right = 0;      //error for the next pixel of this row
+  int16_t belowRight = 0; //error of the previous pixel for the pixel below the current one
+  uint16_t i;
+  //err[i+1] is the error of pixel i - read for this row, then replaced with the error for the next row. err[0] takes the error
+  //which leaves the left edge
+  err[0] = 0;
+  for (i = 0; i < w; i++) {
+    int16_t value = grey[i] + err[i + 1] + right;
+    uint8_t isSet = (value < 128);
+    int16_t e = value - (isSet ? 0 : 255);
+    int16_t e3 = e * 3 / 16;
+    int16_t e5 = e * 5 / 16;
+    int16_t e1 = e / 16;
+    rowwriter_put(&writer, isSet);
+    err[i] += e3;
+    err[i + 1] = e5 + belowRight;
+    belowRight = e1;
+    right = e - e3 - e5 - e1;
+  }
+  rowwriter_flush(&writer);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Converts a row of RGB565 pixels into grey, weights 77/256 R, 150/256 G, 29/256 B.
+    @param  rgb[] Source row.
+    @param  w Number of pixels.
+    @param  grey[] Destination row.
+*/
+/**************************************************************************/
+void nkkdither_rgb565ToGrey(const uint16_t rgb[], uint16_t w, uint8_t grey[]) {
+  uint16_t i;
+  for (i = 0; i < w; i++) {
+    uint16_t c = rgb[i];
+    uint16_t r = (c >> 11) & 0x1F;
+    uint16_t g = (c >> 5) & 0x3F;
+    uint16_t b = c & 0x1F;
+    r = (r << 3) | (r >> 2); //expand to 8 bits
+    g = (g << 2) | (g >> 4);
+    b = (b << 3) | (b >> 2);
+    grey[i] = (uint8_t) ((r * 77 + g * 150 + b * 29) >> 8);
+  }
+}
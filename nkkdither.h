@@ -0,0 +1,58 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*********************************************************************
+1-bit dithering of greyscale and RGB565 rows into packed monochrome rows.
+
+NKK devices are monochrome, a greyscale icon drawn pixel by pixel becomes a solid blob
+(any non-zero colour is a set pixel). These functions threshold a whole row at a time
+and write packed bytes straight into a 1-bit row:
+ - Ordered dithering with an 8x8 Bayer matrix - no state, the pattern is fixed to the
+   destination coordinates, so parts of an image can be redrawn independently.
+ - Floyd-Steinberg error diffusion - better gradients, carries an error row (w+1 values)
+   from one row to the next.
+
+A pixel is set (1, dark on the NKK device) where the source is dark: grey 0 is black, 255 - white,
+invert the source for the opposite. Destination rows are LSB first (imageBufferGFX[]) or MSB first
+(Adafruit GFXcanvas1, drawBitmap() bitmaps).
+
+Plain C with no Arduino dependency, so offline asset tools can compile it on a host to
+pre-dither images into bitmaps.
+*********************************************************************/
+#ifndef _NKKDITHER_H_
+#define _NKKDITHER_H_
+
+#include <stdint.h>
+
+#define NKKdither_Bayer 0
+#define NKKdither_FloydSteinberg 1
+
+#define NKKdither_LSBFirst 0 // imageBufferGFX[]
+#define NKKdither_MSBFirst 1 // Adafruit GFXcanvas1, drawBitmap()
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//Ordered dithering of w grey pixels into pixels x..x+w-1 of a destination row, y is the destination row number (Bayer pattern phase)
+void nkkdither_bayerRow(const uint8_t grey[], uint16_t w, uint8_t dst[], uint16_t x, uint16_t y, uint8_t bitOrder);
+
+//Floyd-Steinberg error diffusion of w grey pixels into pixels x..x+w-1 of a destination row.
+//err[] - w+1 values carried from the previous row of the image, set to 0 before the first row.
+void nkkdither_floydSteinbergRow(const uint8_t grey[], uint16_t w, int16_t err[], uint8_t dst[], uint16_t x, uint8_t bitOrder);
+
+//Converts w RGB565 pixels into grey (0.299R + 0.587G + 0.114B)
+void nkkdither_rgb565ToGrey(const uint16_t rgb[], uint16_t w, uint8_t grey[]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _NKKDITHER_H_
@@ -0,0 +1,131 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*********************************************************************
+Font structures for fonts in NKK native format.
+Generated by fontconvert (examples/Adafruit_GFX_Library_integration/src/Adafruit-GFX-Library/fontconvert)
+with the -l (Landscape) or -p (Portrait) option, drawn directly into imageBufferNKK[] by
+NKK_SmartDisplayLCD::drawCharNKK() and drawTextNKK().
+
+Glyph metrics are the same as for Adafruit_GFX fonts (GFXglyph), glyph bitmaps are byte aligned
+so they are stamped into imageBufferNKK[] with shifts and ORs:
+ - Landscape: a row of the glyph per (width+7)/8 bytes, pixel x of a row is bit x%8 of byte x/8
+   (LSB first, the same as a row of imageBufferGFX[]).
+ - Portrait: a column of the glyph per (height+7)/8 bytes, pixel y of a column is bit 7-y%8 of byte y/8
+   (MSB first, the same as a column of imageBufferNKK[] in Portrait).
+Glyph bitmaps may be compressed per row (fontconvert -c): a row (Landscape) or column (Portrait)
+which repeats the previous one is stored as a count, decoded byte by byte while the glyph is drawn. Fonts may be subset (fontconvert -s or -f), characters out of
+the subset are empty glyphs (no bitmap).
+*********************************************************************/
+#ifndef _NKKFONT_H_
+#define _NKKFONT_H_
+
+#ifdef __AVR__
+  #include <avr/pgmspace.h>
+#endif
+
+#ifndef pgm_read_byte
+  #define pgm_read_byte(addr) (*(const unsigned char *)(addr))
+#endif
+#ifndef pgm_read_word
+  #define pgm_read_word(addr) (*(const unsigned short *)(addr))
+#endif
+
+#define NKKfont_Landscape 0
+#define NKKfont_Portrait 1
+
+#define NKKfont_Raw 0
+#define NKKfont_RowRLE 2 // 1 is not used
+
+/// Font data stored PER GLYPH, the same as GFXglyph
+typedef struct {
+  uint16_t bitmapOffset; ///< Pointer into NKKfont->bitmap
+  uint8_t width;         ///< Bitmap dimensions in pixels
+  uint8_t height;        ///< Bitmap dimensions in pixels
+  uint8_t xAdvance;      ///< Distance to advance cursor (x axis)
+  int8_t xOffset;        ///< X dist from cursor pos to UL corner
+  int8_t yOffset;        ///< Y dist from cursor pos to UL corner
+} NKKglyph;
+
+/// Data stored for FONT AS A WHOLE
+typedef struct {
+  uint8_t *bitmap;     ///< Glyph bitmaps in NKK native format, concatenated
+  NKKglyph *glyph;     ///< Glyph array
+  uint16_t first;      ///< ASCII extents (first char)
+  uint16_t last;       ///< ASCII extents (last char)
+  uint8_t yAdvance;    ///< Newline distance (y axis)
+  uint8_t orientation; ///< NKKfont_Landscape or NKKfont_Portrait, shall match the NKK device
+  uint8_t compression; ///< NKKfont_Raw or NKKfont_RowRLE
+} NKKfont;
+
+/// Streaming reader of a glyph bitmap, raw or compressed per row
+typedef struct {
+  const uint8_t *bitmap; ///< Next byte of the bitmap (PROGMEM)
+  const uint8_t *row;    ///< Last literal row (PROGMEM), a repeat reads it again
+  uint8_t compression;   ///< NKKfont_Raw or NKKfont_RowRLE
+  uint8_t rowBytes;      ///< Bytes per row (Landscape) or column (Portrait) of the glyph
+  uint8_t pos;           ///< Byte of the current row
+  uint8_t count;         ///< Rows left in the current literal block or repeat
+  uint8_t isRun;         ///< The current block repeats the last literal row
+} NKKglyphReader;
+
+//Pointers of a font stored in PROGMEM - 16 bit on AVR, other platforms read program memory in a usual way
+inline NKKglyph *pgm_read_nkkglyph_ptr(const NKKfont *font, uint16_t c) {
+#ifdef __AVR__
+  return ((NKKglyph *)pgm_read_word(&font->glyph)) + c;
+#else
+  return font->glyph + c;
+#endif
+}
+
+inline uint8_t *pgm_read_nkkbitmap_ptr(const NKKfont *font) {
+#ifdef __AVR__
+  return (uint8_t *)pgm_read_word(&font->bitmap);
+#else
+  return font->bitmap;
+#endif
+}
+
+//Starts reading the bitmap of a glyph, rowBytes is the length of a glyph row (Landscape) or column (Portrait)
+inline void nkkglyph_begin(NKKglyphReader *reader, const NKKfont *font, const NKKglyph *glyph, uint8_t rowBytes) {
+  reader->bitmap = pgm_read_nkkbitmap_ptr(font) + pgm_read_word(&glyph->bitmapOffset);
+  reader->row = reader->bitmap;
+  reader->compression = pgm_read_byte(&font->compression);
+  reader->rowBytes = rowBytes;
+  reader->pos = 0;
+  reader->count = 0;
+  reader->isRun = 0;
+}
+
+//Returns the next byte of a glyph bitmap. Row header h: 0..127 - h+1 literal rows follow, 
+//128..255 - the last literal row is repeated h-127 times
+inline uint8_t nkkglyph_read(NKKglyphReader *reader) {
+  if (reader->compression != NKKfont_RowRLE) {
+    return pgm_read_byte(reader->bitmap++);
+  }
+  if (reader->pos == 0) {
+    if (reader->count == 0) {
+      uint8_t h = pgm_read_byte(reader->bitmap++);
+      reader->isRun = (h >= 128);
+      reader->count = reader->isRun ? h - 127 : h + 1;
+    }
+    if (!reader->isRun) {
+      reader->row = reader->bitmap;
+    }
+  }
+  uint8_t b = reader->isRun ? pgm_read_byte(reader->row + reader->pos) : pgm_read_byte(reader->bitmap++);
+  if (++reader->pos == reader->rowBytes) {
+    reader->pos = 0;
+    reader->count--;
+  }
+  return b;
+}
+
+#endif // _NKKFONT_H_
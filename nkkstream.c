@@ -0,0 +1,220 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+
+#include "nkkstream.h"
+#include <string.h>
+
+//CRC-16/CCITT of a nibble at the top of the CRC
+static const uint16_t crcNibble[16] = {0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7, 0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF};
+
+/**************************************************************************/
+/*!
+    @brief  Computes CRC-16/CCITT (polynomial 0x1021, MSB first) of a buffer, a nibble at a time.
+    @param  crc CRC so far, 0xFFFF for the first buffer.
+    @param  data Buffer.
+    @param  length Number of bytes.
+    @return CRC.
+*/
+/**************************************************************************/
+uint16_t nkkstream_crc16(uint16_t crc, const uint8_t *data, uint16_t length) {
+  uint16_t i;
+  for (i = 0; i < length; i++) {
+    crc = (uint16_t) ((crc << 4) ^ crcNibble[(crc >> 12) ^ (data[i] >> 4)]);
+    crc = (uint16_t) ((crc << 4) ^ crcNibble[(crc >> 12) ^ (data[i] & 0x0F)]);
+  }
+  return crc;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Writes a packet: sync bytes, header, payload and CRC.
+    @param  dst Buffer for the packet, NKKstream_HeaderLength + length + NKKstream_CRCLength bytes.
+    @param  key Key id, index in the keys[] array of the receiver.
+    @param  flags NKKstream_Colour, NKKstream_Brightness and the payload type (NKKstream_None, NKKstream_Image).
+    @param  colour Colour in NKK format, used with NKKstream_Colour.
+    @param  brightness Brightness in NKK format, used with NKKstream_Brightness.
+    @param  payload Payload, NULL if length is 0.
+    @param  length Payload length in bytes.
+    @return Packet length in bytes.
+*/
+/**************************************************************************/
+uint16_t nkkstream_packet(uint8_t *dst, uint8_t key, uint8_t flags, uint8_t colour, uint8_t brightness,
+                          const uint8_t *payload, uint16_t length) {
+  uint16_t n = NKKstream_HeaderLength + length;
+  dst[0] = NKKstream_Sync0;
+  dst[1] = NKKstream_Sync1;
+  dst[2] = key;
+  dst[3] = flags;
+  dst[4] = colour;
+  dst[5] = brightness;
+  dst[6] = (uint8_t) length;
+  dst[7] = (uint8_t) (length >> 8);
+  if (length > 0) {
+    memcpy(dst + NKKstream_HeaderLength, payload, length);
+  }
+  uint16_t crc = nkkstream_crc16(0xFFFF, dst + 2, n - 2);
+  dst[n] = (uint8_t) crc;
+  dst[n + 1] = (uint8_t) (crc >> 8);
+  return n + NKKstream_CRCLength;
+}
+
+//Delta run types, the top 2 bits of a control byte
+#define RUN_SKIP 0x00
+#define RUN_LITERAL 0x40
+#define RUN_REPEAT 0x80
+#define RUN_SKIP64 0xC0
+#define RUN_MAX 64
+
+//Number of bytes from i on with the same XOR value as byte i, up to max
+static uint16_t runLength(const uint8_t *prev, const uint8_t *next, uint16_t i, uint16_t length, uint16_t max) {
+  uint8_t x = prev[i] ^ next[i];
+  uint16_t n = 1;
+  while (n < max && i + n < length && (uint8_t) (prev[i + n] ^ next[i + n]) == x) {
+    n++;
+  }
+  return n;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Encodes the changes between two frames as a delta payload: the CRC of the base frame and the run length encoded XOR
+	        of the frames (skips of unchanged bytes, literal and repeated XOR bytes).
+    @param  prev The base frame, the last frame committed to the key.
+    @param  next The new frame.
+    @param  length Frame length in bytes.
+    @param  dst Buffer for the delta.
+    @param  capacity dst size in bytes, e.g. length - 1 to get a delta shorter than the full image.
+    @return Delta length in bytes, NKKstream_DeltaTooLong if the delta does not fit into capacity.
+*/
+/**************************************************************************/
+uint16_t nkkstream_deltaEncode(const uint8_t *prev, const uint8_t *next, uint16_t length, uint8_t *dst, uint16_t capacity) {
+  uint16_t n = 0, i = 0, r;
+  if (capacity < 2) {
+    return NKKstream_DeltaTooLong;
+  }
+  uint16_t crc = nkkstream_crc16(0xFFFF, prev, length);
+  dst[n++] = (uint8_t) crc;
+  dst[n++] = (uint8_t) (crc >> 8);
+
+  while (i < length) {
+    if (prev[i] == next[i]) {
+      r = runLength(prev, next, i, length, length);
+      if (i + r == length) {
+        break; //trailing unchanged bytes are not encoded
+      }
+      i += r;
+      while (r > 0) {
+        if (n + 1 > capacity) {
+          return NKKstream_DeltaTooLong;
+        }
+        if (r >= RUN_MAX) {
+          uint16_t k = (r / RUN_MAX > RUN_MAX) ? RUN_MAX : r / RUN_MAX;
+          dst[n++] = (uint8_t) (RUN_SKIP64 | (k - 1));
+          r -= k * RUN_MAX;
+        }
+        else {
+          dst[n++] = (uint8_t) (RUN_SKIP | (r - 1));
+          r = 0;
+        }
+      }
+      continue;
+    }
+    r = runLength(prev, next, i, length, RUN_MAX);
+    if (r >= 2) {
+      if (n + 2 > capacity) {
+        return NKKstream_DeltaTooLong;
+      }
+      dst[n++] = (uint8_t) (RUN_REPEAT | (r - 1));
+      dst[n++] = prev[i] ^ next[i];
+      i += r;
+      continue;
+    }
+    //literal - up to a run of 3 unchanged or 4 equal bytes, which are cheaper as a skip or a repeat
+    uint16_t start = i;
+    while (i < length && i - start < RUN_MAX) {
+      uint16_t limit = (prev[i] == next[i]) ? 3 : 4;
+      if (i > start && runLength(prev, next, i, length, limit) >= limit) {
+        break;
+      }
+      i++;
+    }
+    if (n + 1 + (i - start) > capacity) {
+      return NKKstream_DeltaTooLong;
+    }
+    dst[n++] = (uint8_t) (RUN_LITERAL | (i - start - 1));
+    for (r = start; r < i; r++) {
+      dst[n++] = prev[r] ^ next[r];
+    }
+  }
+  return n;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Applies a delta payload to a frame in place. The delta is checked first: the CRC of the frame shall match the base
+	        frame CRC and the runs shall stay within the frame.
+    @param  frame The frame, the last frame committed to the key.
+    @param  length Frame length in bytes.
+    @param  delta Delta payload.
+    @param  deltaLength Delta length in bytes.
+    @return 1 if the delta has been applied, 0 if it is based on a different frame or corrupted (the frame is not changed).
+*/
+/**************************************************************************/
+uint8_t nkkstream_deltaDecode(uint8_t *frame, uint16_t length, const uint8_t *delta, uint16_t deltaLength) {
+  uint16_t n, i, k;
+  uint8_t pass;
+  if (deltaLength < 2 || (delta[0] | (delta[1] << 8)) != nkkstream_crc16(0xFFFF, frame, length)) {
+    return 0;
+  }
+  //pass 0 checks the runs, pass 1 applies them
+  for (pass = 0; pass < 2; pass++) {
+    n = 2;
+    i = 0;
+    while (n < deltaLength) {
+      uint8_t c = delta[n++];
+      uint16_t r = (c & (RUN_MAX - 1)) + 1;
+      switch (c & RUN_SKIP64) {
+        case RUN_SKIP:
+          break;
+        case RUN_SKIP64:
+          r *= RUN_MAX;
+          break;
+        case RUN_LITERAL:
+          if (n + r > deltaLength) {
+            return 0;
+          }
+          if (pass) {
+            for (k = 0; k < r; k++) {
+              frame[i + k] ^= delta[n + k];
+            }
+          }
+          n += r;
+          break;
+        default:
+          if (n + 1 > deltaLength) {
+            return 0;
+          }
+          if (pass) {
+            for (k = 0; k < r; k++) {
+              frame[i + k] ^= delta[n];
+            }
+          }
+          n++;
+          break;
+      }
+      if ((uint32_t) i + r > length) {
+        return 0;
+      }
+      i += r;
+    }
+  }
+  return 1;
+}
@@ -0,0 +1,87 @@
+/*********************************************************************
+This file is a part of a library for NKK LCD 64x32 SmartDisplay
+  https://www.nkkswitches.com/smartdisplay/
+
+Copyright (c) 2021, IFH
+All rights reserved.
+
+GNU General Public License,  check license.txt for more information
+All text above must be included in any redistribution
+*********************************************************************/
+/*********************************************************************
+Frame streaming protocol for NKK LCD 64x32 SmartDisplay
+
+Frames generated on a host (PC) are sent to the board over a serial link as packets:
+
+  byte 0    NKKstream_Sync0 (0xA5)
+  byte 1    NKKstream_Sync1 (0x5A)
+  byte 2    key id, index in the keys[] array of the receiver
+  byte 3    flags: NKKstream_Colour, NKKstream_Brightness - bytes 4/5 are valid,
+            payload type NKKstream_Image, NKKstream_Delta (or NKKstream_None - colour/brightness only)
+  byte 4    colour in NKK format (RRGGBBxx)
+  byte 5    brightness in NKK format (BBBxxxxx)
+  byte 6,7  payload length, little endian
+  payload   an image in NKK native format (getImageBufferLength() bytes) or a delta
+  CRC       CRC-16/CCITT (0xFFFF start) of bytes 2 up to the end of the payload, little endian
+
+The receiver (NKK_StreamReceiver, NKKStreamReceiver.h) drops packets with a wrong CRC, key id
+or length and searches for the next sync bytes.
+
+Delta payload - the changes from the last frame committed to the key, applied in place:
+  byte 0,1  CRC-16/CCITT of the frame the delta is based on, little endian. A delta for a
+            different frame (e.g. a packet was lost) is dropped, send a full image then.
+  runs      XOR of the new and the base frame, run length encoded. A run is a control byte
+            c = tt nnnnnn (n = 1..64 from the low 6 bits + 1):
+              00 - skip n bytes (XOR 0, unchanged)
+              01 - n literal XOR bytes follow
+              10 - one XOR byte follows, repeated n times
+              11 - skip 64*n bytes
+            Bytes after the last run are unchanged.
+Unchanged bytes cost nothing, changed bytes cost their XOR, so a changed digit or a label
+is a few bytes instead of a full image. Plain C with no Arduino dependency, the host
+sender (extras/nkkstream) uses the same code.
+*********************************************************************/
+#ifndef _NKKSTREAM_H_
+#define _NKKSTREAM_H_
+
+#include <stdint.h>
+
+#define NKKstream_Sync0 0xA5
+#define NKKstream_Sync1 0x5A
+#define NKKstream_HeaderLength 8
+#define NKKstream_CRCLength 2
+
+//Flags
+#define NKKstream_Colour 0x01      // set the colour
+#define NKKstream_Brightness 0x02  // set the brightness
+#define NKKstream_PayloadMask 0x30 // payload type
+#define NKKstream_None 0x00        // no payload
+#define NKKstream_Image 0x10       // a full image in NKK native format
+#define NKKstream_Delta 0x20       // a delta from the last frame committed to the key
+
+#define NKKstream_DeltaTooLong 0xFFFF // nkkstream_deltaEncode() result if the delta does not fit
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//CRC-16/CCITT, continues crc (0xFFFF to start)
+uint16_t nkkstream_crc16(uint16_t crc, const uint8_t *data, uint16_t length);
+
+//Writes a packet into dst (NKKstream_HeaderLength + length + NKKstream_CRCLength bytes), returns the packet length
+uint16_t nkkstream_packet(uint8_t *dst, uint8_t key, uint8_t flags, uint8_t colour, uint8_t brightness,
+                          const uint8_t *payload, uint16_t length);
+
+//Encodes the changes from prev to next (length bytes each) into dst (up to capacity bytes) as a delta payload.
+//Returns the delta length, NKKstream_DeltaTooLong if it does not fit (send the full image)
+uint16_t nkkstream_deltaEncode(const uint8_t *prev, const uint8_t *next, uint16_t length, uint8_t *dst, uint16_t capacity);
+
+//Applies a delta payload to frame (length bytes) in place. Returns 0 if the delta is based on a different frame or is corrupted
+//(the frame is not changed), 1 otherwise
+uint8_t nkkstream_deltaDecode(uint8_t *frame, uint16_t length, const uint8_t *delta, uint16_t deltaLength);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _NKKSTREAM_H_